@@ -0,0 +1,532 @@
+// Conway's Game of Life
+// bench.cpp
+//
+// Benchmark of the stepping engines, separate from the game itself so no terminal
+// input or output ends up in the timing. Every engine is run on every board size and
+// seed asked for; each run is stepped until it has taken at least the minimum time,
+// and one record per run is written as CSV or JSON lines, to compare between builds.
+//
+// Usage: LifeBench [-engines LIST] [-isa auto|scalar|sse2|avx2|avx512] [-sizes LIST] [-seeds LIST] [-time SECONDS]
+//                  [-threads N] [-rule RULE] [-patterns DIR] [-format csv|jsonl] [-output FILE] [-label TEXT]
+//      -engines - comma separated, from int, bit, hash, sparse, byte and count (default int,bit,byte,sparse).
+//                 count times countNeighbors alone over the int matrix, without writing any cell.
+//      -isa - the instruction set the byte engine steps with (default auto, the widest the processor has).
+//             Its records name the engine as byte/ISA.
+//      -sizes - comma separated square board sizes (default 25,256,1024,4096,16384).
+//               WIDTHxHEIGHT is also accepted.
+//      -seeds - comma separated, from soup (35% of cells alive), sparse (a 16x16 soup in every
+//               128x128 block), bar and pulsar (the shipped example patterns, repeated across the
+//               board every 25 cells) (default soup,sparse,bar,pulsar)
+//      -time - the least time each run is stepped for (default 0.5)
+//      -threads - the number of threads that step each generation (default 1, 0 = one per core)
+//      -rule - the rule to step with (default B3/S23)
+//      -patterns - the directory holding "Bar Example.txt" and "Pulsar (3-phase).txt" (default .)
+//      -format - csv (default) or jsonl, one JSON object per line
+//      -output - write to FILE instead of standard output
+//      -label - text copied into every record, such as the commit being measured
+//
+// Build: g++ -O2 -pthread bench.cpp grid.cpp intlife.cpp bitlife.cpp bytelife.cpp threadpool.cpp hashlife.cpp
+//            sparselife.cpp simulation.cpp patternio.cpp mappedfile.cpp rule.cpp metrics.cpp
+//            -o LifeBench
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "grid.h"
+#include "intlife.h"
+#include "patternio.h"
+#include "rule.h"
+#include "simulation.h"
+#include "threadpool.h"
+
+#define DEFAULT_ENGINES "int,bit,byte,sparse"
+#define DEFAULT_SIZES "25,256,1024,4096,16384"
+#define DEFAULT_SEEDS "soup,sparse,bar,pulsar"
+#define DEFAULT_SECONDS 0.5
+#define DEFAULT_CACHE_MB 1024
+#define WARMUP_GENERATIONS 2 // Untimed generations first, so every run starts with warm caches
+#define SOUP_PERCENT 35 // Share of cells alive in a soup
+#define SPARSE_BLOCK 128 // The sparse seed puts one patch of soup in every block this size
+#define SPARSE_PATCH 16 // The size of each patch
+#define PATTERN_SIZE 25 // The size of the shipped example patterns
+#define KERNEL_COUNT -1 // The count kernel, in place of an EngineType
+
+// SeedKind
+// Purpose: what the board starts with
+enum SeedKind{
+    SEED_SOUP,
+    SEED_SPARSE,
+    SEED_BAR,
+    SEED_PULSAR
+};
+
+const char *const SEED_NAMES[] = { "soup", "sparse", "bar", "pulsar" };
+const char *const SEED_FILES[] = { nullptr, nullptr, "Bar Example.txt", "Pulsar (3-phase).txt" };
+
+// BenchResult
+// Purpose: the measurements of one run
+struct BenchResult{
+    unsigned long long generations; // Generations timed
+    double seconds; // Time taken by those generations
+    uint64_t population; // Living cells at the end of the run
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// splitList
+// Purpose: split a comma separated list given on the command line
+// Input:
+//      text - the list
+// Output:
+//      Returns the items, empty ones left out.
+std::vector<std::string> splitList(const char *text);
+
+// loadExample
+// Purpose: read one of the shipped example patterns
+// Input:
+//      directory - where the pattern files are
+//      kind - SEED_BAR or SEED_PULSAR
+//      tile - receives the pattern, PATTERN_SIZE cells on each side
+// Output:
+//      Returns false if the file could not be read.
+bool loadExample(const std::string &directory, SeedKind kind, TableType &tile);
+
+// makeSeed
+// Purpose: fill a board with a seed
+// Input:
+//      kind - the seed to make
+//      tiles - the example patterns, indexed by SeedKind; only the one for kind is used
+//      seed - the board to fill; must already have its size
+// Output:
+//      No return type. The random seeds are the same on every run.
+void makeSeed(SeedKind kind, const TableType tiles[], TableType &seed);
+
+// nextRandom
+// Purpose: step a small random number generator (splitmix64), so seeds do not depend on the library
+// Input:
+//      state - the generator state, updated
+// Output:
+//      Returns the next random 64-bit number.
+uint64_t nextRandom(uint64_t &state);
+
+// timeSimulation
+// Purpose: step a simulation for at least the minimum time
+// Input:
+//      sim - the simulation, already seeded
+//      minSeconds - the least time to step for
+// Output:
+//      Returns the measurements; the warm-up generations are not counted.
+BenchResult timeSimulation(Simulation &sim, double minSeconds);
+
+// timeCount
+// Purpose: count the neighbors of every cell of a matrix over and over for at least the minimum time
+// Input:
+//      table - the matrix, with its border already filled
+//      minSeconds - the least time to count for
+// Output:
+//      Returns the measurements, one pass over the matrix counting as a generation.
+BenchResult timeCount(const TableType &table, double minSeconds);
+
+// writeResult
+// Purpose: write the record of one run
+// Input:
+//      output - the file to write to
+//      json - true for a JSON object, false for a CSV line
+//      label, kernel, rule, seed, width, height, threads - what was run
+//      result - the measurements
+// Output:
+//      No return type.
+void writeResult(FILE *output, bool json, const std::string &label, const char *kernel, const std::string &rule,
+                 const char *seed, int width, int height, int threads, const BenchResult &result);
+
+// jsonString
+// Purpose: quote text for a JSON string
+// Input:
+//      text - the text to quote
+// Output:
+//      Returns the text in double quotes, with quotes, backslashes and control characters escaped.
+std::string jsonString(const std::string &text);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+int main(int argc, char* argv[]){
+    const char *engineList = DEFAULT_ENGINES; // The engines to run
+    const char *sizeList = DEFAULT_SIZES; // The board sizes to run
+    const char *seedList = DEFAULT_SEEDS; // The seeds to run
+    double minSeconds = DEFAULT_SECONDS; // The least time each run is stepped for
+    int numThreads = 1; // The number of threads that step each generation
+    LifeRule rule; // The rule to step with
+    std::string patternDirectory = "."; // Where the example patterns are
+    bool json = false; // Write JSON lines instead of CSV
+    const char *outputPath = nullptr; // File the records go to, if not standard output
+    std::string label; // Copied into every record
+    std::vector<int> kernels; // The engines to run, KERNEL_COUNT for the count kernel
+    ByteKernel byteKernel = detectByteKernel(); // The instruction set the byte engine steps with
+    std::vector<int> widths; // The board sizes to run
+    std::vector<int> heights;
+    std::vector<SeedKind> seeds; // The seeds to run
+    TableType tiles[SEED_PULSAR + 1]; // The example patterns
+    FILE *output = stdout; // Where the records go
+    size_t e, z, s;
+
+    makeRule(rule, RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVE);
+
+    for(int i=1; i < argc; i++){
+        if(std::strcmp(argv[i], "-engines") == 0 && i+1 < argc){
+            engineList = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-isa") == 0 && i+1 < argc){
+            i++;
+            if(std::strcmp(argv[i], "auto") != 0 && !parseByteKernel(argv[i], byteKernel)){
+                std::cerr << "ERROR, isa must be auto, scalar, sse2, avx2 or avx512: " << argv[i] << "\n";
+                return 1;
+            }
+            if(!byteKernelSupported(byteKernel)){
+                std::cerr << "ERROR, this processor or build cannot run the " << BYTE_KERNEL_NAMES[byteKernel] << " kernel\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-sizes") == 0 && i+1 < argc){
+            sizeList = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-seeds") == 0 && i+1 < argc){
+            seedList = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-time") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%lf", &minSeconds) != 1 || minSeconds < 0){
+                std::cerr << "ERROR, time must be a number of seconds: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-threads") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%d", &numThreads) != 1 || numThreads < 0){
+                std::cerr << "ERROR, thread count must be 0 or more: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-rule") == 0 && i+1 < argc){
+            i++;
+            if(!parseRule(argv[i], rule)){
+                std::cerr << "ERROR, rule must look like B3/S23: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-patterns") == 0 && i+1 < argc){
+            patternDirectory = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-format") == 0 && i+1 < argc){
+            i++;
+            if(std::strcmp(argv[i], "csv") != 0 && std::strcmp(argv[i], "jsonl") != 0){
+                std::cerr << "ERROR, format must be csv or jsonl: " << argv[i] << "\n";
+                return 1;
+            }
+            json = (std::strcmp(argv[i], "jsonl") == 0);
+        }
+        else if(std::strcmp(argv[i], "-output") == 0 && i+1 < argc){
+            outputPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-label") == 0 && i+1 < argc){
+            label = argv[++i];
+        }
+        else{
+            std::cerr << "Usage: " << argv[0] << " [-engines LIST] [-isa auto|scalar|sse2|avx2|avx512] [-sizes LIST]"
+                      << " [-seeds LIST] [-time SECONDS] [-threads N] [-rule RULE] [-patterns DIR] [-format csv|jsonl] [-output FILE] [-label TEXT]\n";
+            return 1;
+        }
+    }
+
+    std::vector<std::string> names = splitList(engineList);
+    for(e=0; e < names.size(); e++){
+        EngineType engine;
+        if(names[e] == "count"){
+            kernels.push_back(KERNEL_COUNT);
+        }
+        else if(parseEngineType(names[e].c_str(), engine)){
+            if((engine == ENGINE_HASH || engine == ENGINE_SPARSE) && (rule.birth & 1)){
+                std::cerr << "ERROR, the " << ENGINE_NAMES[engine] << " engine does not support B0 rules\n";
+                return 1;
+            }
+            kernels.push_back(engine);
+        }
+        else{
+            std::cerr << "ERROR, unknown engine: " << names[e] << "\n";
+            return 1;
+        }
+    }
+
+    names = splitList(sizeList);
+    for(z=0; z < names.size(); z++){
+        int width;
+        int height;
+        int fields = std::sscanf(names[z].c_str(), "%dx%d", &width, &height);
+        if(fields == 1){
+            height = width;
+        }
+        if(fields < 1 || width < 1 || height < 1){
+            std::cerr << "ERROR, size must look like 1024 or 1024x768: " << names[z] << "\n";
+            return 1;
+        }
+        widths.push_back(width);
+        heights.push_back(height);
+    }
+
+    names = splitList(seedList);
+    for(s=0; s < names.size(); s++){
+        int kind;
+        for(kind=0; kind <= SEED_PULSAR && names[s] != SEED_NAMES[kind]; kind++){
+        }
+        if(kind > SEED_PULSAR){
+            std::cerr << "ERROR, unknown seed: " << names[s] << "\n";
+            return 1;
+        }
+        if(SEED_FILES[kind] != nullptr && !loadExample(patternDirectory, (SeedKind)kind, tiles[kind])){
+            std::cerr << "ERROR, could not read " << patternDirectory << "/" << SEED_FILES[kind] << "\n";
+            return 1;
+        }
+        seeds.push_back((SeedKind)kind);
+    }
+
+    if(outputPath != nullptr){
+        output = std::fopen(outputPath, "w");
+        if(output == nullptr){
+            std::cerr << "ERROR, could not open " << outputPath << " for writing\n";
+            return 1;
+        }
+    }
+    if(!json){
+        std::fprintf(output, "label,engine,rule,seed,width,height,threads,generations,seconds,"
+                             "cells_per_second,ns_per_generation,population\n");
+    }
+
+    ThreadPool pool(numThreads); // Started once, reused by every run
+
+    for(z=0; z < widths.size(); z++){
+        for(s=0; s < seeds.size(); s++){
+            for(e=0; e < kernels.size(); e++){
+                TableType seed; // The starting board, handed to the engine
+                BenchResult result;
+                std::string kernelName = (kernels[e] == KERNEL_COUNT) ? "count" : ENGINE_NAMES[kernels[e]];
+
+                initTable(seed, widths[z], heights[z]);
+                makeSeed(seeds[s], tiles, seed);
+                if(kernels[e] == KERNEL_COUNT){
+                    fillBorder(seed, EDGE_DEAD);
+                    result = timeCount(seed, minSeconds);
+                }
+                else{
+                    Simulation sim; // A fresh simulation for every run, so no run inherits another's caches
+                    initSimulation(sim, (EngineType)kernels[e], EDGE_DEAD, rule, pool, (size_t)DEFAULT_CACHE_MB << 20, seed);
+                    if(kernels[e] == ENGINE_BYTE){
+                        sim.byteKernel = byteKernel;
+                        kernelName = kernelName + "/" + BYTE_KERNEL_NAMES[byteKernel];
+                    }
+                    result = timeSimulation(sim, minSeconds);
+                }
+                writeResult(output, json, label, kernelName.c_str(), ruleName(rule), SEED_NAMES[seeds[s]],
+                            widths[z], heights[z], pool.threadCount(), result);
+                std::fflush(output); // A run that is cut short still leaves every finished record
+            }
+        }
+    }
+
+    if(output != stdout && std::fclose(output) != 0){
+        std::cerr << "ERROR, could not finish writing the output\n";
+        return 1;
+    }
+    return 0;
+}
+
+std::vector<std::string> splitList(const char *text){
+    std::vector<std::string> items;
+    std::string item;
+    const char *p;
+
+    for(p=text; ; p++){
+        if(*p == ',' || *p == '\0'){
+            if(!item.empty()){
+                items.push_back(item);
+            }
+            item.clear();
+            if(*p == '\0'){
+                break;
+            }
+        }
+        else{
+            item += *p;
+        }
+    }
+    return items;
+}
+
+bool loadExample(const std::string &directory, SeedKind kind, TableType &tile){
+    std::string path = directory + "/" + SEED_FILES[kind];
+    Pattern pattern;
+    bool loaded;
+
+    if(!openPattern(path.c_str(), pattern)){
+        return false;
+    }
+    initTable(tile, PATTERN_SIZE, PATTERN_SIZE);
+    loaded = readPattern(pattern, PATTERN_SIZE, PATTERN_SIZE, [&](int x, int y, int length){
+        std::fill(tableRow(tile, y) + x, tableRow(tile, y) + x + length, ALIVE);
+    });
+    closePattern(pattern);
+    return loaded;
+}
+
+void makeSeed(SeedKind kind, const TableType tiles[], TableType &seed){
+    uint64_t state = ((uint64_t)seed.width << 32) ^ (uint64_t)seed.height; // The same seed for the same size
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+
+    for(y=0; y < seed.height; y++){
+        int *row = tableRow(seed, y);
+        for(x=0; x < seed.width; x++){
+            if(kind == SEED_SOUP){
+                row[x] = (nextRandom(state) % 100 < SOUP_PERCENT) ? ALIVE : DEAD;
+            }
+            else if(kind == SEED_SPARSE){
+                // The patch sits in the middle of its block, or of the whole board if it is smaller
+                int blockX = std::min(SPARSE_BLOCK, seed.width);
+                int blockY = std::min(SPARSE_BLOCK, seed.height);
+                int offsetX = x % SPARSE_BLOCK - (blockX - SPARSE_PATCH) / 2;
+                int offsetY = y % SPARSE_BLOCK - (blockY - SPARSE_PATCH) / 2;
+                bool inPatch = offsetX >= 0 && offsetX < SPARSE_PATCH && offsetY >= 0 && offsetY < SPARSE_PATCH;
+                row[x] = (inPatch && nextRandom(state) % 100 < SOUP_PERCENT) ? ALIVE : DEAD;
+            }
+            else{
+                row[x] = tableRow(tiles[kind], y % PATTERN_SIZE)[x % PATTERN_SIZE];
+            }
+        }
+    }
+}
+
+uint64_t nextRandom(uint64_t &state){
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+BenchResult timeSimulation(Simulation &sim, double minSeconds){
+    BenchResult result;
+    unsigned long long batch = 1; // Generations in the next timed batch, doubled each time
+    unsigned long long g; // The generation currently being computed
+
+    advanceSimulation(sim, WARMUP_GENERATIONS);
+
+    // Batches keep the clock out of the loop for the fast runs, while a slow run still
+    // stops soon after the minimum time
+    result.generations = 0;
+    result.seconds = 0;
+    do{
+        auto t_start = std::chrono::high_resolution_clock::now();
+        if(sim.engine == ENGINE_HASH){
+            // Asked for the whole batch at once, the hash engine would jump straight there
+            // and the time would be for the jump rather than for one generation after another
+            for(g=0; g < batch; g++){
+                advanceSimulation(sim, 1);
+            }
+        }
+        else{
+            advanceSimulation(sim, batch);
+        }
+        auto t_end = std::chrono::high_resolution_clock::now();
+        result.seconds += std::chrono::duration<double>(t_end - t_start).count();
+        result.generations += batch;
+        batch *= 2;
+    }while(result.seconds < minSeconds);
+
+    result.population = simulationPopulation(sim);
+    return result;
+}
+
+BenchResult timeCount(const TableType &table, double minSeconds){
+    BenchResult result;
+    unsigned long long batch = 1; // Passes in the next timed batch, doubled each time
+    unsigned long long pass; // The pass currently being made
+    uint64_t total = 0; // Every count added up, so the counting cannot be optimized away
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+
+    result.generations = 0;
+    result.seconds = 0;
+    do{
+        auto t_start = std::chrono::high_resolution_clock::now();
+        for(pass=0; pass < batch; pass++){
+            for(y=0; y < table.height; y++){
+                for(x=0; x < table.width; x++){
+                    total += countNeighbors(table, x, y);
+                }
+            }
+        }
+        auto t_end = std::chrono::high_resolution_clock::now();
+        result.seconds += std::chrono::duration<double>(t_end - t_start).count();
+        result.generations += batch;
+        batch *= 2;
+    }while(result.seconds < minSeconds);
+    volatile uint64_t sink = total;
+    (void)sink;
+
+    result.population = 0;
+    for(y=0; y < table.height; y++){
+        result.population += std::count(tableRow(table, y), tableRow(table, y) + table.width, ALIVE);
+    }
+    return result;
+}
+
+void writeResult(FILE *output, bool json, const std::string &label, const char *kernel, const std::string &rule,
+                 const char *seed, int width, int height, int threads, const BenchResult &result){
+    double cellsPerSecond = (double)width * height * result.generations / result.seconds;
+    double nsPerGeneration = result.seconds * 1e9 / result.generations;
+
+    if(json){
+        std::fprintf(output, "{\"label\":%s,\"engine\":\"%s\",\"rule\":\"%s\",\"seed\":\"%s\",\"width\":%d,\"height\":%d,"
+                             "\"threads\":%d,\"generations\":%llu,\"seconds\":%.6f,\"cells_per_second\":%.6g,"
+                             "\"ns_per_generation\":%.6g,\"population\":%llu}\n",
+                     jsonString(label).c_str(), kernel, rule.c_str(), seed, width, height, threads,
+                     result.generations, result.seconds, cellsPerSecond, nsPerGeneration,
+                     (unsigned long long)result.population);
+    }
+    else{
+        // Labels are free text, so commas would break the columns
+        std::string column = label;
+        std::replace(column.begin(), column.end(), ',', ';');
+        std::fprintf(output, "%s,%s,%s,%s,%d,%d,%d,%llu,%.6f,%.6g,%.6g,%llu\n",
+                     column.c_str(), kernel, rule.c_str(), seed, width, height, threads,
+                     result.generations, result.seconds, cellsPerSecond, nsPerGeneration,
+                     (unsigned long long)result.population);
+    }
+}
+
+std::string jsonString(const std::string &text){
+    std::string quoted = "\"";
+    size_t i;
+
+    for(i=0; i < text.size(); i++){
+        unsigned char c = (unsigned char)text[i];
+        if(c == '"' || c == '\\'){
+            quoted += '\\';
+            quoted += (char)c;
+        }
+        else if(c < 0x20){
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            quoted += escape;
+        }
+        else{
+            quoted += (char)c;
+        }
+    }
+    return quoted + "\"";
+}
@@ -0,0 +1,282 @@
+// Conway's Game of Life
+// bitlife.cpp
+//
+// Bit-packed engine. See bitlife.h for the table layout.
+
+#include "bitlife.h"
+#include <algorithm>
+#include <cstring>
+
+void initBitTable(BitTable &table, int width, int height){
+    int wordsPerLine = CACHE_LINE_BYTES / sizeof(WordType); // Words that fit in one cache line
+
+    table.width = width;
+    table.height = height;
+    table.dataWords = (width + 63) / 64;
+    table.wordsPerRow = (table.dataWords + 2 + wordsPerLine - 1) / wordsPerLine * wordsPerLine;
+    table.lastMask = (width % 64 == 0) ? ~(WordType)0 : (((WordType)1 << (width % 64)) - 1);
+    table.words.assign((size_t)table.wordsPerRow * (height + 2), 0);
+}
+
+int getBitCell(const BitTable &table, int x, int y){
+    const WordType *row = &table.words[(size_t)(y + 1) * table.wordsPerRow];
+    return (int)((row[1 + x / 64] >> (x % 64)) & 1);
+}
+
+void setBitCell(BitTable &table, int x, int y, int alive){
+    WordType *row = &table.words[(size_t)(y + 1) * table.wordsPerRow];
+    WordType bit = (WordType)1 << (x % 64);
+
+    if(alive){
+        row[1 + x / 64] |= bit;
+    }
+    else{
+        row[1 + x / 64] &= ~bit;
+    }
+}
+
+void setBitRun(BitTable &table, int x, int y, int length){
+    WordType *row = &table.words[(size_t)(y + 1) * table.wordsPerRow];
+    int end = x + length; // The cell after the run
+
+    while(x < end){
+        int bit = x % 64; // The first bit of the run in this word
+        int bits = std::min(64 - bit, end - x); // The bits of the run in this word
+        WordType mask = (bits == 64) ? ~(WordType)0 : (((WordType)1 << bits) - 1) << bit;
+        row[1 + x / 64] |= mask;
+        x += bits;
+    }
+}
+
+// The rules that get a kernel of their own, built at compile time; any other rule
+// goes through the kernel that reads its counts from the rule at run time
+#define RULE_HIGHLIFE_BIRTH ((1 << 3) | (1 << 6))
+#define RULE_SEEDS_BIRTH (1 << 2)
+#define RULE_DAY_NIGHT_BIRTH ((1 << 3) | (1 << 6) | (1 << 7) | (1 << 8))
+#define RULE_DAY_NIGHT_SURVIVE ((1 << 3) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 8))
+#define RULE_MAZE_SURVIVE ((1 << 1) | (1 << 2) | (1 << 3) | (1 << 4) | (1 << 5))
+#define RULE_NO_DEATH_SURVIVE 0x1FF
+
+// countTerm
+// Purpose: the cells of a word that have exactly N neighbors and live on because of it. The
+//          count arrives as four bit planes; a count the rule ignores costs nothing once its
+//          masks are known at compile time.
+template<int N, uint16_t BIRTH, uint16_t SURVIVE, bool FIXED>
+static inline WordType countTerm(WordType count0, WordType count1, WordType count2, WordType count3,
+                                 WordType centre, const WordType *birthMasks, const WordType *surviveMasks){
+    const bool born = (BIRTH >> N) & 1;
+    const bool survives = (SURVIVE >> N) & 1;
+    WordType matches = ((N & 1) ? count0 : ~count0) & ((N & 2) ? count1 : ~count1)
+                     & ((N & 4) ? count2 : ~count2) & ((N & 8) ? count3 : ~count3);
+
+    if(!FIXED){
+        return matches & ((birthMasks[N] & ~centre) | (surviveMasks[N] & centre));
+    }
+    if(!born && !survives){
+        return 0;
+    }
+    return matches & (born ? (survives ? ~(WordType)0 : ~centre) : centre);
+}
+
+// stepRowWith
+// Purpose: bitStepRow for one rule. With FIXED set the counts come from BIRTH and SURVIVE, so
+//          the compiler folds every count that does nothing out of the loop; Conway's Life keeps
+//          its own shorter formula. Without FIXED the counts come from rule.
+template<uint16_t BIRTH, uint16_t SURVIVE, bool FIXED>
+static void stepRowWith(const WordType *above, const WordType *middle, const WordType *below,
+                        WordType *out, int dataWords, WordType lastMask, const LifeRule &rule){
+    const bool conway = FIXED && BIRTH == RULE_CONWAY_BIRTH && SURVIVE == RULE_CONWAY_SURVIVE;
+    uint16_t birth = FIXED ? BIRTH : rule.birth;
+    uint16_t survive = FIXED ? SURVIVE : rule.survive;
+    WordType birthMasks[9]; // All ones where a dead cell with n neighbors is born
+    WordType surviveMasks[9]; // All ones where a living cell with n neighbors survives
+    int i; // The word currently being looked at
+    int n; // A neighbor count
+
+    for(n=0; n <= 8; n++){
+        birthMasks[n] = (WordType)0 - ((birth >> n) & 1);
+        surviveMasks[n] = (WordType)0 - ((survive >> n) & 1);
+    }
+
+    // Written without branches so the compiler can run it across SIMD lanes
+    for(i=1; i <= dataWords; i++){
+        // Line up the left (x-1) and right (x+1) neighbors of every bit in the word,
+        // pulling in the bit that crosses over from the word next door
+        WordType aC = above[i];
+        WordType aL = (aC << 1) | (above[i-1] >> 63);
+        WordType aR = (aC >> 1) | (above[i+1] << 63);
+        WordType mC = middle[i];
+        WordType mL = (mC << 1) | (middle[i-1] >> 63);
+        WordType mR = (mC >> 1) | (middle[i+1] << 63);
+        WordType bC = below[i];
+        WordType bL = (bC << 1) | (below[i-1] >> 63);
+        WordType bR = (bC >> 1) | (below[i+1] << 63);
+
+        // Add up each row of three: the row above and below with a full adder,
+        // the middle row (which skips the cell itself) with a half adder
+        WordType aOnes = aL ^ aC ^ aR;
+        WordType aTwos = (aL & aC) | (aR & (aL ^ aC));
+        WordType bOnes = bL ^ bC ^ bR;
+        WordType bTwos = (bL & bC) | (bR & (bL ^ bC));
+        WordType mOnes = mL ^ mR;
+        WordType mTwos = mL & mR;
+
+        // Add the three ones columns; the carry has weight two
+        WordType ones = aOnes ^ bOnes ^ mOnes;
+        WordType onesCarry = (aOnes & bOnes) | (mOnes & (aOnes ^ bOnes));
+
+        // Add three of the four weight-two bits
+        WordType twosParity = aTwos ^ bTwos ^ mTwos;
+        WordType twosCarry = (aTwos & bTwos) | (mTwos & (aTwos ^ bTwos));
+
+        if(conway){
+            // The neighbor count is 2 or 3 exactly when one weight-two bit is set;
+            // 3 neighbors gives birth, 2 neighbors only keeps a living cell alive
+            WordType exactlyOneTwo = (twosParity ^ onesCarry) & ~twosCarry;
+            out[i] = exactlyOneTwo & (ones | mC);
+        }
+        else{
+            // Finish the count as four bit planes, then light every cell whose count the rule keeps
+            WordType count1 = twosParity ^ onesCarry;
+            WordType fours = twosParity & onesCarry;
+            WordType count2 = twosCarry ^ fours;
+            WordType count3 = twosCarry & fours;
+            out[i] = countTerm<0, BIRTH, SURVIVE, FIXED>(ones, count1, count2, count3, mC, birthMasks, surviveMasks)
+                   | countTerm<1, BIRTH, SURVIVE, FIXED>(ones, count1, count2, count3, mC, birthMasks, surviveMasks)
+                   | countTerm<2, BIRTH, SURVIVE, FIXED>(ones, count1, count2, count3, mC, birthMasks, surviveMasks)
+                   | countTerm<3, BIRTH, SURVIVE, FIXED>(ones, count1, count2, count3, mC, birthMasks, surviveMasks)
+                   | countTerm<4, BIRTH, SURVIVE, FIXED>(ones, count1, count2, count3, mC, birthMasks, surviveMasks)
+                   | countTerm<5, BIRTH, SURVIVE, FIXED>(ones, count1, count2, count3, mC, birthMasks, surviveMasks)
+                   | countTerm<6, BIRTH, SURVIVE, FIXED>(ones, count1, count2, count3, mC, birthMasks, surviveMasks)
+                   | countTerm<7, BIRTH, SURVIVE, FIXED>(ones, count1, count2, count3, mC, birthMasks, surviveMasks)
+                   | countTerm<8, BIRTH, SURVIVE, FIXED>(ones, count1, count2, count3, mC, birthMasks, surviveMasks);
+        }
+    }
+
+    // Cells past the right edge of the matrix stay dead
+    out[dataWords] &= lastMask;
+}
+
+BitRowStepper bitRowStepper(const LifeRule &rule){
+    struct Kernel{
+        uint16_t birth;
+        uint16_t survive;
+        BitRowStepper step;
+    };
+    static const Kernel kernels[] = {
+        { RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVE,
+          stepRowWith<RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVE, true> },
+        { RULE_HIGHLIFE_BIRTH, RULE_CONWAY_SURVIVE,
+          stepRowWith<RULE_HIGHLIFE_BIRTH, RULE_CONWAY_SURVIVE, true> },
+        { RULE_SEEDS_BIRTH, 0,
+          stepRowWith<RULE_SEEDS_BIRTH, 0, true> },
+        { RULE_DAY_NIGHT_BIRTH, RULE_DAY_NIGHT_SURVIVE,
+          stepRowWith<RULE_DAY_NIGHT_BIRTH, RULE_DAY_NIGHT_SURVIVE, true> },
+        { RULE_CONWAY_BIRTH, RULE_MAZE_SURVIVE,
+          stepRowWith<RULE_CONWAY_BIRTH, RULE_MAZE_SURVIVE, true> },
+        { RULE_CONWAY_BIRTH, RULE_NO_DEATH_SURVIVE,
+          stepRowWith<RULE_CONWAY_BIRTH, RULE_NO_DEATH_SURVIVE, true> },
+    };
+    size_t k;
+
+    for(k=0; k < sizeof(kernels) / sizeof(kernels[0]); k++){
+        if(kernels[k].birth == rule.birth && kernels[k].survive == rule.survive){
+            return kernels[k].step;
+        }
+    }
+    return stepRowWith<0, 0, false>;
+}
+
+void bitStepRow(const WordType *above, const WordType *middle, const WordType *below,
+                WordType *out, int dataWords, WordType lastMask, const LifeRule &rule){
+    bitRowStepper(rule)(above, middle, below, out, dataWords, lastMask, rule);
+}
+
+void fillBitBorder(BitTable &table, EdgeMode edgeMode){
+    int y; // The row currently being looked at
+    int width = table.width;
+    int height = table.height;
+    int stride = table.wordsPerRow;
+    int rightWord = 1 + width / 64; // The word holding the ghost cell right of the matrix
+    WordType rightBit = (WordType)1 << (width % 64);
+    WordType *words = &table.words[0];
+
+    // Left and right ghost cells first, so the corners come along when the rows are copied
+    for(y=1; y <= height; y++){
+        WordType *row = words + (size_t)y * stride;
+        int leftCell = 0; // The cell that appears just left of x = 0
+        int rightCell = 0; // The cell that appears just right of x = width-1
+        if(edgeMode == EDGE_TORUS){
+            leftCell = (int)((row[1 + (width-1) / 64] >> ((width-1) % 64)) & 1);
+            rightCell = (int)(row[1] & 1);
+        }
+        else if(edgeMode == EDGE_MIRROR){
+            leftCell = (int)(row[1] & 1);
+            rightCell = (int)((row[1 + (width-1) / 64] >> ((width-1) % 64)) & 1);
+        }
+        row[0] = (WordType)leftCell << 63;
+        row[rightWord] = (row[rightWord] & (rightBit - 1)) | (rightCell ? rightBit : 0);
+    }
+
+    // Top and bottom ghost rows
+    if(edgeMode == EDGE_TORUS){
+        std::memcpy(words, words + (size_t)height * stride, stride * sizeof(WordType));
+        std::memcpy(words + (size_t)(height + 1) * stride, words + stride, stride * sizeof(WordType));
+    }
+    else if(edgeMode == EDGE_MIRROR){
+        std::memcpy(words, words + stride, stride * sizeof(WordType));
+        std::memcpy(words + (size_t)(height + 1) * stride, words + (size_t)height * stride, stride * sizeof(WordType));
+    }
+    else{
+        std::memset(words, 0, stride * sizeof(WordType));
+        std::memset(words + (size_t)(height + 1) * stride, 0, stride * sizeof(WordType));
+    }
+}
+
+void bitIterate(const BitTable &frontTable, BitTable &backTable, const LifeRule &rule){
+    bitIterateRows(frontTable, backTable, 0, frontTable.height, rule, nullptr);
+}
+
+void bitIterateRows(const BitTable &frontTable, BitTable &backTable, int firstRow, int endRow, const LifeRule &rule,
+                    StepStats *stats){
+    BitRowStepper step = bitRowStepper(rule); // The kernel for the rule, chosen once for the band
+    int y; // The row currently being looked at
+    int stride = frontTable.wordsPerRow; // Words from one row to the next
+    const WordType *front = &frontTable.words[0];
+    WordType *back = &backTable.words[0];
+
+    for(y=firstRow+1; y <= endRow; y++){
+        step(front + (size_t)(y - 1) * stride, front + (size_t)y * stride, front + (size_t)(y + 1) * stride,
+             back + (size_t)y * stride, frontTable.dataWords, frontTable.lastMask, rule);
+        if(METRICS_ENABLED && stats != nullptr){
+            countWordRow(*stats, front + (size_t)y * stride + 1, back + (size_t)y * stride + 1, frontTable.dataWords, 0, y - 1);
+        }
+    }
+}
+
+void packTable(const TableType &table, BitTable &bitTable){
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+
+    for(y=0; y < table.height; y++){
+        const int *row = tableRow(table, y);
+        for(x=0; x < table.width; x++){
+            setBitCell(bitTable, x, y, row[x] == ALIVE);
+        }
+    }
+}
+
+uint64_t bitPopulation(const BitTable &table){
+    uint64_t population = 0;
+    int y; // The row currently being looked at
+    int i; // The word currently being looked at
+
+    for(y=1; y <= table.height; y++){
+        const WordType *row = &table.words[(size_t)y * table.wordsPerRow];
+        for(i=1; i < table.dataWords; i++){
+            population += countBits(row[i]);
+        }
+        population += countBits(row[table.dataWords] & table.lastMask);
+    }
+    return population;
+}
@@ -0,0 +1,172 @@
+// Conway's Game of Life
+// bitlife.h
+//
+// Bit-packed engine. Each row of the matrix is stored as a run of 64-bit words,
+// one bit per cell, and the next generation is computed a whole word (64 cells)
+// at a time with bitwise full-adder logic instead of counting neighbors cell by cell.
+
+#ifndef BITLIFE_H
+#define BITLIFE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "grid.h"
+#include "metrics.h"
+#include "rule.h"
+
+// WordType
+// Purpose: one machine word of packed cells. Bit n of word i in a row holds cell 64*(i-1)+n.
+typedef uint64_t WordType;
+
+// BitRowStepper
+// Purpose: a kernel that steps one row under one rule; see bitStepRow for the arguments
+typedef void (*BitRowStepper)(const WordType *above, const WordType *middle, const WordType *below,
+                              WordType *out, int dataWords, WordType lastMask, const LifeRule &rule);
+
+// BitTable
+// Purpose: stores a matrix of living and dead cells packed 64 to a word
+// Layout:
+//      Every row starts and ends with a guard word, and the matrix has a ghost row above
+//      and below it. The guard words and ghost rows hold the cells just outside the
+//      matrix, so the stepping loop never has to check whether a neighbor exists.
+//      The ghost cell left of x = 0 is bit 63 of word 0; the one right of x = width-1 is
+//      the bit just past the last cell. Rows are padded out to whole cache lines.
+struct BitTable{
+    int width; // The number of columns in the matrix
+    int height; // The number of rows in the matrix
+    int dataWords; // The number of words holding cells in one row
+    int wordsPerRow; // The number of words from one row to the next, guard words and padding included
+    WordType lastMask; // Mask of the valid bits in the last data word of a row
+    std::vector<WordType, AlignedAllocator<WordType> > words; // (height + 2) rows of wordsPerRow words
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// initBitTable
+// Purpose: size a table and clear every cell to dead
+// Input:
+//      table - the table to set up
+//      width - the number of columns
+//      height - the number of rows
+// Output:
+//      No return type. The function, once completed, leaves an empty table of the requested size.
+void initBitTable(BitTable &table, int width, int height);
+
+// getBitCell
+// Purpose: read a single cell of a bit table
+// Input:
+//      table - the table to read from
+//      x - the x position of the cell
+//      y - the y position of the cell
+// Output:
+//      Returns 1 if the cell is alive, 0 if it is dead.
+int getBitCell(const BitTable &table, int x, int y);
+
+// setBitCell
+// Purpose: write a single cell of a bit table
+// Input:
+//      table - the table to write to
+//      x - the x position of the cell
+//      y - the y position of the cell
+//      alive - nonzero to make the cell alive, zero to kill it
+// Output:
+//      No return type.
+void setBitCell(BitTable &table, int x, int y, int alive);
+
+// setBitRun
+// Purpose: bring a run of cells on one row of a bit table to life, a word at a time
+// Input:
+//      table - the table to write to
+//      x - the x position of the first cell of the run
+//      y - the y position of the row
+//      length - the number of cells in the run; x + length must not pass the width
+// Output:
+//      No return type.
+void setBitRun(BitTable &table, int x, int y, int length);
+
+// fillBitBorder
+// Purpose: refresh the guard bits and ghost rows of a bit table from its edge cells
+// Input:
+//      table - the table whose border is filled
+//      edgeMode - what the border should look like
+// Output:
+//      No return type. The function must be called before every bitIterate.
+void fillBitBorder(BitTable &table, EdgeMode edgeMode);
+
+// bitIterate
+// Purpose: compute the next generation of a bit table
+// Input:
+//      frontTable - the current generation, with its border already filled
+//      backTable - the table that receives the next generation; must have the same size
+//      rule - the rule to apply
+// Output:
+//      No return type. The function, once completed, has written the next generation to backTable.
+void bitIterate(const BitTable &frontTable, BitTable &backTable, const LifeRule &rule);
+
+// bitIterateRows
+// Purpose: compute the next generation of a band of rows of a bit table
+// Input:
+//      frontTable - the current generation, with its border already filled
+//      backTable - the table that receives the next generation; must have the same size
+//      firstRow - the first row of the band
+//      endRow - one past the last row of the band
+//      rule - the rule to apply
+//      stats - counts of the band are added to it, with METRICS_ENABLED; nullptr to count nothing
+// Output:
+//      No return type. Bands that do not overlap may be computed at the same time from different threads.
+void bitIterateRows(const BitTable &frontTable, BitTable &backTable, int firstRow, int endRow, const LifeRule &rule,
+                    StepStats *stats);
+
+// bitStepRow
+// Purpose: compute the next generation of a single row
+// Input:
+//      above - the row above, including its guard words
+//      middle - the row being updated, including its guard words
+//      below - the row below, including its guard words
+//      out - the destination row, including its guard words
+//      dataWords - the number of words between the two guard words
+//      lastMask - mask of the valid bits in the last data word
+//      rule - the rule to apply
+// Output:
+//      No return type. Only the data words of out are written.
+void bitStepRow(const WordType *above, const WordType *middle, const WordType *below,
+                WordType *out, int dataWords, WordType lastMask, const LifeRule &rule);
+
+// bitRowStepper
+// Purpose: choose the row kernel for a rule, so loops over many rows only choose once
+// Input:
+//      rule - the rule to apply
+// Output:
+//      Returns a kernel built for the rule if it is a common one (Conway's Life, HighLife, Seeds,
+//      Day & Night, Maze, Life without Death), or the kernel that reads any rule at run time.
+BitRowStepper bitRowStepper(const LifeRule &rule);
+
+// packTable
+// Purpose: copy a matrix into a bit-packed table for the bit engine
+// Input:
+//      table - the matrix to copy from
+//      bitTable - the bit table to copy into; must already be the same size as the matrix
+// Output:
+//      No return type.
+void packTable(const TableType &table, BitTable &bitTable);
+
+// bitPopulation
+// Purpose: count the living cells of a bit table
+// Input:
+//      table - the table to look at
+// Output:
+//      Returns the number of living cells; the ghost cells are not counted.
+uint64_t bitPopulation(const BitTable &table);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+// countBits
+// Purpose: count the living cells in one word
+inline int countBits(WordType word){
+    return __builtin_popcountll(word);
+}
+
+#endif // BITLIFE_H
@@ -0,0 +1,389 @@
+// Conway's Game of Life
+// bytelife.cpp
+//
+// The byte-per-cell engine and its SIMD kernels. See bytelife.h.
+//
+// Every kernel comes in one version per instruction set, each compiled for that set alone
+// with a target attribute, so the rest of the program still runs on any x86-64 processor.
+// The kernels run a whole number of vectors and so may step a few cells past the end of a
+// row; those land in the ghost cell and slack, which fillByteBorder puts right before the
+// next step.
+
+#include "bytelife.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BYTE_KERNELS_X86 1
+#include <immintrin.h>
+#else
+#define BYTE_KERNELS_X86 0
+#endif
+
+const char *const BYTE_KERNEL_NAMES[] = { "scalar", "sse2", "avx2", "avx512" };
+
+// ByteRuleMasks
+// Purpose: a rule laid out for the vector kernels, which test each neighbor count that matters in turn
+struct ByteRuleMasks{
+    bool conway; // Conway's Life, which needs only two compares
+    int counts; // The number of neighbor counts below
+    uint8_t neighbors[9]; // The neighbor counts at which some cell is alive next generation
+    uint8_t birth[9]; // 0xFF if a dead cell with that count comes to life
+    uint8_t survive[9]; // 0xFF if a living cell with that count stays alive
+};
+
+// ByteRowSums
+// Purpose: a kernel that adds each cell of a row to the cells either side of it
+// Input:
+//      row - the first cell; row[-1] and row[count] are read
+//      sums - receives count sums
+//      count - the number of sums, rounded up by the kernel to a whole number of vectors
+typedef void (*ByteRowSums)(const uint8_t *row, uint8_t *sums, int count);
+
+// ByteRowRule
+// Purpose: a kernel that steps one row of a tile from the sums of it and the rows either side
+// Input:
+//      above, middle, below - the sums of the three rows
+//      cells - the row's cells
+//      out - receives the row's next generation
+//      count - the number of cells, rounded up by the kernel to a whole number of vectors
+//      masks, rule - the rule, in the forms the vector and scalar kernels use
+typedef void (*ByteRowRule)(const uint8_t *above, const uint8_t *middle, const uint8_t *below, const uint8_t *cells,
+                            uint8_t *out, int count, const ByteRuleMasks &masks, const LifeRule &rule);
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// makeRuleMasks
+// Purpose: lay a rule out for the vector kernels
+// Input:
+//      rule - the rule
+//      masks - receives the layout
+// Output:
+//      No return type.
+static void makeRuleMasks(const LifeRule &rule, ByteRuleMasks &masks);
+
+// iterateTiles
+// Purpose: step a band of rows one column tile at a time, with the kernels of one instruction set
+// Input:
+//      frontTable, backTable, firstRow, endRow, rule - as for byteIterateRows
+//      rowSums, rowRule - the kernels
+// Output:
+//      No return type.
+static void iterateTiles(const ByteTable &frontTable, ByteTable &backTable, int firstRow, int endRow,
+                         const LifeRule &rule, ByteRowSums rowSums, ByteRowRule rowRule);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+static void sumRowScalar(const uint8_t *row, uint8_t *sums, int count){
+    for(int i=0; i < count; i++){
+        sums[i] = row[i-1] + row[i] + row[i+1];
+    }
+}
+
+static void ruleRowScalar(const uint8_t *above, const uint8_t *middle, const uint8_t *below, const uint8_t *cells,
+                          uint8_t *out, int count, const ByteRuleMasks &, const LifeRule &rule){
+    for(int i=0; i < count; i++){
+        out[i] = rule.next[cells[i]][above[i] + middle[i] + below[i] - cells[i]];
+    }
+}
+
+#if BYTE_KERNELS_X86
+
+__attribute__((target("sse2")))
+static void sumRowSse2(const uint8_t *row, uint8_t *sums, int count){
+    for(int i=0; i < count; i += 16){
+        __m128i left = _mm_loadu_si128((const __m128i *)(row + i - 1));
+        __m128i center = _mm_loadu_si128((const __m128i *)(row + i));
+        __m128i right = _mm_loadu_si128((const __m128i *)(row + i + 1));
+        _mm_storeu_si128((__m128i *)(sums + i), _mm_add_epi8(_mm_add_epi8(left, center), right));
+    }
+}
+
+__attribute__((target("sse2")))
+static void ruleRowSse2(const uint8_t *above, const uint8_t *middle, const uint8_t *below, const uint8_t *cells,
+                        uint8_t *out, int count, const ByteRuleMasks &masks, const LifeRule &){
+    const __m128i one = _mm_set1_epi8(1);
+    int i;
+
+    if(masks.conway){
+        const __m128i three = _mm_set1_epi8(3);
+        const __m128i four = _mm_set1_epi8(4);
+        for(i=0; i < count; i += 16){
+            // The total counts the cell itself: 3 always lives, 4 lives only if the cell was alive
+            __m128i total = _mm_add_epi8(_mm_add_epi8(_mm_loadu_si128((const __m128i *)(above + i)),
+                                                      _mm_loadu_si128((const __m128i *)(middle + i))),
+                                         _mm_loadu_si128((const __m128i *)(below + i)));
+            __m128i cell = _mm_loadu_si128((const __m128i *)(cells + i));
+            __m128i next = _mm_or_si128(_mm_cmpeq_epi8(total, three),
+                                        _mm_and_si128(_mm_cmpeq_epi8(total, four), _mm_cmpeq_epi8(cell, one)));
+            _mm_storeu_si128((__m128i *)(out + i), _mm_and_si128(next, one));
+        }
+        return;
+    }
+    for(i=0; i < count; i += 16){
+        __m128i cell = _mm_loadu_si128((const __m128i *)(cells + i));
+        __m128i neighbors = _mm_sub_epi8(_mm_add_epi8(_mm_add_epi8(_mm_loadu_si128((const __m128i *)(above + i)),
+                                                                   _mm_loadu_si128((const __m128i *)(middle + i))),
+                                                      _mm_loadu_si128((const __m128i *)(below + i))), cell);
+        __m128i alive = _mm_cmpeq_epi8(cell, one);
+        __m128i next = _mm_setzero_si128();
+        for(int k=0; k < masks.counts; k++){
+            __m128i lives = _mm_or_si128(_mm_and_si128(alive, _mm_set1_epi8((char)masks.survive[k])),
+                                         _mm_andnot_si128(alive, _mm_set1_epi8((char)masks.birth[k])));
+            next = _mm_or_si128(next, _mm_and_si128(_mm_cmpeq_epi8(neighbors, _mm_set1_epi8((char)masks.neighbors[k])), lives));
+        }
+        _mm_storeu_si128((__m128i *)(out + i), _mm_and_si128(next, one));
+    }
+}
+
+__attribute__((target("avx2")))
+static void sumRowAvx2(const uint8_t *row, uint8_t *sums, int count){
+    for(int i=0; i < count; i += 32){
+        __m256i left = _mm256_loadu_si256((const __m256i *)(row + i - 1));
+        __m256i center = _mm256_loadu_si256((const __m256i *)(row + i));
+        __m256i right = _mm256_loadu_si256((const __m256i *)(row + i + 1));
+        _mm256_storeu_si256((__m256i *)(sums + i), _mm256_add_epi8(_mm256_add_epi8(left, center), right));
+    }
+}
+
+__attribute__((target("avx2")))
+static void ruleRowAvx2(const uint8_t *above, const uint8_t *middle, const uint8_t *below, const uint8_t *cells,
+                        uint8_t *out, int count, const ByteRuleMasks &masks, const LifeRule &){
+    const __m256i one = _mm256_set1_epi8(1);
+    int i;
+
+    if(masks.conway){
+        const __m256i three = _mm256_set1_epi8(3);
+        const __m256i four = _mm256_set1_epi8(4);
+        for(i=0; i < count; i += 32){
+            __m256i total = _mm256_add_epi8(_mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(above + i)),
+                                                            _mm256_loadu_si256((const __m256i *)(middle + i))),
+                                            _mm256_loadu_si256((const __m256i *)(below + i)));
+            __m256i cell = _mm256_loadu_si256((const __m256i *)(cells + i));
+            __m256i next = _mm256_or_si256(_mm256_cmpeq_epi8(total, three),
+                                           _mm256_and_si256(_mm256_cmpeq_epi8(total, four), _mm256_cmpeq_epi8(cell, one)));
+            _mm256_storeu_si256((__m256i *)(out + i), _mm256_and_si256(next, one));
+        }
+        return;
+    }
+    for(i=0; i < count; i += 32){
+        __m256i cell = _mm256_loadu_si256((const __m256i *)(cells + i));
+        __m256i neighbors = _mm256_sub_epi8(_mm256_add_epi8(_mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(above + i)),
+                                                                            _mm256_loadu_si256((const __m256i *)(middle + i))),
+                                                            _mm256_loadu_si256((const __m256i *)(below + i))), cell);
+        __m256i alive = _mm256_cmpeq_epi8(cell, one);
+        __m256i next = _mm256_setzero_si256();
+        for(int k=0; k < masks.counts; k++){
+            __m256i lives = _mm256_or_si256(_mm256_and_si256(alive, _mm256_set1_epi8((char)masks.survive[k])),
+                                            _mm256_andnot_si256(alive, _mm256_set1_epi8((char)masks.birth[k])));
+            next = _mm256_or_si256(next, _mm256_and_si256(_mm256_cmpeq_epi8(neighbors, _mm256_set1_epi8((char)masks.neighbors[k])),
+                                                          lives));
+        }
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_and_si256(next, one));
+    }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void sumRowAvx512(const uint8_t *row, uint8_t *sums, int count){
+    for(int i=0; i < count; i += 64){
+        __m512i left = _mm512_loadu_si512((const void *)(row + i - 1));
+        __m512i center = _mm512_loadu_si512((const void *)(row + i));
+        __m512i right = _mm512_loadu_si512((const void *)(row + i + 1));
+        _mm512_storeu_si512((void *)(sums + i), _mm512_add_epi8(_mm512_add_epi8(left, center), right));
+    }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void ruleRowAvx512(const uint8_t *above, const uint8_t *middle, const uint8_t *below, const uint8_t *cells,
+                          uint8_t *out, int count, const ByteRuleMasks &masks, const LifeRule &){
+    const __m512i one = _mm512_set1_epi8(1);
+    int i;
+
+    if(masks.conway){
+        const __m512i three = _mm512_set1_epi8(3);
+        const __m512i four = _mm512_set1_epi8(4);
+        for(i=0; i < count; i += 64){
+            __m512i total = _mm512_add_epi8(_mm512_add_epi8(_mm512_loadu_si512((const void *)(above + i)),
+                                                            _mm512_loadu_si512((const void *)(middle + i))),
+                                            _mm512_loadu_si512((const void *)(below + i)));
+            __m512i cell = _mm512_loadu_si512((const void *)(cells + i));
+            __mmask64 next = _mm512_cmpeq_epi8_mask(total, three)
+                           | (_mm512_cmpeq_epi8_mask(total, four) & _mm512_cmpeq_epi8_mask(cell, one));
+            _mm512_storeu_si512((void *)(out + i), _mm512_maskz_mov_epi8(next, one));
+        }
+        return;
+    }
+    for(i=0; i < count; i += 64){
+        __m512i cell = _mm512_loadu_si512((const void *)(cells + i));
+        __m512i neighbors = _mm512_sub_epi8(_mm512_add_epi8(_mm512_add_epi8(_mm512_loadu_si512((const void *)(above + i)),
+                                                                            _mm512_loadu_si512((const void *)(middle + i))),
+                                                            _mm512_loadu_si512((const void *)(below + i))), cell);
+        __mmask64 alive = _mm512_cmpeq_epi8_mask(cell, one);
+        __mmask64 next = 0;
+        for(int k=0; k < masks.counts; k++){
+            __mmask64 lives = (alive & (masks.survive[k] ? ~(__mmask64)0 : 0)) | (~alive & (masks.birth[k] ? ~(__mmask64)0 : 0));
+            next |= _mm512_cmpeq_epi8_mask(neighbors, _mm512_set1_epi8((char)masks.neighbors[k])) & lives;
+        }
+        _mm512_storeu_si512((void *)(out + i), _mm512_maskz_mov_epi8(next, one));
+    }
+}
+
+#endif // BYTE_KERNELS_X86
+
+
+void initByteTable(ByteTable &table, int width, int height){
+    table.width = width;
+    table.height = height;
+    table.stride = BYTE_ROW_MARGIN + (width + 1 + BYTE_ROW_SLACK + CACHE_LINE_BYTES - 1) / CACHE_LINE_BYTES * CACHE_LINE_BYTES;
+    table.cells.assign((std::size_t)table.stride * (height + 2), 0);
+}
+
+void fillByteBorder(ByteTable &table, EdgeMode edgeMode){
+    int y; // The row currently being looked at
+    int width = table.width;
+    int height = table.height;
+    std::size_t rowBytes = (std::size_t)width + 2; // One row with both ghost cells
+
+    // Left and right ghost columns first, so the corners come along when the rows are copied
+    for(y=0; y < height; y++){
+        uint8_t *row = byteRow(table, y);
+        if(edgeMode == EDGE_TORUS){
+            row[-1] = row[width-1];
+            row[width] = row[0];
+        }
+        else if(edgeMode == EDGE_MIRROR){
+            row[-1] = row[0];
+            row[width] = row[width-1];
+        }
+        else{
+            row[-1] = 0;
+            row[width] = 0;
+        }
+    }
+
+    // Top and bottom ghost rows
+    if(edgeMode == EDGE_TORUS){
+        std::memcpy(byteRow(table, -1) - 1, byteRow(table, height-1) - 1, rowBytes);
+        std::memcpy(byteRow(table, height) - 1, byteRow(table, 0) - 1, rowBytes);
+    }
+    else if(edgeMode == EDGE_MIRROR){
+        std::memcpy(byteRow(table, -1) - 1, byteRow(table, 0) - 1, rowBytes);
+        std::memcpy(byteRow(table, height) - 1, byteRow(table, height-1) - 1, rowBytes);
+    }
+    else{
+        std::memset(byteRow(table, -1) - 1, 0, rowBytes);
+        std::memset(byteRow(table, height) - 1, 0, rowBytes);
+    }
+}
+
+void byteIterateRows(const ByteTable &frontTable, ByteTable &backTable, int firstRow, int endRow, const LifeRule &rule,
+                     ByteKernel kernel, StepStats *stats){
+    ByteRowSums rowSums = sumRowScalar; // The kernels of the instruction set asked for
+    ByteRowRule rowRule = ruleRowScalar;
+    int y; // The row currently being looked at
+
+#if BYTE_KERNELS_X86
+    if(kernel == BYTE_KERNEL_SSE2){
+        rowSums = sumRowSse2;
+        rowRule = ruleRowSse2;
+    }
+    else if(kernel == BYTE_KERNEL_AVX2){
+        rowSums = sumRowAvx2;
+        rowRule = ruleRowAvx2;
+    }
+    else if(kernel == BYTE_KERNEL_AVX512){
+        rowSums = sumRowAvx512;
+        rowRule = ruleRowAvx512;
+    }
+#else
+    (void)kernel;
+#endif
+    iterateTiles(frontTable, backTable, firstRow, endRow, rule, rowSums, rowRule);
+
+    if(METRICS_ENABLED && stats != nullptr){
+        for(y=firstRow; y < endRow; y++){
+            countCellRow(*stats, byteRow(frontTable, y), byteRow(backTable, y), frontTable.width, y);
+        }
+    }
+}
+
+static void iterateTiles(const ByteTable &frontTable, ByteTable &backTable, int firstRow, int endRow,
+                         const LifeRule &rule, ByteRowSums rowSums, ByteRowRule rowRule){
+    alignas(CACHE_LINE_BYTES) uint8_t sums[3][BYTE_TILE_CELLS + BYTE_ROW_SLACK]; // The sums of the last three rows, in turn
+    ByteRuleMasks masks; // The rule, for the vector kernels
+    int left; // The first column of the tile
+    int y; // The row currently being looked at
+
+    makeRuleMasks(rule, masks);
+    for(left=0; left < frontTable.width; left += BYTE_TILE_CELLS){
+        int count = std::min(BYTE_TILE_CELLS, frontTable.width - left); // Columns in this tile
+
+        // Each row's sums are worked out once, then slide from below to the middle to above
+        rowSums(byteRow(frontTable, firstRow - 1) + left, sums[0], count);
+        rowSums(byteRow(frontTable, firstRow) + left, sums[1], count);
+        for(y=firstRow; y < endRow; y++){
+            const uint8_t *above = sums[(y - firstRow) % 3];
+            const uint8_t *middle = sums[(y - firstRow + 1) % 3];
+            uint8_t *below = sums[(y - firstRow + 2) % 3];
+            rowSums(byteRow(frontTable, y + 1) + left, below, count);
+            rowRule(above, middle, below, byteRow(frontTable, y) + left, byteRow(backTable, y) + left, count, masks, rule);
+        }
+    }
+}
+
+static void makeRuleMasks(const LifeRule &rule, ByteRuleMasks &masks){
+    masks.conway = isConwayRule(rule);
+    masks.counts = 0;
+    for(int n=0; n <= 8; n++){
+        if(rule.next[0][n] || rule.next[1][n]){
+            masks.neighbors[masks.counts] = (uint8_t)n;
+            masks.birth[masks.counts] = rule.next[0][n] ? 0xFF : 0;
+            masks.survive[masks.counts] = rule.next[1][n] ? 0xFF : 0;
+            masks.counts++;
+        }
+    }
+}
+
+ByteKernel detectByteKernel(){
+    if(byteKernelSupported(BYTE_KERNEL_AVX512)){
+        return BYTE_KERNEL_AVX512;
+    }
+    if(byteKernelSupported(BYTE_KERNEL_AVX2)){
+        return BYTE_KERNEL_AVX2;
+    }
+    if(byteKernelSupported(BYTE_KERNEL_SSE2)){
+        return BYTE_KERNEL_SSE2;
+    }
+    return BYTE_KERNEL_SCALAR;
+}
+
+bool byteKernelSupported(ByteKernel kernel){
+#if BYTE_KERNELS_X86
+    // __builtin_cpu_supports reads CPUID, and for AVX also checks that the system saves the wider registers
+    __builtin_cpu_init();
+    if(kernel == BYTE_KERNEL_SSE2){
+        return __builtin_cpu_supports("sse2");
+    }
+    if(kernel == BYTE_KERNEL_AVX2){
+        return __builtin_cpu_supports("avx2");
+    }
+    if(kernel == BYTE_KERNEL_AVX512){
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    }
+#endif
+    return kernel == BYTE_KERNEL_SCALAR;
+}
+
+bool parseByteKernel(const char *name, ByteKernel &kernel){
+    int i;
+
+    for(i=0; i <= BYTE_KERNEL_AVX512; i++){
+        if(std::strcmp(name, BYTE_KERNEL_NAMES[i]) == 0){
+            kernel = (ByteKernel)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,134 @@
+// Conway's Game of Life
+// bytelife.h
+//
+// Byte engine: one byte per cell on a padded matrix with a ghost border, stepped with
+// SIMD code chosen for the processor when the program starts. Each row's horizontal
+// sums (the cell and the cells either side of it) are worked out once and shared by the
+// rows above and below it, so a neighbor count costs three adds. The rows of a band are
+// walked in column tiles that keep the sums of the last three rows in cache.
+
+#ifndef BYTELIFE_H
+#define BYTELIFE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "grid.h"
+#include "metrics.h"
+#include "rule.h"
+
+#define BYTE_ROW_MARGIN 64 // Bytes in front of cell 0 of each row, the left ghost cell included, so rows start aligned
+#define BYTE_ROW_SLACK 64 // Bytes after the right ghost cell that a vector may run into at the end of a row
+#define BYTE_TILE_CELLS 4096 // Columns stepped together down a band, sized so three rows of sums stay in L1
+
+// ByteKernel
+// Purpose: the instruction set the byte engine is stepped with
+//      BYTE_KERNEL_SCALAR - plain C++, one cell at a time
+//      BYTE_KERNEL_SSE2 - 16 cells at a time
+//      BYTE_KERNEL_AVX2 - 32 cells at a time
+//      BYTE_KERNEL_AVX512 - 64 cells at a time, with AVX-512BW
+enum ByteKernel{
+    BYTE_KERNEL_SCALAR,
+    BYTE_KERNEL_SSE2,
+    BYTE_KERNEL_AVX2,
+    BYTE_KERNEL_AVX512
+};
+
+extern const char *const BYTE_KERNEL_NAMES[];
+
+// ByteTable
+// Purpose: stores a matrix of living and dead cells, one byte (1 or 0) per cell
+// Layout:
+//      Row-major, with a ghost row above and below the matrix and a ghost cell at each end
+//      of every row. Cell 0 of each row sits BYTE_ROW_MARGIN bytes into the row, so it is
+//      aligned for vector loads and stores, and every row has BYTE_ROW_SLACK spare bytes
+//      at its end so the last vector of a row never reaches the next one.
+struct ByteTable{
+    int width; // The number of columns in the matrix
+    int height; // The number of rows in the matrix
+    int stride; // The number of bytes from one row to the next, margin, ghost cells and slack included
+    std::vector<uint8_t, AlignedAllocator<uint8_t> > cells; // (height + 2) rows of stride bytes
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// initByteTable
+// Purpose: size a byte matrix and clear every cell, ghost border included, to dead
+// Input:
+//      table - the matrix to set up
+//      width - the number of columns
+//      height - the number of rows
+// Output:
+//      No return type.
+void initByteTable(ByteTable &table, int width, int height);
+
+// fillByteBorder
+// Purpose: refresh the ghost border of a byte matrix from its edge cells
+// Input:
+//      table - the matrix whose border is filled
+//      edgeMode - what the border should look like
+// Output:
+//      No return type. The function must be called before every byteIterateRows.
+void fillByteBorder(ByteTable &table, EdgeMode edgeMode);
+
+// byteIterateRows
+// Purpose: compute the next generation of a band of rows of a byte matrix
+// Input:
+//      frontTable - the current generation, with its border already filled
+//      backTable - the matrix that receives the next generation; must have the same size
+//      firstRow - the first row of the band
+//      endRow - one past the last row of the band
+//      rule - the rule to apply
+//      kernel - the instruction set to step with; must be one byteKernelSupported allows
+//      stats - counts of the band are added to it, with METRICS_ENABLED; nullptr to count nothing
+// Output:
+//      No return type. Bands that do not overlap may be computed at the same time from different threads.
+//      Every kernel gives exactly the same cells as the int engine.
+void byteIterateRows(const ByteTable &frontTable, ByteTable &backTable, int firstRow, int endRow, const LifeRule &rule,
+                     ByteKernel kernel, StepStats *stats);
+
+// detectByteKernel
+// Purpose: find the widest instruction set this processor can run the byte engine with
+// Input:
+//      None.
+// Output:
+//      Returns the kernel, from what CPUID reports.
+ByteKernel detectByteKernel();
+
+// byteKernelSupported
+// Purpose: check whether this build and this processor can run a kernel
+// Input:
+//      kernel - the kernel to check
+// Output:
+//      Returns true if the kernel can be used.
+bool byteKernelSupported(ByteKernel kernel);
+
+// parseByteKernel
+// Purpose: turn a kernel name given on the command line into a ByteKernel
+// Input:
+//      name - "scalar", "sse2", "avx2" or "avx512"
+//      kernel - receives the parsed kernel
+// Output:
+//      Returns true if the name was recognized.
+bool parseByteKernel(const char *name, ByteKernel &kernel);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+// byteRow
+// Purpose: find the first cell of a row of a byte matrix
+// Input:
+//      table - the matrix
+//      y - the row; -1 and height are the ghost rows
+// Output:
+//      Returns a pointer to cell (0, y). Index -1 and width are the ghost cells.
+inline uint8_t *byteRow(ByteTable &table, int y){
+    return &table.cells[(std::size_t)(y + 1) * table.stride + BYTE_ROW_MARGIN];
+}
+
+inline const uint8_t *byteRow(const ByteTable &table, int y){
+    return &table.cells[(std::size_t)(y + 1) * table.stride + BYTE_ROW_MARGIN];
+}
+
+#endif // BYTELIFE_H
@@ -0,0 +1,178 @@
+// Conway's Game of Life
+// checkpoint.cpp
+//
+// Writing checkpoints in the background and resuming from them. See checkpoint.h.
+
+#include "checkpoint.h"
+#include <cstdio>
+#include <cstring>
+
+static_assert(sizeof(CheckpointHeader) == 64, "the checkpoint header is written as it is laid out in memory");
+
+CheckpointWriter::CheckpointWriter() : pending(false), stopping(false), failed(false){
+    writer = std::thread(&CheckpointWriter::writerLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter(){
+    {
+        std::unique_lock<std::mutex> hold(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+}
+
+bool CheckpointWriter::submit(const Simulation &sim, const std::string &path){
+    {
+        std::unique_lock<std::mutex> hold(lock);
+        if(pending){
+            return false;
+        }
+    }
+
+    // The writer only touches the image while pending is set, so it can be filled without the lock
+    captureCheckpoint(sim, image);
+    imagePath = path;
+    {
+        std::unique_lock<std::mutex> hold(lock);
+        pending = true;
+    }
+    wake.notify_one();
+    return true;
+}
+
+bool CheckpointWriter::finish(){
+    std::unique_lock<std::mutex> hold(lock);
+    idle.wait(hold, [this]{ return !pending; });
+    return !failed;
+}
+
+void CheckpointWriter::writerLoop(){
+    std::unique_lock<std::mutex> hold(lock);
+
+    for(;;){
+        wake.wait(hold, [this]{ return pending || stopping; });
+        if(pending){
+            hold.unlock();
+            bool written = writeCheckpoint(imagePath, image); // Whether the file was written
+            hold.lock();
+            failed = failed || !written;
+            pending = false;
+            idle.notify_all();
+        }
+        else{
+            return;
+        }
+    }
+}
+
+void captureCheckpoint(const Simulation &sim, CheckpointImage &image){
+    CheckpointHeader &header = image.header;
+
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.byteOrder = CHECKPOINT_BYTE_ORDER;
+    header.width = (uint32_t)sim.width;
+    header.height = (uint32_t)sim.height;
+    header.rowWords = (uint32_t)((sim.width + 63) / 64);
+    header.birth = sim.rule.birth;
+    header.survive = sim.rule.survive;
+    header.edgeMode = (uint32_t)sim.edgeMode;
+    header.generation = sim.generation;
+
+    // For the int, bit and byte engines a snapshot is exactly the packed rows a checkpoint holds
+    snapshotSimulation(sim, image.words);
+}
+
+bool writeCheckpoint(const std::string &path, CheckpointImage &image){
+    std::string temporary = path + ".tmp"; // Written first, so a failed write never replaces a good checkpoint
+    FILE *output;
+    bool written;
+
+    image.header.checksum = checkpointChecksum(image.words.data(), image.words.size());
+
+    output = std::fopen(temporary.c_str(), "wb");
+    if(output == nullptr){
+        return false;
+    }
+    written = std::fwrite(&image.header, sizeof(image.header), 1, output) == 1;
+    if(written && !image.words.empty()){
+        written = std::fwrite(image.words.data(), sizeof(uint64_t), image.words.size(), output) == image.words.size();
+    }
+    written = (std::fclose(output) == 0) && written;
+    if(!written){
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    std::remove(path.c_str()); // rename will not replace a file here
+#endif
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool openCheckpoint(const char *path, MappedFile &file, CheckpointHeader &header, std::string &error){
+    uint64_t expected; // The size the header says the file should be
+
+    if(!mapFile(path, file)){
+        error = "could not open the checkpoint";
+        return false;
+    }
+    if(file.size < sizeof(header)){
+        error = "the file is too short to be a checkpoint";
+        unmapFile(file);
+        return false;
+    }
+    std::memcpy(&header, file.data, sizeof(header));
+
+    if(std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0){
+        error = "the file is not a checkpoint";
+    }
+    else if(header.byteOrder != CHECKPOINT_BYTE_ORDER){
+        error = "the checkpoint was written on a machine with a different byte order";
+    }
+    else if(header.version != CHECKPOINT_VERSION){
+        error = "the checkpoint was written by a different version";
+    }
+    else if(header.width == 0 || header.height == 0 || header.width > 0x7FFFFFFF || header.height > 0x7FFFFFFF
+            || header.rowWords != (header.width + 63) / 64 || header.edgeMode > EDGE_MIRROR){
+        error = "the checkpoint header is damaged";
+    }
+    else{
+        expected = sizeof(header) + (uint64_t)header.height * header.rowWords * sizeof(uint64_t);
+        if(file.size != expected){
+            error = "the checkpoint is not the size its header says";
+        }
+        else{
+            return true;
+        }
+    }
+    unmapFile(file);
+    return false;
+}
+
+bool resumeCheckpoint(Simulation &sim, EngineType engine, EdgeMode edgeMode, const LifeRule &rule, ThreadPool &pool,
+                      const MappedFile &file, const CheckpointHeader &header){
+    const uint64_t *words = (const uint64_t *)(file.data + sizeof(header)); // The header keeps these 8-byte aligned
+    size_t count = (size_t)header.height * header.rowWords; // The number of cell words
+
+    if(checkpointChecksum(words, count) != header.checksum){
+        return false;
+    }
+    restoreSimulation(sim, engine, edgeMode, rule, pool, (int)header.width, (int)header.height, words,
+                      header.generation);
+    return true;
+}
+
+uint64_t checkpointChecksum(const uint64_t *words, size_t count){
+    uint64_t sum = 0; // The words added up
+    uint64_t sumOfSums = 0; // The running sums added up, which depends on the order of the words
+    size_t i;
+
+    for(i=0; i < count; i++){
+        sum += words[i];
+        sumOfSums += sum;
+    }
+    return sum ^ (sumOfSums * 0x9E3779B97F4A7C15ull);
+}
@@ -0,0 +1,159 @@
+// Conway's Game of Life
+// checkpoint.h
+//
+// Binary checkpoints, so a long run can be stopped and picked up again. A checkpoint is a
+// fixed 64-byte header (size, rule, edge mode, generation and a checksum) followed by the
+// cells packed 64 to a word, each row starting on a new word: the same layout as the data
+// words of the bit engine, so resuming maps the file and copies rows straight into the
+// engine with nothing to parse.
+//
+// Checkpoints are written by a thread of their own. The stepper only copies the current
+// generation aside, which takes a fraction of a step, and carries on while the copy is
+// checksummed and written. Each checkpoint goes to a temporary file that is renamed over
+// the last one once it is complete, so a run killed part way through a write still leaves
+// the previous checkpoint intact.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mappedfile.h"
+#include "simulation.h"
+
+#define CHECKPOINT_MAGIC "LIFECKPT" // The first eight bytes of every checkpoint
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_BYTE_ORDER 0x01020304u // Written in the machine's byte order, to spot files from another
+
+// CheckpointHeader
+// Purpose: the start of a checkpoint file, written as it is laid out in memory
+struct CheckpointHeader{
+    char magic[8]; // CHECKPOINT_MAGIC, without its terminating zero
+    uint32_t version; // CHECKPOINT_VERSION
+    uint32_t byteOrder; // CHECKPOINT_BYTE_ORDER
+    uint32_t width; // The number of columns on the board
+    uint32_t height; // The number of rows on the board
+    uint32_t rowWords; // Words per row, (width + 63) / 64
+    uint16_t birth; // The rule, as in LifeRule
+    uint16_t survive;
+    uint32_t edgeMode; // The EdgeMode of the run
+    uint32_t reserved; // Zero
+    uint64_t generation; // The generation the cells belong to
+    uint64_t checksum; // checkpointChecksum of the cell words
+    uint8_t padding[8]; // Zero; rounds the header up to 64 bytes
+};
+
+// CheckpointImage
+// Purpose: a checkpoint held in memory, ready to be written
+struct CheckpointImage{
+    CheckpointHeader header; // The header; the checksum is filled in when the image is written
+    std::vector<uint64_t> words; // height * rowWords words of cells
+};
+
+class CheckpointWriter{
+public:
+    // CheckpointWriter
+    // Purpose: start the writer thread
+    CheckpointWriter();
+
+    // ~CheckpointWriter
+    // Purpose: finish the checkpoint being written, if any, and stop the thread
+    ~CheckpointWriter();
+
+    // submit
+    // Purpose: copy the current generation aside and have it written in the background
+    // Input:
+    //      sim - the simulation to checkpoint; the int, bit and byte engines only
+    //      path - the file to write
+    // Output:
+    //      Returns false, without copying anything, if the last checkpoint is still being written;
+    //      the caller carries on and tries again later rather than waiting for the disk.
+    bool submit(const Simulation &sim, const std::string &path);
+
+    // finish
+    // Purpose: wait for the checkpoint being written, if any
+    // Input:
+    //      None.
+    // Output:
+    //      Returns false if any checkpoint so far could not be written.
+    bool finish();
+
+private:
+    CheckpointWriter(const CheckpointWriter &);
+    CheckpointWriter &operator=(const CheckpointWriter &);
+
+    void writerLoop();
+
+    CheckpointImage image; // The generation waiting to be written, or being written
+    std::string imagePath; // Where it goes
+    std::thread writer; // Writes the image
+    std::mutex lock; // Guards pending, stopping and failed
+    std::condition_variable wake; // Signalled when an image is submitted or the writer is stopped
+    std::condition_variable idle; // Signalled when an image has been written
+    bool pending; // Whether the image is waiting or being written
+    bool stopping; // Set when the writer is shutting down
+    bool failed; // Set when a write fails
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// captureCheckpoint
+// Purpose: copy the current generation of a simulation into a checkpoint image
+// Input:
+//      sim - the simulation to copy; the int, bit and byte engines only
+//      image - receives the header and cells; its checksum is left for writeCheckpoint
+// Output:
+//      No return type.
+void captureCheckpoint(const Simulation &sim, CheckpointImage &image);
+
+// writeCheckpoint
+// Purpose: checksum an image and write it to a file, replacing the file only once it is complete
+// Input:
+//      path - the file to write; path + ".tmp" is used while writing
+//      image - the image to write; its checksum is filled in
+// Output:
+//      Returns false if the file could not be written.
+bool writeCheckpoint(const std::string &path, CheckpointImage &image);
+
+// openCheckpoint
+// Purpose: map a checkpoint file and check its header
+// Input:
+//      path - the file to open
+//      file - receives the view of the file
+//      header - receives the header
+// Output:
+//      Returns false, with an explanation in error, if the file is not a whole checkpoint
+//      written by this version on a machine with the same byte order.
+bool openCheckpoint(const char *path, MappedFile &file, CheckpointHeader &header, std::string &error);
+
+// resumeCheckpoint
+// Purpose: start a simulation from an open checkpoint
+// Input:
+//      sim - the simulation to set up
+//      engine - ENGINE_INT, ENGINE_BIT or ENGINE_BYTE
+//      edgeMode, rule - the edge mode and rule to run with; usually the ones in the header
+//      pool - the threads that share each generation
+//      file - the mapped checkpoint
+//      header - its header, from openCheckpoint
+// Output:
+//      Returns false if the cells do not match the checksum.
+bool resumeCheckpoint(Simulation &sim, EngineType engine, EdgeMode edgeMode, const LifeRule &rule, ThreadPool &pool,
+                      const MappedFile &file, const CheckpointHeader &header);
+
+// checkpointChecksum
+// Purpose: a Fletcher-style sum over the cell words, which also notices words that are swapped around
+// Input:
+//      words - the first word
+//      count - the number of words
+// Output:
+//      Returns the checksum.
+uint64_t checkpointChecksum(const uint64_t *words, size_t count);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // CHECKPOINT_H
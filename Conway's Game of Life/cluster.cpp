@@ -0,0 +1,176 @@
+// Conway's Game of Life
+// cluster.cpp
+//
+// Runs one board across several worker processes, each holding only its own band of rows,
+// for boards too big for one process (see distributed.h). The output is the same as a
+// GameOfLife batch run of the bit engine on the same seed, so the two can be compared
+// directly.
+//
+// Usage: LifeCluster -seed FILE [-workers N] [-transport shm|socket] [-size WIDTHxHEIGHT] [-edge dead|torus|mirror]
+//                    [-rule RULE] [-batch N] [-every K] [-output FILE] [-population]
+//      -seed - the 0/1 grid, RLE or Life 1.06 file the board starts from. Without -size an RLE file
+//              sets the size of the board from its header.
+//      -workers - the number of worker processes (default 2)
+//      -transport shm - the workers pass rows through ring buffers in shared memory (default)
+//      -transport socket - the workers pass rows through Unix domain sockets
+//      -size - the size of the board (default 25x25)
+//      -edge - how cells on the edge of the board see past it (default dead)
+//      -rule - the rule to run (default B3/S23, or the rule in the header of an RLE seed)
+//      -batch - the number of generations to run before the final board is written (default 1), as
+//               for GameOfLife; -generations is accepted for it too
+//      -every - also write the board every K generations (default 0, final board only)
+//      -output - write to FILE instead of standard output
+//      -population - write "generation population" lines instead of whole boards
+//
+// POSIX only.
+//
+// Build: g++ -O2 -pthread cluster.cpp distributed.cpp transport.cpp grid.cpp bitlife.cpp patternio.cpp mappedfile.cpp
+//            rule.cpp metrics.cpp -o LifeCluster
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "distributed.h"
+#include "grid.h"
+#include "patternio.h"
+#include "rule.h"
+#include "transport.h"
+
+#define DEFAULT_WIDTH 25
+#define DEFAULT_HEIGHT 25
+#define DEFAULT_WORKERS 2
+#define OUTPUT_BUFFER_BYTES (1 << 20)
+
+int main(int argc, char* argv[]){
+    DistributedRun run; // What to step and write
+    bool sizeGiven = false; // Whether -size was given, rather than taking the size from the seed file
+    bool ruleGiven = false; // Whether -rule was given, rather than taking the rule from the seed file
+    const char *seedPath = nullptr; // File to read the seed from
+    Pattern seedPattern; // The open seed file
+    const char *outputPath = nullptr; // File the boards go to, if not standard output
+    FILE *output = stdout; // Where the boards go
+    std::string error; // Why the run failed
+
+    run.width = DEFAULT_WIDTH;
+    run.height = DEFAULT_HEIGHT;
+    run.edgeMode = EDGE_DEAD;
+    makeRule(run.rule, RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVE);
+    run.workers = DEFAULT_WORKERS;
+    run.transport = TRANSPORT_SHARED;
+    run.generations = 1;
+    run.every = 0;
+    run.populationOnly = false;
+
+    for(int i=1; i < argc; i++){
+        if(std::strcmp(argv[i], "-seed") == 0 && i+1 < argc){
+            seedPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-workers") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%d", &run.workers) != 1 || run.workers < 1 || run.workers > DISTRIBUTED_MAX_WORKERS){
+                std::cerr << "ERROR, workers must be from 1 to " << DISTRIBUTED_MAX_WORKERS << ": " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-transport") == 0 && i+1 < argc){
+            i++;
+            if(!parseTransportKind(argv[i], run.transport)){
+                std::cerr << "ERROR, transport must be shm or socket: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-size") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%dx%d", &run.width, &run.height) != 2 || run.width < 1 || run.height < 1){
+                std::cerr << "ERROR, size must look like 25x25: " << argv[i] << "\n";
+                return 1;
+            }
+            sizeGiven = true;
+        }
+        else if(std::strcmp(argv[i], "-edge") == 0 && i+1 < argc){
+            i++;
+            if(!parseEdgeMode(argv[i], run.edgeMode)){
+                std::cerr << "ERROR, unknown edge mode: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-rule") == 0 && i+1 < argc){
+            i++;
+            if(!parseRule(argv[i], run.rule)){
+                std::cerr << "ERROR, rule must look like B3/S23: " << argv[i] << "\n";
+                return 1;
+            }
+            ruleGiven = true;
+        }
+        else if((std::strcmp(argv[i], "-batch") == 0 || std::strcmp(argv[i], "-generations") == 0) && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%llu", &run.generations) != 1 || argv[i][0] == '-'){
+                std::cerr << "ERROR, batch must be a number of generations: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-every") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%llu", &run.every) != 1 || argv[i][0] == '-'){
+                std::cerr << "ERROR, every must be a number of generations: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-output") == 0 && i+1 < argc){
+            outputPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-population") == 0){
+            run.populationOnly = true;
+        }
+        else{
+            seedPath = nullptr;
+            break;
+        }
+    }
+    if(seedPath == nullptr){
+        std::cerr << "Usage: " << argv[0] << " -seed FILE [-workers N] [-transport shm|socket] [-size WIDTHxHEIGHT]"
+                  << " [-edge dead|torus|mirror] [-rule RULE] [-batch N] [-every K] [-output FILE] [-population]\n";
+        return 1;
+    }
+
+    if(!openPattern(seedPath, seedPattern)){
+        std::cerr << "ERROR, could not open the pattern file " << seedPath << "\n";
+        return 1;
+    }
+    if(!sizeGiven && seedPattern.width > 0 && seedPattern.height > 0){
+        run.width = seedPattern.width; // RLE files say how big they are
+        run.height = seedPattern.height;
+    }
+    if(!ruleGiven && !seedPattern.rule.empty() && !parseRule(seedPattern.rule.c_str(), run.rule)){
+        std::cerr << "ERROR, unknown rule in " << seedPath << ": " << seedPattern.rule << "\n";
+        closePattern(seedPattern);
+        return 1;
+    }
+    if(run.workers > run.height){
+        std::cerr << "ERROR, " << run.workers << " workers need at least as many rows, and the board has " << run.height << "\n";
+        closePattern(seedPattern);
+        return 1;
+    }
+
+    if(outputPath != nullptr){
+        output = std::fopen(outputPath, "w");
+        if(output == nullptr){
+            std::cerr << "ERROR, could not open " << outputPath << " for writing\n";
+            closePattern(seedPattern);
+            return 1;
+        }
+    }
+    std::setvbuf(output, nullptr, _IOFBF, OUTPUT_BUFFER_BYTES);
+
+    bool finished = runDistributed(run, seedPattern, output, error); // Whether every worker finished
+    closePattern(seedPattern);
+    if(output != stdout){
+        std::fclose(output); // Worker 0 has already written and flushed everything
+    }
+    if(!finished){
+        std::cerr << "ERROR, " << error << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Conway's Game of Life
+// cycle.cpp
+//
+// Still life and oscillator detection. See cycle.h.
+
+#include "cycle.h"
+#include <sstream>
+
+void initCycleDetector(CycleDetector &detector, int maxPeriod){
+    detector.maxPeriod = maxPeriod;
+    detector.hashes.assign(maxPeriod, 0);
+    detector.generations.assign(maxPeriod, 0);
+    detector.nextSlot = 0;
+    detector.filled = 0;
+    detector.checking = false;
+    detector.checkGeneration = 0;
+    detector.snapshot.clear();
+    detector.kind = CYCLE_NONE;
+    detector.period = 0;
+    detector.startGeneration = 0;
+}
+
+bool observeGeneration(CycleDetector &detector, const Simulation &sim){
+    size_t i;
+
+    if(detector.kind != CYCLE_NONE){
+        return false;
+    }
+    // Under a B0 rule an empty board fills up on the next step, so it is left to the fingerprints
+    if(simulationPopulation(sim) == 0 && !(sim.rule.birth & 1)){
+        detector.kind = CYCLE_EXTINCT;
+        detector.period = 1;
+        detector.startGeneration = sim.generation;
+        return true;
+    }
+
+    if(detector.checking && sim.generation >= detector.checkGeneration){
+        detector.checking = false;
+        if(sim.generation == detector.checkGeneration){
+            snapshotSimulation(sim, detector.scratch);
+            if(detector.scratch == detector.snapshot){
+                detector.kind = (detector.period == 1) ? CYCLE_STILL : CYCLE_OSCILLATOR;
+                return true;
+            }
+        }
+    }
+
+    uint64_t hash = simulationHash(sim);
+
+    if(!detector.checking){
+        // The most recent match gives the shortest period
+        for(i=1; i <= detector.filled; i++){
+            size_t slot = (detector.nextSlot + detector.maxPeriod - i) % detector.maxPeriod;
+            if(detector.hashes[slot] == hash){
+                detector.checking = true;
+                detector.period = sim.generation - detector.generations[slot];
+                detector.startGeneration = detector.generations[slot];
+                detector.checkGeneration = sim.generation + detector.period;
+                snapshotSimulation(sim, detector.snapshot);
+                break;
+            }
+        }
+    }
+
+    detector.hashes[detector.nextSlot] = hash;
+    detector.generations[detector.nextSlot] = sim.generation;
+    detector.nextSlot = (detector.nextSlot + 1) % detector.maxPeriod;
+    if(detector.filled < (size_t)detector.maxPeriod){
+        detector.filled++;
+    }
+    return false;
+}
+
+std::string describeCycle(const CycleDetector &detector){
+    std::ostringstream text;
+
+    if(detector.kind == CYCLE_EXTINCT){
+        text << "EXTINCT: every cell is dead from generation " << detector.startGeneration;
+    }
+    else if(detector.kind == CYCLE_STILL){
+        text << "STILL LIFE: unchanged from generation " << detector.startGeneration;
+    }
+    else if(detector.kind == CYCLE_OSCILLATOR){
+        text << "OSCILLATOR: period " << detector.period << " from generation " << detector.startGeneration;
+    }
+    return text.str();
+}
@@ -0,0 +1,79 @@
+// Conway's Game of Life
+// cycle.h
+//
+// Spotting boards that have settled down. A fingerprint of each of the last few generations
+// is kept; when the current generation's fingerprint matches one of them, the board is
+// recorded exactly and checked again one period later, so a fingerprint collision can never
+// be reported as a cycle. Dying out, still lifes and oscillators are all found this way.
+
+#ifndef CYCLE_H
+#define CYCLE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "simulation.h"
+
+// CycleKind
+// Purpose: what the board has settled into
+//      CYCLE_NONE - nothing found yet
+//      CYCLE_EXTINCT - every cell is dead, under a rule without B0 (where it stays so)
+//      CYCLE_STILL - the board no longer changes (period 1)
+//      CYCLE_OSCILLATOR - the board repeats with a longer period
+enum CycleKind{
+    CYCLE_NONE,
+    CYCLE_EXTINCT,
+    CYCLE_STILL,
+    CYCLE_OSCILLATOR
+};
+
+// CycleDetector
+// Purpose: the recent fingerprints and the state of the check in progress
+struct CycleDetector{
+    int maxPeriod; // The longest period looked for, in generations
+    std::vector<uint64_t> hashes; // Fingerprints of recent generations, oldest overwritten first
+    std::vector<unsigned long long> generations; // The generation each fingerprint belongs to
+    size_t nextSlot; // Where the next fingerprint goes
+    size_t filled; // How many slots hold a fingerprint
+    bool checking; // Whether a candidate is waiting to be confirmed
+    unsigned long long checkGeneration; // The generation at which the candidate is confirmed
+    std::vector<uint64_t> snapshot; // The exact board the candidate must come back to
+    std::vector<uint64_t> scratch; // The exact board being compared with it
+    CycleKind kind; // What was found
+    unsigned long long period; // The period found, in generations
+    unsigned long long startGeneration; // The first generation of the cycle
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// initCycleDetector
+// Purpose: set up a detector with nothing seen yet
+// Input:
+//      detector - the detector to set up
+//      maxPeriod - the longest period to look for; at least 1
+// Output:
+//      No return type.
+void initCycleDetector(CycleDetector &detector, int maxPeriod);
+
+// observeGeneration
+// Purpose: look at the current generation of a simulation
+// Input:
+//      detector - the detector to update
+//      sim - the simulation, which must be looked at after every step
+// Output:
+//      Returns true once, for the generation at which a cycle is confirmed. Its kind, period and
+//      start are then in the detector. Periods are found in multiples of the step between looks.
+bool observeGeneration(CycleDetector &detector, const Simulation &sim);
+
+// describeCycle
+// Purpose: put what the detector found into words
+// Input:
+//      detector - the detector to describe
+// Output:
+//      Returns a line such as "OSCILLATOR: period 3 from generation 0", or "" if nothing was found.
+std::string describeCycle(const CycleDetector &detector);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // CYCLE_H
@@ -0,0 +1,287 @@
+// Conway's Game of Life
+// distributed.cpp
+//
+// Worker processes that each step one band of the board. See distributed.h.
+
+#include "distributed.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bitlife.h"
+
+#define TAG_UP 1 // A worker's top row, on its way to the worker above, where it becomes the bottom ghost row
+#define TAG_DOWN 2 // A worker's bottom row, on its way to the worker below, where it becomes the top ghost row
+#define TAG_POPULATION 3 // A worker's population, on its way to worker 0
+#define TAG_ROW 4 // One row of a worker's band, on its way to worker 0
+
+// WorkerExit
+// Purpose: how a worker process ended, as its exit status
+enum WorkerExit{
+    WORKER_DONE = 0,
+    WORKER_BAD_SEED, // The pattern could not be read
+    WORKER_LOST_PEER, // Another worker stopped answering
+    WORKER_WRITE_FAILED // Worker 0 could not write the output
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// stepBand
+// Purpose: step one worker's band a generation, trading edge rows with its neighbors
+// Input:
+//      front - the band; receives the next generation
+//      back - scratch of the same size
+//      run - the edge mode and rule
+//      transport - the workers' connections
+//      up - the worker whose band is above this one, or -1 if the edge mode covers it
+//      down - the worker whose band is below this one, or -1 if the edge mode covers it
+// Output:
+//      Returns false if a neighbor stopped answering.
+static bool stepBand(BitTable &front, BitTable &back, const DistributedRun &run, HaloTransport &transport, int up, int down);
+
+// writeBand
+// Purpose: add one worker's band to the output of a generation
+// Input:
+//      band - the band
+//      run - what to write
+//      generation - the number of the generation
+//      output - worker 0: where the output goes
+//      transport - the workers' connections
+// Output:
+//      Returns a WorkerExit: whether the band got to worker 0 and, for worker 0, whether the output was written.
+static int writeBand(const BitTable &band, const DistributedRun &run, unsigned long long generation, FILE *output,
+                     HaloTransport &transport);
+
+// runWorker
+// Purpose: the whole life of one worker process
+// Input:
+//      run - what to step and write
+//      seed - the open pattern the board starts from
+//      output - worker 0: where the output goes
+//      transport - the workers' connections, attached with this worker's rank
+// Output:
+//      Returns the WorkerExit the process ends with.
+static int runWorker(const DistributedRun &run, const Pattern &seed, FILE *output, HaloTransport &transport);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+void bandRows(int height, int workers, int rank, int &firstRow, int &endRow){
+    int rows = height / workers; // Rows every band has
+    int extra = height % workers; // The first this many bands have one more
+
+    firstRow = rank * rows + std::min(rank, extra);
+    endRow = firstRow + rows + (rank < extra ? 1 : 0);
+}
+
+bool runDistributed(const DistributedRun &run, const Pattern &seed, FILE *output, std::string &error){
+    std::unique_ptr<HaloTransport> transport = createTransport(run.transport, run.workers, error);
+    std::vector<pid_t> pids(run.workers, -1); // The process of each worker
+    int running = 0; // Workers that have not been waited for
+    int rank;
+
+    if(!transport){
+        return false;
+    }
+    std::cout.flush(); // Anything still buffered would be written once more by every worker
+    std::fflush(stdout);
+
+    for(rank=0; rank < run.workers; rank++){
+        pids[rank] = fork();
+        if(pids[rank] == 0){
+            transport->attach(rank);
+            _exit(runWorker(run, seed, output, *transport));
+        }
+        if(pids[rank] < 0){
+            error = "could not start worker " + std::to_string(rank);
+            break;
+        }
+        running++;
+    }
+    transport.reset(); // The workers have their own copies; closing these lets them see each other exit
+
+    while(running > 0){
+        int status; // How the worker ended
+        pid_t pid = waitpid(-1, &status, 0);
+        if(pid < 0){
+            break;
+        }
+        rank = (int)(std::find(pids.begin(), pids.end(), pid) - pids.begin());
+        if(rank == run.workers){
+            continue;
+        }
+        pids[rank] = -1;
+        running--;
+        if(WIFEXITED(status) && WEXITSTATUS(status) == WORKER_DONE){
+            continue;
+        }
+
+        // The others would wait for this one forever, so stop them too; only the first failure is reported
+        if(error.empty()){
+            if(WIFSIGNALED(status)){
+                error = "worker " + std::to_string(rank) + " was killed by signal " + std::to_string(WTERMSIG(status));
+            }
+            else if(WEXITSTATUS(status) == WORKER_BAD_SEED){
+                error = "could not read a " + std::to_string(run.width) + "x" + std::to_string(run.height) + " board";
+            }
+            else if(WEXITSTATUS(status) == WORKER_WRITE_FAILED){
+                error = "could not write the output";
+            }
+            else{
+                error = "worker " + std::to_string(rank) + " lost touch with its neighbors";
+            }
+        }
+        for(int other=0; other < run.workers; other++){
+            if(pids[other] > 0){
+                kill(pids[other], SIGKILL);
+            }
+        }
+    }
+    return error.empty();
+}
+
+static bool stepBand(BitTable &front, BitTable &back, const DistributedRun &run, HaloTransport &transport, int up, int down){
+    int rows = front.height;
+    size_t stride = front.wordsPerRow;
+    size_t haloBytes = (front.dataWords + 2) * sizeof(WordType); // A row with its guard words
+    WordType *words = &front.words[0];
+
+    // The edge mode fills the ghost rows at the top and bottom of the board and the guard words of every
+    // row; the ghost rows between bands are then replaced with the neighbors' edge rows
+    fillBitBorder(front, run.edgeMode);
+    if((up >= 0 && !transport.send(up, TAG_UP, words + stride, haloBytes)) ||
+       (down >= 0 && !transport.send(down, TAG_DOWN, words + rows * stride, haloBytes))){
+        return false;
+    }
+
+    // The rows in between need nothing from the neighbors, so they are stepped while the edge rows travel
+    if(rows > 2){
+        bitIterateRows(front, back, 1, rows - 1, run.rule, nullptr);
+    }
+
+    // Taken in the order the neighbor sent them, which matters when up and down are the same worker
+    if((down >= 0 && !transport.receive(down, TAG_UP, words + (rows + 1) * stride, haloBytes)) ||
+       (up >= 0 && !transport.receive(up, TAG_DOWN, words, haloBytes))){
+        return false;
+    }
+    bitIterateRows(front, back, 0, 1, run.rule, nullptr);
+    if(rows > 1){
+        bitIterateRows(front, back, rows - 1, rows, run.rule, nullptr);
+    }
+    std::swap(front.words, back.words);
+    return true;
+}
+
+static int writeBand(const BitTable &band, const DistributedRun &run, unsigned long long generation, FILE *output,
+                     HaloTransport &transport){
+    uint64_t population = bitPopulation(band); // This band's living cells, then worker 0's total
+    size_t rowBytes = band.dataWords * sizeof(WordType); // The data words of one row
+    std::vector<WordType> row(band.dataWords); // worker 0: a row from another worker
+    std::string line; // worker 0: one row of the board, built up before it is written
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+
+    if(transport.rank() != 0){
+        if(!transport.send(0, TAG_POPULATION, &population, sizeof(population))){
+            return WORKER_LOST_PEER;
+        }
+        for(y=1; y <= band.height && !run.populationOnly; y++){
+            // Waiting for each row to leave keeps no more than one row queued, however big the band
+            if(!transport.send(0, TAG_ROW, &band.words[(size_t)y * band.wordsPerRow + 1], rowBytes) || !transport.flush(0)){
+                return WORKER_LOST_PEER;
+            }
+        }
+        return transport.flush(0) ? WORKER_DONE : WORKER_LOST_PEER;
+    }
+
+    for(int peer=1; peer < transport.size(); peer++){
+        uint64_t count; // Another band's living cells
+        if(!transport.receive(peer, TAG_POPULATION, &count, sizeof(count))){
+            return WORKER_LOST_PEER;
+        }
+        population += count;
+    }
+    if(run.populationOnly){
+        std::fprintf(output, "%llu %llu\n", generation, (unsigned long long)population);
+        return std::ferror(output) ? WORKER_WRITE_FAILED : WORKER_DONE;
+    }
+
+    std::fprintf(output, "# generation %llu population %llu\n", generation, (unsigned long long)population);
+    line.resize((size_t)run.width * 2);
+    for(int peer=0; peer < transport.size(); peer++){
+        int firstRow; // The band of peer
+        int endRow;
+        bandRows(run.height, transport.size(), peer, firstRow, endRow);
+        for(y=firstRow; y < endRow; y++){
+            const WordType *words = &band.words[(size_t)(y + 1) * band.wordsPerRow + 1];
+            if(peer != 0){
+                if(!transport.receive(peer, TAG_ROW, row.data(), rowBytes)){
+                    return WORKER_LOST_PEER;
+                }
+                words = row.data();
+            }
+            for(x=0; x < run.width; x++){
+                line[2*x] = ((words[x / 64] >> (x % 64)) & 1) ? '1' : '0';
+                line[2*x + 1] = ' ';
+            }
+            line[line.size() - 1] = '\n';
+            std::fwrite(line.data(), 1, line.size(), output);
+        }
+    }
+    return std::ferror(output) ? WORKER_WRITE_FAILED : WORKER_DONE;
+}
+
+static int runWorker(const DistributedRun &run, const Pattern &seed, FILE *output, HaloTransport &transport){
+    int rank = transport.rank();
+    int workers = transport.size();
+    bool torus = (run.edgeMode == EDGE_TORUS && workers > 1); // Whether the first and last bands are neighbors
+    int up = (rank > 0) ? rank - 1 : (torus ? workers - 1 : -1);
+    int down = (rank < workers - 1) ? rank + 1 : (torus ? 0 : -1);
+    int firstRow; // The rows this worker owns
+    int endRow;
+    BitTable front; // The band
+    BitTable back; // Scratch the next generation is written to
+    unsigned long long generation = 0; // The generation front holds
+    int result;
+
+    bandRows(run.height, workers, rank, firstRow, endRow);
+    initBitTable(front, run.width, endRow - firstRow);
+    initBitTable(back, run.width, endRow - firstRow);
+
+    // Every worker reads the whole pattern, which is mapped and so shared between them, and keeps only its band
+    if(!readPattern(seed, run.width, run.height, [&](int x, int y, int length){
+        if(y >= firstRow && y < endRow){
+            setBitRun(front, x, y - firstRow, length);
+        }
+    })){
+        return WORKER_BAD_SEED;
+    }
+
+    while(generation < run.generations){
+        if(!stepBand(front, back, run, transport, up, down)){
+            return WORKER_LOST_PEER;
+        }
+        generation++;
+        if(generation < run.generations && run.every != 0 && generation % run.every == 0){
+            result = writeBand(front, run, generation, output, transport);
+            if(result != WORKER_DONE){
+                return result;
+            }
+        }
+    }
+    result = writeBand(front, run, generation, output, transport);
+    if(rank == 0 && std::fflush(output) != 0){
+        return WORKER_WRITE_FAILED;
+    }
+    // A neighbor may still be waiting for the last edge row
+    if((up >= 0 && !transport.flush(up)) || (down >= 0 && !transport.flush(down))){
+        return WORKER_LOST_PEER;
+    }
+    return result;
+}
@@ -0,0 +1,73 @@
+// Conway's Game of Life
+// distributed.h
+//
+// Stepping one board across several worker processes, for boards too big for one
+// process to hold. The board is cut into bands of whole rows, one per worker, and each
+// worker keeps only its own band, bit-packed as in bitlife.h, plus a ghost row above and
+// below it. Every generation each worker sends its top and bottom rows to the workers
+// next to it over a HaloTransport (see transport.h), steps the rows that do not need
+// them while they are on the way, then steps its first and last rows once the neighbors'
+// rows have arrived. The result is the same, cell for cell, as the bit engine stepping
+// the whole board in one process.
+//
+// Worker 0 also writes the output: the others send it their population and then their
+// rows, one at a time, so no process ever holds more than its band and one row.
+//
+// POSIX only: the workers are forked from the calling process.
+
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <cstdio>
+#include <string>
+#include "grid.h"
+#include "patternio.h"
+#include "rule.h"
+#include "transport.h"
+
+#define DISTRIBUTED_MAX_WORKERS 64
+
+// DistributedRun
+// Purpose: what a distributed run steps and writes
+struct DistributedRun{
+    int width; // The number of columns on the board
+    int height; // The number of rows on the board
+    EdgeMode edgeMode; // How cells on the edge see past it
+    LifeRule rule; // The birth and survival counts
+    int workers; // The number of worker processes, at most height
+    TransportKind transport; // How the workers talk to each other
+    unsigned long long generations; // Generations to run
+    unsigned long long every; // Also write the board every this many generations; 0 for the final board only
+    bool populationOnly; // Write "generation population" lines instead of boards
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// bandRows
+// Purpose: find the rows one worker owns
+// Input:
+//      height - the number of rows on the board
+//      workers - the number of workers
+//      rank - the worker
+//      firstRow - receives its first row
+//      endRow - receives one past its last row
+// Output:
+//      No return type. The bands cover the board in rank order and differ in height by at most one row.
+void bandRows(int height, int workers, int rank, int &firstRow, int &endRow);
+
+// runDistributed
+// Purpose: fork the workers, run the board and wait for them to finish
+// Input:
+//      run - what to step and write
+//      seed - the open pattern the board starts from; each worker reads its own band from it
+//      output - where the boards are written, in the same format as a GameOfLife batch run.
+//               Nothing may be waiting in its buffer; worker 0 writes to it and flushes it.
+//      error - receives why the run failed
+// Output:
+//      Returns false if the workers could not be started or any of them failed.
+bool runDistributed(const DistributedRun &run, const Pattern &seed, FILE *output, std::string &error);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // DISTRIBUTED_H
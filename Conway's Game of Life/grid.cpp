@@ -0,0 +1,98 @@
+// Conway's Game of Life
+// grid.cpp
+//
+// Aligned storage, edge modes and the ghost border of the int matrix. See grid.h.
+
+#include "grid.h"
+#include <cstdlib>
+#include <cstring>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+void *allocAligned(std::size_t bytes){
+    void *block = nullptr;
+
+    if(bytes == 0){
+        bytes = CACHE_LINE_BYTES;
+    }
+#ifdef _WIN32
+    block = _aligned_malloc(bytes, CACHE_LINE_BYTES);
+#else
+    if(posix_memalign(&block, CACHE_LINE_BYTES, bytes) != 0){
+        block = nullptr;
+    }
+#endif
+    return block;
+}
+
+void freeAligned(void *block){
+#ifdef _WIN32
+    _aligned_free(block);
+#else
+    std::free(block);
+#endif
+}
+
+bool parseEdgeMode(const char *name, EdgeMode &edgeMode){
+    if(std::strcmp(name, "dead") == 0){
+        edgeMode = EDGE_DEAD;
+    }
+    else if(std::strcmp(name, "torus") == 0){
+        edgeMode = EDGE_TORUS;
+    }
+    else if(std::strcmp(name, "mirror") == 0){
+        edgeMode = EDGE_MIRROR;
+    }
+    else{
+        return false;
+    }
+    return true;
+}
+
+void initTable(TableType &table, int width, int height){
+    int intsPerLine = CACHE_LINE_BYTES / sizeof(int); // Ints that fit in one cache line
+
+    table.width = width;
+    table.height = height;
+    table.stride = (width + 2 + intsPerLine - 1) / intsPerLine * intsPerLine;
+    table.cells.assign((std::size_t)table.stride * (height + 2), 0);
+}
+
+void fillBorder(TableType &table, EdgeMode edgeMode){
+    int y; // The row currently being looked at
+    int width = table.width;
+    int height = table.height;
+    std::size_t rowBytes = (std::size_t)(width + 2) * sizeof(int); // One row with both ghost cells
+
+    // Left and right ghost columns first, so the corners come along when the rows are copied
+    for(y=0; y < height; y++){
+        int *row = tableRow(table, y);
+        if(edgeMode == EDGE_TORUS){
+            row[-1] = row[width-1];
+            row[width] = row[0];
+        }
+        else if(edgeMode == EDGE_MIRROR){
+            row[-1] = row[0];
+            row[width] = row[width-1];
+        }
+        else{
+            row[-1] = 0;
+            row[width] = 0;
+        }
+    }
+
+    // Top and bottom ghost rows
+    if(edgeMode == EDGE_TORUS){
+        std::memcpy(tableRow(table, -1) - 1, tableRow(table, height-1) - 1, rowBytes);
+        std::memcpy(tableRow(table, height) - 1, tableRow(table, 0) - 1, rowBytes);
+    }
+    else if(edgeMode == EDGE_MIRROR){
+        std::memcpy(tableRow(table, -1) - 1, tableRow(table, 0) - 1, rowBytes);
+        std::memcpy(tableRow(table, height) - 1, tableRow(table, height-1) - 1, rowBytes);
+    }
+    else{
+        std::memset(tableRow(table, -1) - 1, 0, rowBytes);
+        std::memset(tableRow(table, height) - 1, 0, rowBytes);
+    }
+}
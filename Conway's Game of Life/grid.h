@@ -0,0 +1,142 @@
+// Conway's Game of Life
+// grid.h
+//
+// Storage shared by the engines: cache-aligned heap blocks, the edge modes, and the
+// int matrix used by the cell-by-cell engine. Matrices are sized at startup and carry
+// a one-cell ghost border, which fillBorder() refreshes before every step so the
+// neighbor count never has to check whether it is looking past the edge.
+
+#ifndef GRID_H
+#define GRID_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#define CACHE_LINE_BYTES 64
+#define ALIVE 1
+#define DEAD 0
+
+// EdgeMode
+// Purpose: what the cells just outside the matrix look like to the cells on its edge
+//      EDGE_DEAD - everything outside the matrix is dead
+//      EDGE_TORUS - the matrix wraps around, left to right and top to bottom
+//      EDGE_MIRROR - the matrix is reflected across each edge
+enum EdgeMode{
+    EDGE_DEAD,
+    EDGE_TORUS,
+    EDGE_MIRROR
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// allocAligned
+// Purpose: allocate a block of memory that starts on a cache line boundary
+// Input:
+//      bytes - the size of the block
+// Output:
+//      Returns the block, or a null pointer if it could not be allocated. Release it with freeAligned.
+void *allocAligned(std::size_t bytes);
+
+// freeAligned
+// Purpose: release a block returned by allocAligned
+// Input:
+//      block - the block to release; may be a null pointer
+// Output:
+//      No return type.
+void freeAligned(void *block);
+
+// parseEdgeMode
+// Purpose: turn an edge mode name given on the command line into an EdgeMode
+// Input:
+//      name - "dead", "torus" or "mirror"
+//      edgeMode - receives the parsed mode
+// Output:
+//      Returns true if the name was recognized.
+bool parseEdgeMode(const char *name, EdgeMode &edgeMode);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+// AlignedAllocator
+// Purpose: lets std::vector keep its elements in a single cache-aligned block
+template<typename T>
+struct AlignedAllocator{
+    typedef T value_type;
+
+    AlignedAllocator(){}
+    template<typename U> AlignedAllocator(const AlignedAllocator<U> &){}
+
+    T *allocate(std::size_t count){
+        void *block = allocAligned(count * sizeof(T));
+        if(block == nullptr){
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(block);
+    }
+
+    void deallocate(T *block, std::size_t){
+        freeAligned(block);
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const AlignedAllocator<T> &, const AlignedAllocator<U> &){ return true; }
+template<typename T, typename U>
+bool operator!=(const AlignedAllocator<T> &, const AlignedAllocator<U> &){ return false; }
+
+
+// TableType
+// Purpose: stores a matrix of integers, either 1 or 0, representing living and dead cells
+// Layout:
+//      Row-major, with a ghost row above and below the matrix and a ghost column on each side.
+//      Each row is padded out to a whole number of cache lines, so every row starts aligned.
+struct TableType{
+    int width; // The number of columns in the matrix
+    int height; // The number of rows in the matrix
+    int stride; // The number of ints from one row to the next, ghost cells and padding included
+    std::vector<int, AlignedAllocator<int> > cells; // (height + 2) rows of stride ints
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// initTable
+// Purpose: size a matrix and clear every cell, ghost border included, to dead
+// Input:
+//      table - the matrix to set up
+//      width - the number of columns
+//      height - the number of rows
+// Output:
+//      No return type.
+void initTable(TableType &table, int width, int height);
+
+// fillBorder
+// Purpose: refresh the ghost border of a matrix from its edge cells
+// Input:
+//      table - the matrix whose border is filled
+//      edgeMode - what the border should look like
+// Output:
+//      No return type. The function must be called whenever the edge cells change and before counting neighbors.
+void fillBorder(TableType &table, EdgeMode edgeMode);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+// tableRow
+// Purpose: find the first cell of a row of the matrix
+// Input:
+//      table - the matrix
+//      y - the row; -1 and height are the ghost rows
+// Output:
+//      Returns a pointer to cell (0, y). Index -1 and width are the ghost cells.
+inline int *tableRow(TableType &table, int y){
+    return &table.cells[(std::size_t)(y + 1) * table.stride + 1];
+}
+
+inline const int *tableRow(const TableType &table, int y){
+    return &table.cells[(std::size_t)(y + 1) * table.stride + 1];
+}
+
+#endif // GRID_H
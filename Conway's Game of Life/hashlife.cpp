@@ -0,0 +1,543 @@
+// Conway's Game of Life
+// hashlife.cpp
+//
+// HashLife engine. See hashlife.h.
+
+#include "hashlife.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+#define INITIAL_BUCKETS (1 << 16)
+#define MIN_CACHE_NODES (1 << 16)
+#define PLANE_HASH_X 0x9E3779B97F4A7C15ull // Odd bases of the plane fingerprint, one per axis
+#define PLANE_HASH_Y 0xC2B2AE3D27D4EB4Full
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// Helpers used only by the engine itself. Indices are passed around rather than references,
+// because making a node can grow the pool and move every node in it.
+
+static NodeIndex makeNode(HashLife &life, NodeIndex nw, NodeIndex ne, NodeIndex sw, NodeIndex se);
+static NodeIndex successor(HashLife &life, NodeIndex node, int stepLog);
+static NodeIndex stepLevel2(HashLife &life, NodeIndex node);
+static NodeIndex buildNode(HashLife &life, const TableType &table, int level, int x, int y);
+static void storeNode(const HashLife &life, NodeIndex node, int64_t x, int64_t y, TableType &table);
+static void expandRoot(HashLife &life);
+static bool rootIsPadded(const HashLife &life);
+static void markNode(HashLife &life, NodeIndex node, bool keepResults);
+static void rehash(HashLife &life, size_t numBuckets);
+static uint64_t nodePlaneHash(const HashLife &life, NodeIndex node, const uint64_t *stepX, const uint64_t *stepY,
+                              std::unordered_map<NodeIndex, uint64_t> &memo);
+static uint64_t powerOf(uint64_t base, int64_t exponent);
+static void listNode(const HashLife &life, NodeIndex node, int64_t x, int64_t y,
+                     std::vector<std::pair<int64_t, int64_t> > &cells);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+static size_t hashChildren(NodeIndex nw, NodeIndex ne, NodeIndex sw, NodeIndex se){
+    uint64_t h = nw * 0x9E3779B97F4A7C15ull;
+    h = (h ^ (h >> 29)) + ne * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 31)) + sw * 0x94D049BB133111EBull;
+    h = (h ^ (h >> 30)) + se * 0xD6E8FEB86659FD93ull;
+    return (size_t)(h ^ (h >> 32));
+}
+
+void initHashLife(HashLife &life, size_t maxBytes, const LifeRule &rule){
+    int level;
+    HashNode leaf;
+
+    life.rule = rule;
+    life.nodes.clear();
+    life.buckets.assign(INITIAL_BUCKETS, NO_NODE);
+    life.freeList = NO_NODE;
+    life.maxNodes = std::max((size_t)MIN_CACHE_NODES, maxBytes / (sizeof(HashNode) + sizeof(NodeIndex)));
+    life.maxStepLog = HASH_MAX_LEVEL - 3;
+
+    // The two single cells are never hashed; every node above them is
+    std::memset(&leaf, 0, sizeof(leaf));
+    leaf.nw = leaf.ne = leaf.sw = leaf.se = NO_NODE;
+    leaf.next = NO_NODE;
+    leaf.result = NO_NODE;
+    leaf.resultStep = -1;
+    life.nodes.push_back(leaf); // Node 0, dead
+    leaf.population = 1;
+    life.nodes.push_back(leaf); // Node 1, alive
+    life.liveNodes = 2;
+
+    life.emptyNodes[0] = 0;
+    for(level=1; level <= HASH_MAX_LEVEL; level++){
+        NodeIndex e = life.emptyNodes[level-1];
+        life.emptyNodes[level] = makeNode(life, e, e, e, e);
+    }
+
+    life.root = life.emptyNodes[3];
+    life.originX = 0;
+    life.originY = 0;
+}
+
+static NodeIndex makeNode(HashLife &life, NodeIndex nw, NodeIndex ne, NodeIndex sw, NodeIndex se){
+    size_t bucket = hashChildren(nw, ne, sw, se) & (life.buckets.size() - 1);
+    NodeIndex index; // The node being looked at, then the node being made
+
+    // Return the existing node if this square has been seen before
+    for(index = life.buckets[bucket]; index != NO_NODE; index = life.nodes[index].next){
+        const HashNode &node = life.nodes[index];
+        if(node.nw == nw && node.ne == ne && node.sw == sw && node.se == se){
+            return index;
+        }
+    }
+
+    if(life.freeList != NO_NODE){
+        index = life.freeList;
+        life.freeList = life.nodes[index].next;
+    }
+    else{
+        index = (NodeIndex)life.nodes.size();
+        life.nodes.push_back(HashNode());
+    }
+    life.liveNodes++;
+
+    HashNode &node = life.nodes[index];
+    node.nw = nw;
+    node.ne = ne;
+    node.sw = sw;
+    node.se = se;
+    node.level = (int8_t)(life.nodes[nw].level + 1);
+    node.population = life.nodes[nw].population + life.nodes[ne].population
+                    + life.nodes[sw].population + life.nodes[se].population;
+    node.result = NO_NODE;
+    node.resultStep = -1;
+    node.marked = 0;
+    node.next = life.buckets[bucket];
+    life.buckets[bucket] = index;
+
+    if(life.liveNodes > life.buckets.size()){
+        rehash(life, life.buckets.size() * 2);
+    }
+    return index;
+}
+
+static void rehash(HashLife &life, size_t numBuckets){
+    size_t i;
+
+    life.buckets.assign(numBuckets, NO_NODE);
+    for(i=2; i < life.nodes.size(); i++){
+        HashNode &node = life.nodes[i];
+        if(node.level > 0){
+            size_t bucket = hashChildren(node.nw, node.ne, node.sw, node.se) & (numBuckets - 1);
+            node.next = life.buckets[bucket];
+            life.buckets[bucket] = (NodeIndex)i;
+        }
+    }
+}
+
+static NodeIndex stepLevel2(HashLife &life, NodeIndex node){
+    int cells[4][4]; // The 4x4 square, as [row][column]
+    int next[2][2]; // The centre 2x2 square one generation later
+    int r; // The row currently being looked at
+    int c; // The column currently being looked at
+    const HashNode &square = life.nodes[node];
+    NodeIndex quadrants[2][2] = { { square.nw, square.ne }, { square.sw, square.se } };
+
+    for(r=0; r < 4; r++){
+        for(c=0; c < 4; c++){
+            const HashNode &quadrant = life.nodes[quadrants[r / 2][c / 2]];
+            NodeIndex leaves[2][2] = { { quadrant.nw, quadrant.ne }, { quadrant.sw, quadrant.se } };
+            cells[r][c] = (int)life.nodes[leaves[r % 2][c % 2]].population;
+        }
+    }
+
+    for(r=1; r <= 2; r++){
+        for(c=1; c <= 2; c++){
+            int numOfNeighbors = cells[r-1][c-1] + cells[r-1][c] + cells[r-1][c+1]
+                               + cells[r][c-1] + cells[r][c+1]
+                               + cells[r+1][c-1] + cells[r+1][c] + cells[r+1][c+1];
+            next[r-1][c-1] = life.rule.next[cells[r][c]][numOfNeighbors];
+        }
+    }
+
+    return makeNode(life, next[0][0], next[0][1], next[1][0], next[1][1]);
+}
+
+static NodeIndex successor(HashLife &life, NodeIndex node, int stepLog){
+    int level = life.nodes[node].level;
+    NodeIndex result;
+
+    if(life.nodes[node].population == 0){
+        return life.emptyNodes[level-1];
+    }
+    stepLog = std::min(stepLog, level - 2);
+    if(life.nodes[node].result != NO_NODE && life.nodes[node].resultStep == stepLog){
+        return life.nodes[node].result;
+    }
+
+    if(level == 2){
+        result = stepLevel2(life, node);
+    }
+    else{
+        // Copy out the grandchildren that are needed first; the pool may move while nodes are made
+        const HashNode &m = life.nodes[node];
+        const HashNode &a = life.nodes[m.nw];
+        const HashNode &b = life.nodes[m.ne];
+        const HashNode &c = life.nodes[m.sw];
+        const HashNode &d = life.nodes[m.se];
+        NodeIndex ab = a.ne, ac = a.sw, ad = a.se;
+        NodeIndex ba = b.nw, bc = b.sw, bd = b.se;
+        NodeIndex ca = c.nw, cb = c.ne, cd = c.se;
+        NodeIndex da = d.nw, db = d.ne, dc = d.sw;
+        NodeIndex nw = m.nw, ne = m.ne, sw = m.sw, se = m.se;
+        int childStep = std::min(stepLog, level - 3);
+
+        // Nine overlapping squares one level down, each advanced by up to half the step
+        NodeIndex n00 = successor(life, nw, childStep);
+        NodeIndex n01 = successor(life, makeNode(life, ab, ba, ad, bc), childStep);
+        NodeIndex n02 = successor(life, ne, childStep);
+        NodeIndex n10 = successor(life, makeNode(life, ac, ad, ca, cb), childStep);
+        NodeIndex n11 = successor(life, makeNode(life, ad, bc, cb, da), childStep);
+        NodeIndex n12 = successor(life, makeNode(life, bc, bd, da, db), childStep);
+        NodeIndex n20 = successor(life, sw, childStep);
+        NodeIndex n21 = successor(life, makeNode(life, cb, da, cd, dc), childStep);
+        NodeIndex n22 = successor(life, se, childStep);
+
+        if(stepLog < level - 2){
+            // The nine squares are already far enough along; just take their centres
+            NodeIndex centres[3][3][4];
+            NodeIndex pieces[3][3] = { { n00, n01, n02 }, { n10, n11, n12 }, { n20, n21, n22 } };
+            int i, j;
+            for(i=0; i < 3; i++){
+                for(j=0; j < 3; j++){
+                    const HashNode &piece = life.nodes[pieces[i][j]];
+                    centres[i][j][0] = piece.nw;
+                    centres[i][j][1] = piece.ne;
+                    centres[i][j][2] = piece.sw;
+                    centres[i][j][3] = piece.se;
+                }
+            }
+            NodeIndex q00 = makeNode(life, centres[0][0][3], centres[0][1][2], centres[1][0][1], centres[1][1][0]);
+            NodeIndex q01 = makeNode(life, centres[0][1][3], centres[0][2][2], centres[1][1][1], centres[1][2][0]);
+            NodeIndex q10 = makeNode(life, centres[1][0][3], centres[1][1][2], centres[2][0][1], centres[2][1][0]);
+            NodeIndex q11 = makeNode(life, centres[1][1][3], centres[1][2][2], centres[2][1][1], centres[2][2][0]);
+            result = makeNode(life, q00, q01, q10, q11);
+        }
+        else{
+            // Advance four overlapping squares of those by the other half of the step
+            NodeIndex q00 = successor(life, makeNode(life, n00, n01, n10, n11), childStep);
+            NodeIndex q01 = successor(life, makeNode(life, n01, n02, n11, n12), childStep);
+            NodeIndex q10 = successor(life, makeNode(life, n10, n11, n20, n21), childStep);
+            NodeIndex q11 = successor(life, makeNode(life, n11, n12, n21, n22), childStep);
+            result = makeNode(life, q00, q01, q10, q11);
+        }
+    }
+
+    life.nodes[node].result = result;
+    life.nodes[node].resultStep = (int8_t)stepLog;
+    return result;
+}
+
+static bool rootIsPadded(const HashLife &life){
+    const HashNode &root = life.nodes[life.root];
+
+    if(root.level < 3){
+        return false;
+    }
+    // Every living cell has to be in the centre half of the square
+    return life.nodes[life.nodes[root.nw].se].population + life.nodes[life.nodes[root.ne].sw].population
+         + life.nodes[life.nodes[root.sw].ne].population + life.nodes[life.nodes[root.se].nw].population
+         == root.population;
+}
+
+static void expandRoot(HashLife &life){
+    int level = life.nodes[life.root].level;
+    NodeIndex e = life.emptyNodes[level-1];
+    NodeIndex nw = life.nodes[life.root].nw;
+    NodeIndex ne = life.nodes[life.root].ne;
+    NodeIndex sw = life.nodes[life.root].sw;
+    NodeIndex se = life.nodes[life.root].se;
+
+    // Put the root in the middle of a square twice its size
+    NodeIndex bigNW = makeNode(life, e, e, e, nw);
+    NodeIndex bigNE = makeNode(life, e, e, ne, e);
+    NodeIndex bigSW = makeNode(life, e, sw, e, e);
+    NodeIndex bigSE = makeNode(life, se, e, e, e);
+    life.root = makeNode(life, bigNW, bigNE, bigSW, bigSE);
+    life.originX -= (int64_t)1 << (level - 1);
+    life.originY -= (int64_t)1 << (level - 1);
+}
+
+void hashStep(HashLife &life, int stepLog){
+    stepLog = std::max(0, std::min(stepLog, HASH_MAX_LEVEL - 3));
+
+    // The pattern can spread by one cell a generation, so give it room to grow into
+    while(life.nodes[life.root].level < HASH_MAX_LEVEL - 1
+          && (life.nodes[life.root].level < stepLog + 2 || !rootIsPadded(life))){
+        expandRoot(life);
+    }
+    if(life.nodes[life.root].level < HASH_MAX_LEVEL){
+        expandRoot(life);
+    }
+
+    int level = life.nodes[life.root].level;
+    life.root = successor(life, life.root, stepLog);
+    life.originX += (int64_t)1 << (level - 2);
+    life.originY += (int64_t)1 << (level - 2);
+
+    // Trim empty space from around the pattern so the next step starts small
+    while(rootIsPadded(life) && life.nodes[life.root].level > 3){
+        const HashNode &root = life.nodes[life.root];
+        NodeIndex centre = makeNode(life, life.nodes[root.nw].se, life.nodes[root.ne].sw,
+                                    life.nodes[root.sw].ne, life.nodes[root.se].nw);
+        level = life.nodes[life.root].level;
+        life.root = centre;
+        life.originX += (int64_t)1 << (level - 2);
+        life.originY += (int64_t)1 << (level - 2);
+    }
+
+    // Keep the node cache under its cap: drop unreachable nodes first, then the remembered
+    // successors too, and if the pattern alone still crowds the cache take smaller steps
+    if(life.liveNodes > life.maxNodes){
+        hashCollectGarbage(life, true);
+        if(life.liveNodes > life.maxNodes / 2){
+            hashCollectGarbage(life, false);
+            if(life.liveNodes > life.maxNodes / 2 && life.maxStepLog > 0){
+                life.maxStepLog--;
+            }
+        }
+    }
+}
+
+void hashAdvance(HashLife &life, uint64_t generations){
+    while(generations > 0){
+        int stepLog = 0; // log2 of the largest power of two not above generations
+        while(stepLog < 63 && (generations >> (stepLog + 1)) != 0){
+            stepLog++;
+        }
+        stepLog = std::min(stepLog, life.maxStepLog);
+        hashStep(life, stepLog);
+        generations -= (uint64_t)1 << stepLog;
+    }
+}
+
+uint64_t hashPopulation(const HashLife &life){
+    return life.nodes[life.root].population;
+}
+
+static NodeIndex buildNode(HashLife &life, const TableType &table, int level, int x, int y){
+    if(x >= table.width || y >= table.height){
+        return life.emptyNodes[level];
+    }
+    if(level == 0){
+        return tableRow(table, y)[x] ? 1 : 0;
+    }
+
+    int half = 1 << (level - 1);
+    NodeIndex nw = buildNode(life, table, level - 1, x, y);
+    NodeIndex ne = buildNode(life, table, level - 1, x + half, y);
+    NodeIndex sw = buildNode(life, table, level - 1, x, y + half);
+    NodeIndex se = buildNode(life, table, level - 1, x + half, y + half);
+    return makeNode(life, nw, ne, sw, se);
+}
+
+void hashLoadTable(HashLife &life, const TableType &table){
+    int level = 3; // The smallest level whose square covers the matrix
+
+    while((1 << level) < std::max(table.width, table.height)){
+        level++;
+    }
+    life.root = buildNode(life, table, level, 0, 0);
+    life.originX = 0;
+    life.originY = 0;
+}
+
+static void storeNode(const HashLife &life, NodeIndex node, int64_t x, int64_t y, TableType &table){
+    const HashNode &square = life.nodes[node];
+    int64_t side = (int64_t)1 << square.level;
+
+    if(square.population == 0 || x >= table.width || y >= table.height || x + side <= 0 || y + side <= 0){
+        return;
+    }
+    if(square.level == 0){
+        tableRow(table, (int)y)[x] = 1;
+        return;
+    }
+
+    storeNode(life, square.nw, x, y, table);
+    storeNode(life, square.ne, x + side / 2, y, table);
+    storeNode(life, square.sw, x, y + side / 2, table);
+    storeNode(life, square.se, x + side / 2, y + side / 2, table);
+}
+
+void hashStoreTable(const HashLife &life, TableType &table){
+    int y;
+
+    for(y=0; y < table.height; y++){
+        std::memset(tableRow(table, y), 0, table.width * sizeof(int));
+    }
+    storeNode(life, life.root, life.originX, life.originY, table);
+}
+
+static void markNode(HashLife &life, NodeIndex node, bool keepResults){
+    HashNode &square = life.nodes[node];
+
+    if(square.marked){
+        return;
+    }
+    square.marked = 1;
+    if(square.level > 0){
+        NodeIndex nw = square.nw, ne = square.ne, sw = square.sw, se = square.se, result = square.result;
+        markNode(life, nw, keepResults);
+        markNode(life, ne, keepResults);
+        markNode(life, sw, keepResults);
+        markNode(life, se, keepResults);
+        if(keepResults && result != NO_NODE){
+            markNode(life, result, keepResults);
+        }
+    }
+}
+
+void hashCollectGarbage(HashLife &life, bool keepResults){
+    int level;
+    size_t i;
+
+    // Mark everything reachable from the root and the shared empty squares
+    life.nodes[0].marked = 1;
+    life.nodes[1].marked = 1;
+    for(level=1; level <= HASH_MAX_LEVEL; level++){
+        markNode(life, life.emptyNodes[level], keepResults);
+    }
+    markNode(life, life.root, keepResults);
+
+    // Sweep: rebuild the hash chains from the marked nodes and free the rest
+    std::fill(life.buckets.begin(), life.buckets.end(), NO_NODE);
+    life.freeList = NO_NODE;
+    life.liveNodes = 0;
+    for(i = life.nodes.size(); i-- > 0; ){
+        HashNode &node = life.nodes[i];
+        if(node.marked){
+            node.marked = 0;
+            if(!keepResults){
+                node.result = NO_NODE;
+                node.resultStep = -1;
+            }
+            if(node.level > 0){
+                size_t bucket = hashChildren(node.nw, node.ne, node.sw, node.se) & (life.buckets.size() - 1);
+                node.next = life.buckets[bucket];
+                life.buckets[bucket] = (NodeIndex)i;
+            }
+            life.liveNodes++;
+        }
+        else{
+            node.level = -1;
+            node.population = 0;
+            node.result = NO_NODE;
+            node.next = life.freeList;
+            life.freeList = (NodeIndex)i;
+        }
+    }
+}
+
+// The fingerprint of a plane is the sum over its living cells (x, y) of X^x * Y^y, modulo 2^64.
+// A square's sum, measured from its own corner, is built from its quadrants' sums shifted by
+// powers of X and Y, so shared squares are only visited once and the layout of the tree does not matter.
+
+static uint64_t powerOf(uint64_t base, int64_t exponent){
+    uint64_t result = 1;
+    uint64_t inverse = base; // base^-1 modulo 2^64, by Newton's method; base is odd
+
+    if(exponent < 0){
+        for(int i=0; i < 6; i++){
+            inverse *= 2 - base * inverse;
+        }
+        base = inverse;
+        exponent = -exponent;
+    }
+    while(exponent > 0){
+        if(exponent & 1){
+            result *= base;
+        }
+        base *= base;
+        exponent >>= 1;
+    }
+    return result;
+}
+
+static uint64_t nodePlaneHash(const HashLife &life, NodeIndex node, const uint64_t *stepX, const uint64_t *stepY,
+                              std::unordered_map<NodeIndex, uint64_t> &memo){
+    const HashNode &square = life.nodes[node];
+
+    if(square.population == 0){
+        return 0;
+    }
+    if(square.level == 0){
+        return 1;
+    }
+
+    auto found = memo.find(node);
+    if(found != memo.end()){
+        return found->second;
+    }
+    int half = square.level - 1; // log2 of the side of a quadrant
+    uint64_t sum = nodePlaneHash(life, square.nw, stepX, stepY, memo)
+                 + stepX[half] * nodePlaneHash(life, square.ne, stepX, stepY, memo)
+                 + stepY[half] * nodePlaneHash(life, square.sw, stepX, stepY, memo)
+                 + stepX[half] * stepY[half] * nodePlaneHash(life, square.se, stepX, stepY, memo);
+    memo[node] = sum;
+    return sum;
+}
+
+uint64_t hashPlaneHash(const HashLife &life){
+    uint64_t stepX[HASH_MAX_LEVEL + 1]; // X^(2^k)
+    uint64_t stepY[HASH_MAX_LEVEL + 1]; // Y^(2^k)
+    std::unordered_map<NodeIndex, uint64_t> memo; // Sums of the squares visited so far
+    int level;
+
+    stepX[0] = PLANE_HASH_X;
+    stepY[0] = PLANE_HASH_Y;
+    for(level=1; level <= HASH_MAX_LEVEL; level++){
+        stepX[level] = stepX[level - 1] * stepX[level - 1];
+        stepY[level] = stepY[level - 1] * stepY[level - 1];
+    }
+    uint64_t sum = powerOf(PLANE_HASH_X, life.originX) * powerOf(PLANE_HASH_Y, life.originY)
+                 * nodePlaneHash(life, life.root, stepX, stepY, memo);
+
+    // Mix the bits, since the low bits of the sum only follow the population
+    sum ^= sum >> 29;
+    sum *= 0xBF58476D1CE4E5B9ull;
+    sum ^= sum >> 32;
+    return sum;
+}
+
+static void listNode(const HashLife &life, NodeIndex node, int64_t x, int64_t y,
+                     std::vector<std::pair<int64_t, int64_t> > &cells){
+    const HashNode &square = life.nodes[node];
+    int64_t half; // The side of a quadrant
+
+    if(square.population == 0){
+        return;
+    }
+    if(square.level == 0){
+        cells.push_back(std::make_pair(y, x));
+        return;
+    }
+    half = (int64_t)1 << (square.level - 1);
+    listNode(life, square.nw, x, y, cells);
+    listNode(life, square.ne, x + half, y, cells);
+    listNode(life, square.sw, x, y + half, cells);
+    listNode(life, square.se, x + half, y + half, cells);
+}
+
+void hashLiveCells(const HashLife &life, std::vector<int64_t> &cells){
+    std::vector<std::pair<int64_t, int64_t> > found; // (y, x) of each living cell
+
+    found.reserve(hashPopulation(life));
+    listNode(life, life.root, life.originX, life.originY, found);
+    std::sort(found.begin(), found.end());
+    cells.clear();
+    cells.reserve(found.size() * 2);
+    for(size_t i=0; i < found.size(); i++){
+        cells.push_back(found[i].second);
+        cells.push_back(found[i].first);
+    }
+}
@@ -0,0 +1,145 @@
+// Conway's Game of Life
+// hashlife.h
+//
+// HashLife engine. The plane is a quadtree whose nodes are hash-consed, so every distinct
+// square of cells is stored only once, and each node remembers its own future. A node
+// of level k covers 2^k x 2^k cells; its result is the centre 2^(k-1) x 2^(k-1) square
+// advanced up to 2^(k-2) generations, built from the results of its children. That lets
+// the engine jump 2^j generations in one call, however large j is.
+//
+// The plane is unbounded: cells past the edge of the seed are simply dead, so results
+// match the dead-border engines for as long as the pattern stays clear of their edge.
+// For the same reason the rule must not give birth with 0 neighbors (B0), which would
+// fill the whole plane at once.
+
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "grid.h"
+#include "rule.h"
+
+// NodeIndex
+// Purpose: refers to a node by its position in the node pool
+typedef uint32_t NodeIndex;
+
+#define NO_NODE 0xFFFFFFFFu
+#define HASH_MAX_LEVEL 62
+
+// HashNode
+// Purpose: one square of the quadtree. Level 0 nodes are single cells; node 0 is dead and node 1 is alive.
+struct HashNode{
+    NodeIndex nw, ne, sw, se; // The four quadrants, each one level down
+    NodeIndex next; // The next node in the same hash bucket, or the next free node
+    NodeIndex result; // The remembered successor, or NO_NODE
+    uint64_t population; // The number of living cells in the square
+    int8_t level; // log2 of the side of the square; -1 for a free slot
+    int8_t resultStep; // log2 of the number of generations result is advanced
+    uint8_t marked; // Set while collecting garbage
+};
+
+// HashLife
+// Purpose: the node pool, its hash table and the current state of the plane
+struct HashLife{
+    std::vector<HashNode> nodes; // Every node, free slots included
+    std::vector<NodeIndex> buckets; // Heads of the hash chains
+    NodeIndex freeList; // The first free slot in nodes, or NO_NODE
+    size_t liveNodes; // The number of slots in use
+    size_t maxNodes; // The soft cap on liveNodes; garbage is collected between steps to stay under it
+    int maxStepLog; // The largest single step taken, lowered whenever a step overruns the cap
+    NodeIndex emptyNodes[HASH_MAX_LEVEL + 1]; // The empty square of each level
+    NodeIndex root; // The square holding every living cell
+    int64_t originX; // The plane x position of the left edge of root
+    int64_t originY; // The plane y position of the top edge of root
+    LifeRule rule; // The rule every remembered result was worked out with
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// initHashLife
+// Purpose: set up an empty plane
+// Input:
+//      life - the engine to set up
+//      maxBytes - roughly how much memory the node cache may use
+//      rule - the rule to apply; it must not contain B0
+// Output:
+//      No return type.
+void initHashLife(HashLife &life, size_t maxBytes, const LifeRule &rule);
+
+// hashLoadTable
+// Purpose: replace the plane with the contents of a matrix, its top-left cell at (0, 0)
+// Input:
+//      life - the engine to load into
+//      table - the matrix to copy
+// Output:
+//      No return type.
+void hashLoadTable(HashLife &life, const TableType &table);
+
+// hashStoreTable
+// Purpose: copy the square of the plane covered by a matrix back into it
+// Input:
+//      life - the engine to copy from
+//      table - the matrix to fill; cells (0, 0) to (width-1, height-1) of the plane are copied
+// Output:
+//      No return type.
+void hashStoreTable(const HashLife &life, TableType &table);
+
+// hashStep
+// Purpose: advance the plane by 2^stepLog generations
+// Input:
+//      life - the engine to advance
+//      stepLog - log2 of the number of generations; at most HASH_MAX_LEVEL - 3
+// Output:
+//      No return type.
+void hashStep(HashLife &life, int stepLog);
+
+// hashAdvance
+// Purpose: advance the plane by any number of generations
+// Input:
+//      life - the engine to advance
+//      generations - the number of generations
+// Output:
+//      No return type. Large counts are taken as a few power-of-two steps.
+void hashAdvance(HashLife &life, uint64_t generations);
+
+// hashPopulation
+// Purpose: count the living cells on the plane
+// Input:
+//      life - the engine to look at
+// Output:
+//      Returns the number of living cells.
+uint64_t hashPopulation(const HashLife &life);
+
+// hashPlaneHash
+// Purpose: fingerprint the living cells of the plane. The value depends only on which cells
+//          are alive, not on how the quadtree happens to be laid out over them.
+// Input:
+//      life - the engine to look at
+// Output:
+//      Returns the fingerprint. Equal planes always give equal values.
+uint64_t hashPlaneHash(const HashLife &life);
+
+// hashLiveCells
+// Purpose: list every living cell of the plane
+// Input:
+//      life - the engine to look at
+//      cells - receives the x and y position of each living cell in turn, sorted by y then x
+// Output:
+//      No return type.
+void hashLiveCells(const HashLife &life, std::vector<int64_t> &cells);
+
+// hashCollectGarbage
+// Purpose: free every node that the current plane no longer needs
+// Input:
+//      life - the engine to clean up
+//      keepResults - whether remembered successors of the surviving nodes are kept as well
+// Output:
+//      No return type.
+void hashCollectGarbage(HashLife &life, bool keepResults);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // HASHLIFE_H
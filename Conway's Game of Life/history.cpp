@@ -0,0 +1,527 @@
+// Conway's Game of Life
+// history.cpp
+//
+// Writing history logs in the background and seeking in them. See history.h.
+
+#include "history.h"
+#include <algorithm>
+#include <cstring>
+
+#define HISTORY_BUFFER_BYTES (1 << 20)
+
+static_assert(sizeof(HistoryHeader) == 64, "the history header is written as it is laid out in memory");
+static_assert(sizeof(HistoryIndexEntry) == 16, "index entries are written as they are laid out in memory");
+
+// putVarint
+// Purpose: append a number to a buffer, seven bits a byte, low bits first
+// Input:
+//      out - the buffer
+//      value - the number
+// Output:
+//      No return type.
+static void putVarint(std::vector<uint8_t> &out, uint64_t value){
+    while(value >= 0x80){
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+// getVarint
+// Purpose: read a number written by putVarint
+// Input:
+//      data - the buffer
+//      end - one past its last byte
+//      position - where the number starts; moved past it
+//      value - receives the number
+// Output:
+//      Returns false if the buffer ends in the middle of the number.
+static bool getVarint(const uint8_t *data, size_t end, size_t &position, uint64_t &value){
+    int shift = 0; // Where the next seven bits go
+
+    value = 0;
+    while(position < end && shift < 64){
+        uint8_t byte = data[position++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0){
+            return true;
+        }
+        shift += 7;
+    }
+    return false;
+}
+
+// encodeWordRuns
+// Purpose: write the words that differ between two boards as runs
+// Input:
+//      out - receives HISTORY_WORD_RUNS and the runs; cleared first
+//      board - the new board
+//      before - the old board, or nullptr for an empty one
+//      count - the number of words in each board
+// Output:
+//      No return type. Zero words at the end are left out.
+static void encodeWordRuns(std::vector<uint8_t> &out, const uint64_t *board, const uint64_t *before, size_t count){
+    size_t i = 0; // The word currently being looked at
+    size_t start; // The first word of a run
+
+    out.clear();
+    out.push_back(HISTORY_WORD_RUNS);
+    while(i < count){
+        start = i;
+        while(i < count && board[i] == (before ? before[i] : 0)){
+            i++;
+        }
+        if(i == count){
+            break;
+        }
+        putVarint(out, i - start);
+
+        start = i;
+        while(i < count && board[i] != (before ? before[i] : 0)){
+            i++;
+        }
+        putVarint(out, i - start);
+        for(size_t j=start; j < i; j++){
+            uint64_t word = board[j] ^ (before ? before[j] : 0); // The bits that changed
+            size_t at = out.size(); // Where the word goes
+            out.resize(at + sizeof(word));
+            std::memcpy(&out[at], &word, sizeof(word));
+        }
+    }
+}
+
+// encodeCellGaps
+// Purpose: write the cells that differ between two boards as the gaps between them
+// Input:
+//      out - receives HISTORY_CELL_GAPS and the gaps; cleared first
+//      board, before, count - as for encodeWordRuns
+//      limit - give up once out would be this many bytes or more
+// Output:
+//      Returns false if it gave up.
+static bool encodeCellGaps(std::vector<uint8_t> &out, const uint64_t *board, const uint64_t *before, size_t count,
+                           size_t limit){
+    uint64_t next = 0; // The cell after the last one written
+
+    out.clear();
+    out.push_back(HISTORY_CELL_GAPS);
+    for(size_t i=0; i < count; i++){
+        uint64_t word = board[i] ^ (before ? before[i] : 0); // The bits that changed
+        while(word != 0){
+            uint64_t cell = (uint64_t)i * 64 + __builtin_ctzll(word); // The number of the changed cell
+            putVarint(out, cell - next);
+            next = cell + 1;
+            word &= word - 1;
+        }
+        if(out.size() >= limit){
+            return false;
+        }
+    }
+    return true;
+}
+
+// encodeDelta
+// Purpose: write what differs between two boards, as word runs or cell gaps, whichever is smaller
+// Input:
+//      out - receives the payload; cleared first, and left empty if nothing differs
+//      spare - room to try the other coding in
+//      board - the new board
+//      before - the old board, or nullptr for an empty one
+//      count - the number of words in each board
+// Output:
+//      No return type.
+static void encodeDelta(std::vector<uint8_t> &out, std::vector<uint8_t> &spare, const uint64_t *board,
+                        const uint64_t *before, size_t count){
+    encodeWordRuns(out, board, before, count);
+    if(out.size() == 1){
+        out.clear();
+    }
+    else if(encodeCellGaps(spare, board, before, count, out.size())){
+        out.swap(spare);
+    }
+}
+
+// applyDelta
+// Purpose: turn a board into the next one by applying a payload written by encodeDelta
+// Input:
+//      data - the payload
+//      length - its size in bytes
+//      board - the board to change
+//      count - the number of words in the board
+// Output:
+//      Returns false if the payload does not fit the board.
+static bool applyDelta(const uint8_t *data, size_t length, uint64_t *board, size_t count){
+    size_t position = 1; // The next byte of data
+    size_t i = 0; // The word the next run starts at
+    uint64_t skip; // Words left as they are
+    uint64_t words; // Words changed
+    uint64_t next = 0; // The cell after the last one changed
+    uint64_t gap; // Cells left as they are
+
+    if(length == 0){
+        return true;
+    }
+    if(data[0] == HISTORY_CELL_GAPS){
+        while(position < length){
+            if(!getVarint(data, length, position, gap) || gap >= (uint64_t)count * 64 - next){
+                return false;
+            }
+            next += gap;
+            board[next / 64] ^= (uint64_t)1 << (next % 64);
+            next++;
+        }
+        return true;
+    }
+    if(data[0] != HISTORY_WORD_RUNS){
+        return false;
+    }
+    while(position < length){
+        if(!getVarint(data, length, position, skip) || !getVarint(data, length, position, words)
+           || skip > count - i || words > count - i - skip || words > (length - position) / sizeof(uint64_t)){
+            return false;
+        }
+        i += skip;
+        for(uint64_t j=0; j < words; j++, i++){
+            uint64_t word; // The bits that changed
+            std::memcpy(&word, data + position, sizeof(word));
+            board[i] ^= word;
+            position += sizeof(word);
+        }
+    }
+    return true;
+}
+
+// HistoryRecord
+// Purpose: where one record of a log is, once its head has been read
+struct HistoryRecord{
+    uint8_t kind; // HISTORY_KEYFRAME or HISTORY_DELTA
+    unsigned long long generation; // Keyframes only: the generation stored in the record
+    size_t payload; // Where the payload starts
+    size_t end; // One past the end of the payload
+};
+
+// readRecord
+// Purpose: read the head of the record at a position in a log
+// Input:
+//      reader - the open log
+//      position - where the record starts
+//      record - receives where its parts are
+// Output:
+//      Returns false if there is no whole record there.
+static bool readRecord(const HistoryReader &reader, size_t position, HistoryRecord &record){
+    const uint8_t *data = (const uint8_t *)reader.file.data;
+    size_t size = reader.file.size;
+    uint64_t length; // The size of the payload
+    uint64_t generation; // The generation stored in a keyframe
+
+    if(position >= size){
+        return false;
+    }
+    record.kind = data[position++];
+    if(record.kind == HISTORY_KEYFRAME){
+        if(size - position < sizeof(generation)){
+            return false;
+        }
+        std::memcpy(&generation, data + position, sizeof(generation));
+        record.generation = generation;
+        position += sizeof(generation);
+    }
+    else if(record.kind != HISTORY_DELTA){
+        return false;
+    }
+    if(!getVarint(data, size, position, length) || length > size - position){
+        return false;
+    }
+    record.payload = position;
+    record.end = position + (size_t)length;
+    return true;
+}
+
+HistoryWriter::HistoryWriter() : first(0), queued(0), log(nullptr), index(nullptr), offset(0), firstGeneration(0),
+                                 keyframeEvery(DEFAULT_KEYFRAME_EVERY), stopping(false), failed(false){
+    writer = std::thread(&HistoryWriter::writerLoop, this);
+}
+
+HistoryWriter::~HistoryWriter(){
+    {
+        std::unique_lock<std::mutex> hold(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+    if(log != nullptr){
+        std::fclose(log);
+        std::fclose(index);
+    }
+}
+
+bool HistoryWriter::open(const char *path, const Simulation &sim, unsigned keyframeEvery){
+    std::string indexPath = std::string(path) + ".idx"; // Where the keyframe offsets go
+    HistoryHeader header;
+
+    log = std::fopen(path, "wb");
+    if(log == nullptr){
+        return false;
+    }
+    index = std::fopen(indexPath.c_str(), "wb");
+    if(index == nullptr){
+        std::fclose(log);
+        log = nullptr;
+        return false;
+    }
+    std::setvbuf(log, nullptr, _IOFBF, HISTORY_BUFFER_BYTES);
+
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, HISTORY_MAGIC, sizeof(header.magic));
+    header.version = HISTORY_VERSION;
+    header.byteOrder = HISTORY_BYTE_ORDER;
+    header.width = (uint32_t)sim.width;
+    header.height = (uint32_t)sim.height;
+    header.rowWords = (uint32_t)((sim.width + 63) / 64);
+    header.birth = sim.rule.birth;
+    header.survive = sim.rule.survive;
+    header.edgeMode = (uint32_t)sim.edgeMode;
+    header.keyframeEvery = keyframeEvery;
+    header.firstGeneration = sim.generation;
+    if(std::fwrite(&header, sizeof(header), 1, log) != 1){
+        failed = true;
+    }
+
+    offset = sizeof(header);
+    firstGeneration = sim.generation;
+    this->keyframeEvery = keyframeEvery;
+    previous.clear();
+    record(sim);
+    return true;
+}
+
+void HistoryWriter::record(const Simulation &sim){
+    std::unique_lock<std::mutex> hold(lock);
+    int slot; // Where the generation goes in frames
+
+    space.wait(hold, [this]{ return queued < HISTORY_QUEUE_DEPTH; });
+    slot = (first + queued) % HISTORY_QUEUE_DEPTH;
+    hold.unlock();
+
+    // The writer only touches the frames that are queued, so this one can be filled without the lock
+    frames[slot].generation = sim.generation;
+    snapshotSimulation(sim, frames[slot].words);
+
+    hold.lock();
+    queued++;
+    hold.unlock();
+    wake.notify_one();
+}
+
+bool HistoryWriter::close(){
+    std::unique_lock<std::mutex> hold(lock);
+
+    space.wait(hold, [this]{ return queued == 0; });
+    if(log != nullptr){
+        if(std::fclose(log) != 0){
+            failed = true;
+        }
+        if(std::fclose(index) != 0){
+            failed = true;
+        }
+        log = nullptr;
+        index = nullptr;
+    }
+    return !failed;
+}
+
+void HistoryWriter::writerLoop(){
+    std::unique_lock<std::mutex> hold(lock);
+
+    for(;;){
+        wake.wait(hold, [this]{ return queued > 0 || stopping; });
+        if(queued == 0){
+            return;
+        }
+        HistoryFrame &frame = frames[first];
+        hold.unlock();
+        writeFrame(frame);
+        hold.lock();
+        first = (first + 1) % HISTORY_QUEUE_DEPTH;
+        queued--;
+        space.notify_all();
+    }
+}
+
+void HistoryWriter::writeFrame(HistoryFrame &frame){
+    bool keyframe = (frame.generation - firstGeneration) % keyframeEvery == 0; // Whether the whole board is written
+    std::vector<uint8_t> head; // The kind, generation and length of the record
+    bool written; // Whether the record was written
+
+    if(keyframe){
+        uint64_t generation = frame.generation;
+        encodeDelta(payload, spare, frame.words.data(), nullptr, frame.words.size());
+        head.push_back(HISTORY_KEYFRAME);
+        head.resize(1 + sizeof(generation));
+        std::memcpy(&head[1], &generation, sizeof(generation));
+    }
+    else{
+        encodeDelta(payload, spare, frame.words.data(), previous.data(), frame.words.size());
+        head.push_back(HISTORY_DELTA);
+    }
+    putVarint(head, payload.size());
+
+    written = std::fwrite(head.data(), 1, head.size(), log) == head.size();
+    if(written && !payload.empty()){
+        written = std::fwrite(payload.data(), 1, payload.size(), log) == payload.size();
+    }
+    if(written && keyframe){
+        HistoryIndexEntry entry = { frame.generation, offset }; // Where the keyframe is
+        written = std::fwrite(&entry, sizeof(entry), 1, index) == 1;
+    }
+    offset += head.size() + payload.size();
+    previous.swap(frame.words);
+
+    if(!written){
+        std::lock_guard<std::mutex> hold(lock);
+        failed = true;
+    }
+}
+
+bool openHistory(const char *path, HistoryReader &reader, std::string &error){
+    std::string indexPath = std::string(path) + ".idx"; // Where the keyframe offsets are
+    MappedFile indexFile; // The index, if there is one
+    HistoryHeader &header = reader.header;
+    HistoryRecord record; // The record currently being looked at
+    size_t position = sizeof(HistoryHeader); // Where it starts
+    unsigned long long generation; // Its generation
+
+    if(!mapFile(path, reader.file)){
+        error = "could not open the history log";
+        return false;
+    }
+    if(reader.file.size < sizeof(header)){
+        error = "the file is too short to be a history log";
+        unmapFile(reader.file);
+        return false;
+    }
+    std::memcpy(&header, reader.file.data, sizeof(header));
+    if(std::memcmp(header.magic, HISTORY_MAGIC, sizeof(header.magic)) != 0){
+        error = "the file is not a history log";
+    }
+    else if(header.byteOrder != HISTORY_BYTE_ORDER){
+        error = "the history log was written on a machine with a different byte order";
+    }
+    else if(header.version != HISTORY_VERSION){
+        error = "the history log was written by a different version";
+    }
+    else if(header.width == 0 || header.height == 0 || header.width > 0x7FFFFFFF || header.height > 0x7FFFFFFF
+            || header.rowWords != (header.width + 63) / 64 || header.edgeMode > EDGE_MIRROR || header.keyframeEvery == 0){
+        error = "the history log header is damaged";
+    }
+    else{
+        error.clear();
+    }
+    if(!error.empty()){
+        unmapFile(reader.file);
+        return false;
+    }
+
+    // Take the keyframes from the index for as long as it agrees with the log; a run that was killed
+    // can leave either file a little ahead of the other
+    reader.keyframes.clear();
+    if(mapFile(indexPath.c_str(), indexFile)){
+        size_t entries = indexFile.size / sizeof(HistoryIndexEntry); // Whole entries in the index
+        for(size_t i=0; i < entries; i++){
+            HistoryIndexEntry entry;
+            std::memcpy(&entry, indexFile.data + i * sizeof(entry), sizeof(entry));
+            if((i == 0 ? entry.offset != sizeof(HistoryHeader) : entry.offset <= reader.keyframes.back().offset)
+               || !readRecord(reader, (size_t)entry.offset, record) || record.kind != HISTORY_KEYFRAME
+               || record.generation != entry.generation){
+                break;
+            }
+            reader.keyframes.push_back(entry);
+        }
+        unmapFile(indexFile);
+    }
+
+    // Walk the records after the last indexed keyframe, or all of them without an index, to find the end
+    generation = header.firstGeneration - 1;
+    if(!reader.keyframes.empty()){
+        position = (size_t)reader.keyframes.back().offset;
+        generation = reader.keyframes.back().generation - 1;
+    }
+    while(readRecord(reader, position, record)){
+        if(record.kind == HISTORY_KEYFRAME){
+            if(record.generation != generation + 1){
+                break;
+            }
+            if(reader.keyframes.empty() || reader.keyframes.back().offset != position){
+                HistoryIndexEntry entry = { record.generation, position }; // A keyframe the index is missing
+                reader.keyframes.push_back(entry);
+            }
+        }
+        else if(reader.keyframes.empty()){
+            break;
+        }
+        generation++;
+        position = record.end;
+    }
+
+    if(reader.keyframes.empty()){
+        error = "the history log has no whole keyframe";
+        unmapFile(reader.file);
+        return false;
+    }
+    reader.lastGeneration = generation;
+    reader.generation = header.firstGeneration;
+    reader.position = sizeof(HistoryHeader);
+    return true;
+}
+
+void closeHistory(HistoryReader &reader){
+    unmapFile(reader.file);
+    reader.keyframes.clear();
+}
+
+bool seekHistory(HistoryReader &reader, unsigned long long generation, std::vector<uint64_t> &words){
+    std::vector<HistoryIndexEntry>::const_iterator keyframe; // The last keyframe at or before the generation
+    HistoryRecord record; // The keyframe's record
+
+    if(generation < reader.header.firstGeneration || generation > reader.lastGeneration){
+        return false;
+    }
+    keyframe = std::upper_bound(reader.keyframes.begin(), reader.keyframes.end(), generation,
+                                [](unsigned long long g, const HistoryIndexEntry &entry){ return g < entry.generation; });
+    --keyframe;
+
+    if(!readRecord(reader, (size_t)keyframe->offset, record)){
+        return false;
+    }
+    words.assign((size_t)reader.header.height * reader.header.rowWords, 0);
+    if(!applyDelta((const uint8_t *)reader.file.data + record.payload, record.end - record.payload,
+                   words.data(), words.size())){
+        return false;
+    }
+    reader.generation = keyframe->generation;
+    reader.position = record.end;
+
+    while(reader.generation < generation){
+        if(!nextHistory(reader, words)){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool nextHistory(HistoryReader &reader, std::vector<uint64_t> &words){
+    HistoryRecord record; // The record of the next generation
+
+    if(reader.generation >= reader.lastGeneration || !readRecord(reader, reader.position, record)){
+        return false;
+    }
+    if(record.kind == HISTORY_KEYFRAME){
+        std::fill(words.begin(), words.end(), 0);
+    }
+    if(!applyDelta((const uint8_t *)reader.file.data + record.payload, record.end - record.payload,
+                   words.data(), words.size())){
+        return false;
+    }
+    reader.generation++;
+    reader.position = record.end;
+    return true;
+}
@@ -0,0 +1,198 @@
+// Conway's Game of Life
+// history.h
+//
+// History logs: every generation of a run, kept so any of them can be looked at again
+// without stepping the run over from its seed. A log starts with a 64-byte header and is
+// then only ever appended to, one record per generation:
+//
+//      'K' generation(8 bytes) length(varint) payload - a keyframe, the whole board
+//      'D' length(varint) payload - a delta, what changed since the generation before
+//
+// Boards are the packed rows of checkpoint.h. A payload holds the board XORed with the one
+// before it (with an empty board, for a keyframe), in whichever of two codings is smaller:
+//
+//      HISTORY_WORD_RUNS - runs of words: the number of zero words to skip, the number of words
+//                          that follow, then those words as they are, until the payload ends
+//      HISTORY_CELL_GAPS - the changed cells, each as the number of unchanged cells before it
+//
+// Runs suit busy boards and gaps the rest. An empty payload means nothing changed, so a board
+// that has settled down takes two bytes a generation.
+//
+// A keyframe comes every keyframeEvery generations, and the offset of each one is also
+// appended to a second file, the log's path with ".idx" added. Seeking reads the index,
+// jumps to the last keyframe at or before the generation asked for and applies the deltas
+// after it, so no seek decodes more than keyframeEvery records. A log whose index is missing
+// or does not match is scanned from the start instead.
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mappedfile.h"
+#include "simulation.h"
+
+#define HISTORY_MAGIC "LIFEHIST" // The first eight bytes of every log
+#define HISTORY_VERSION 1
+#define HISTORY_BYTE_ORDER 0x01020304u // Written in the machine's byte order, to spot files from another
+#define HISTORY_KEYFRAME 'K'
+#define HISTORY_DELTA 'D'
+#define HISTORY_WORD_RUNS 0 // The first byte of a payload coded as runs of words
+#define HISTORY_CELL_GAPS 1 // The first byte of a payload coded as gaps between changed cells
+#define DEFAULT_KEYFRAME_EVERY 1024
+#define HISTORY_QUEUE_DEPTH 16 // Generations the stepper may get ahead of the writer
+
+// HistoryHeader
+// Purpose: the start of a log file, written as it is laid out in memory
+struct HistoryHeader{
+    char magic[8]; // HISTORY_MAGIC, without its terminating zero
+    uint32_t version; // HISTORY_VERSION
+    uint32_t byteOrder; // HISTORY_BYTE_ORDER
+    uint32_t width; // The number of columns on the board
+    uint32_t height; // The number of rows on the board
+    uint32_t rowWords; // Words per row, (width + 63) / 64
+    uint16_t birth; // The rule, as in LifeRule
+    uint16_t survive;
+    uint32_t edgeMode; // The EdgeMode of the run
+    uint32_t keyframeEvery; // Generations from one keyframe to the next
+    uint64_t firstGeneration; // The generation of the first record, always a keyframe
+    uint8_t padding[16]; // Zero; rounds the header up to 64 bytes
+};
+
+// HistoryIndexEntry
+// Purpose: where one keyframe is, as stored in the index file
+struct HistoryIndexEntry{
+    uint64_t generation; // The generation of the keyframe
+    uint64_t offset; // Where its record starts in the log
+};
+
+// HistoryReader
+// Purpose: an open log and a position in it
+struct HistoryReader{
+    MappedFile file; // The log
+    HistoryHeader header; // Its header
+    std::vector<HistoryIndexEntry> keyframes; // Every keyframe, in order
+    unsigned long long lastGeneration; // The generation of the last whole record
+    unsigned long long generation; // The generation of the board last decoded
+    size_t position; // Where the record after it starts
+};
+
+class HistoryWriter{
+public:
+    // HistoryWriter
+    // Purpose: start the writer thread
+    HistoryWriter();
+
+    // ~HistoryWriter
+    // Purpose: write out what is still queued, close the log and stop the thread
+    ~HistoryWriter();
+
+    // open
+    // Purpose: create a log, replacing any with the same name, and queue the current generation as its first keyframe
+    // Input:
+    //      path - the file to write; path + ".idx" receives the index
+    //      sim - the simulation to record; the int, bit and byte engines only
+    //      keyframeEvery - generations from one keyframe to the next
+    // Output:
+    //      Returns false if the files could not be created.
+    bool open(const char *path, const Simulation &sim, unsigned keyframeEvery);
+
+    // record
+    // Purpose: queue the current generation, which must follow the one recorded last
+    // Input:
+    //      sim - the simulation to record
+    // Output:
+    //      No return type. The board is copied and the writer thread encodes and writes it, so this
+    //      only waits if the writer has fallen HISTORY_QUEUE_DEPTH generations behind.
+    void record(const Simulation &sim);
+
+    // close
+    // Purpose: write out what is still queued and close the log
+    // Input:
+    //      None.
+    // Output:
+    //      Returns false if any of the log could not be written.
+    bool close();
+
+private:
+    HistoryWriter(const HistoryWriter &);
+    HistoryWriter &operator=(const HistoryWriter &);
+
+    // HistoryFrame
+    // Purpose: one generation waiting to be written
+    struct HistoryFrame{
+        unsigned long long generation; // Its number
+        std::vector<uint64_t> words; // Its packed rows
+    };
+
+    void writerLoop();
+    void writeFrame(HistoryFrame &frame);
+
+    HistoryFrame frames[HISTORY_QUEUE_DEPTH]; // Ring of queued generations
+    int first; // The oldest queued generation in frames
+    int queued; // The number of queued generations
+    std::vector<uint64_t> previous; // writer: the generation written last
+    std::vector<uint8_t> payload; // writer: the record being encoded
+    std::vector<uint8_t> spare; // writer: the record in the other coding, to keep whichever is smaller
+    FILE *log; // The log file, or nullptr when closed
+    FILE *index; // The index file
+    uint64_t offset; // writer: the size of the log so far
+    unsigned long long firstGeneration; // The generation of the first keyframe
+    unsigned keyframeEvery; // Generations from one keyframe to the next
+    std::thread writer; // Encodes and writes the queued generations
+    std::mutex lock; // Guards first, queued, stopping and failed
+    std::condition_variable wake; // Signalled when a generation is queued or the writer is stopped
+    std::condition_variable space; // Signalled when a generation has been written
+    bool stopping; // Set when the writer is shutting down
+    bool failed; // Set when a write fails
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// openHistory
+// Purpose: map a log and find its keyframes
+// Input:
+//      path - the log to open; its index is read from path + ".idx" if it is there and matches
+//      reader - receives the open log
+//      error - receives why the log could not be opened
+// Output:
+//      Returns false if the file is not a log with at least one whole keyframe. A record cut short
+//      at the end, as left by a run that was killed, is ignored.
+bool openHistory(const char *path, HistoryReader &reader, std::string &error);
+
+// closeHistory
+// Purpose: release a log opened by openHistory
+// Input:
+//      reader - the log to release
+// Output:
+//      No return type.
+void closeHistory(HistoryReader &reader);
+
+// seekHistory
+// Purpose: decode any generation in a log
+// Input:
+//      reader - the open log; it is left positioned at the generation
+//      generation - the generation to decode, from header.firstGeneration to lastGeneration
+//      words - receives the board as packed rows
+// Output:
+//      Returns false if the generation is not in the log or its records are damaged.
+bool seekHistory(HistoryReader &reader, unsigned long long generation, std::vector<uint64_t> &words);
+
+// nextHistory
+// Purpose: move on to the generation after the one decoded last
+// Input:
+//      reader - the open log
+//      words - the board decoded last, which is turned into the next one
+// Output:
+//      Returns false at the end of the log or if the record is damaged.
+bool nextHistory(HistoryReader &reader, std::vector<uint64_t> &words);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // HISTORY_H
@@ -0,0 +1,98 @@
+// Conway's Game of Life
+// intlife.cpp
+//
+// The original cell-by-cell engine. See intlife.h.
+
+#include "intlife.h"
+#include <algorithm>
+#include <mutex>
+
+#define BANDS_PER_THREAD 8
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// iterateRowsWith
+// Purpose: iterateRows for either Conway's Life, worked out inline, or any rule, read from its table
+template<bool CONWAY>
+static void iterateRowsWith(const TableType &frontTable, TableType &backTable, int firstRow, int endRow,
+                            const LifeRule &rule, StepStats *stats);
+
+//// END FUNCTION PROTOTYPES ////
+
+void iterate(TableType &frontTable, TableType &backTable, EdgeMode edgeMode, const LifeRule &rule, ThreadPool &pool,
+             StepStats *stats){
+    std::mutex statsLock; // Guards stats while the bands add their counts to it
+
+    fillBorder(frontTable, edgeMode);
+
+    pool.parallelFor(0, frontTable.height, bandRows(frontTable.height, pool), [&](int firstRow, int endRow){
+        if(METRICS_ENABLED && stats != nullptr){
+            StepStats bandStats; // Counted without the lock, then added in once
+            clearStepStats(bandStats);
+            iterateRows(frontTable, backTable, firstRow, endRow, rule, &bandStats);
+            std::lock_guard<std::mutex> hold(statsLock);
+            mergeStepStats(*stats, bandStats);
+        }
+        else{
+            iterateRows(frontTable, backTable, firstRow, endRow, rule, nullptr);
+        }
+    });
+}
+
+void iterateRows(const TableType &frontTable, TableType &backTable, int firstRow, int endRow, const LifeRule &rule,
+                 StepStats *stats){
+    if(isConwayRule(rule)){
+        iterateRowsWith<true>(frontTable, backTable, firstRow, endRow, rule, stats);
+    }
+    else{
+        iterateRowsWith<false>(frontTable, backTable, firstRow, endRow, rule, stats);
+    }
+}
+
+template<bool CONWAY>
+static void iterateRowsWith(const TableType &frontTable, TableType &backTable, int firstRow, int endRow,
+                            const LifeRule &rule, StepStats *stats){
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+    int numOfNeighbors; // The number of live neighbors to the cell
+
+    for(y=firstRow; y < endRow; y++){
+        const int *front = tableRow(frontTable, y);
+        int *back = tableRow(backTable, y);
+        for(x=0; x < frontTable.width; x++){
+            numOfNeighbors = countNeighbors(frontTable, x, y);
+            if(CONWAY){
+                back[x] = (numOfNeighbors == 3) | ((numOfNeighbors == 2) & front[x]);
+            }
+            else{
+                calculateCell(frontTable, backTable, x, y, numOfNeighbors, rule);
+            }
+        }
+        if(METRICS_ENABLED && stats != nullptr){
+            countCellRow(*stats, front, back, frontTable.width, y);
+        }
+    }
+}
+
+int bandRows(int height, const ThreadPool &pool){
+    return std::max(1, height / (pool.threadCount() * BANDS_PER_THREAD));
+}
+
+int countNeighbors(const TableType &frontTable, int x, int y){
+    // The ghost border gives every cell eight neighbors to look at, even on the edge
+    // of the matrix, so they can simply be added up without any bounds checks
+    const int *above = tableRow(frontTable, y-1) + x;
+    const int *middle = tableRow(frontTable, y) + x;
+    const int *below = tableRow(frontTable, y+1) + x;
+
+    return above[-1] + above[0] + above[1]
+         + middle[-1] + middle[1]
+         + below[-1] + below[0] + below[1];
+}
+
+void calculateCell(const TableType &frontTable, TableType &backTable, int x, int y, int numOfNeighbors,
+                   const LifeRule &rule){
+    // The back matrix holds an older generation now that the matrices are swapped rather
+    // than copied, so every cell is written, including the ones that stay as they are
+    tableRow(backTable, y)[x] = rule.next[tableRow(frontTable, y)[x]][numOfNeighbors];
+}
@@ -0,0 +1,82 @@
+// Conway's Game of Life
+// intlife.h
+//
+// The original engine: the int matrix, stepped one cell at a time by counting each
+// cell's neighbors and applying the rules to it.
+
+#ifndef INTLIFE_H
+#define INTLIFE_H
+
+#include "grid.h"
+#include "metrics.h"
+#include "rule.h"
+#include "threadpool.h"
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// iterate
+// Purpose: update the matrix according to the game rules
+// Input:
+//      frontTable - the matrix that will be drawn
+//      backTable - the matrix on which operations are performed
+//      edgeMode - how cells on the edge of the matrix see past it
+//      rule - the birth and survival counts to apply
+//      pool - the threads that share the work, one band of rows at a time
+//      stats - counts of the step are added to it, with METRICS_ENABLED; nullptr to count nothing
+// Output:
+//      No return type. The function, once completed, will have written the next cycle to backTable.
+//      Swap the two matrices afterwards to make it the current cycle.
+void iterate(TableType &frontTable, TableType &backTable, EdgeMode edgeMode, const LifeRule &rule, ThreadPool &pool,
+             StepStats *stats);
+
+// iterateRows
+// Purpose: update one band of rows of the matrix according to the game rules
+// Input:
+//      frontTable - the matrix that will be drawn, with its ghost border filled
+//      backTable - the matrix on which operations are performed
+//      firstRow - the first row of the band
+//      endRow - one past the last row of the band
+//      rule - the birth and survival counts to apply
+//      stats - counts of the band are added to it, with METRICS_ENABLED; nullptr to count nothing
+// Output:
+//      No return type. Bands that do not overlap may be updated at the same time from different threads.
+void iterateRows(const TableType &frontTable, TableType &backTable, int firstRow, int endRow, const LifeRule &rule,
+                 StepStats *stats);
+
+// countNeighbors
+// Purpose: count the living neighbors surrounding a single cell
+// Input:
+//      frontTable - the matrix that was drawn last, with its ghost border filled
+//      x - the x position of the cell
+//      y - the y position of the cell
+// Output:
+//      Returns an integer containing the total number of living neighbors to the cell.
+int countNeighbors(const TableType &frontTable, int x, int y);
+
+// calculateCell
+// Purpose: determine whether a cell is alive or dead, and update it accordingly
+// Input:
+//      frontTable - the matrix that was drawn last
+//      backTable - the matrix on which operations are performed
+//      x - the x position of the cell
+//      y - the y position of the cell
+//      numOfNeighbors - the number of living neighbors to the cell
+//      rule - the birth and survival counts to apply
+// Output:
+//      No return type. The function, once completed, assigns the updated state of the cell to backTable.
+void calculateCell(const TableType &frontTable, TableType &backTable, int x, int y, int numOfNeighbors,
+                   const LifeRule &rule);
+
+// bandRows
+// Purpose: choose how many rows each thread takes at once
+// Input:
+//      height - the number of rows in the matrix
+//      pool - the threads that share the work
+// Output:
+//      Returns a band size that gives every thread several bands, so there is something left to steal.
+int bandRows(int height, const ThreadPool &pool);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // INTLIFE_H
@@ -3,18 +3,93 @@
 // Conway's Game of Life
 //
 // Program accepts a seed state for the matrix, then updates it
-// according to the standard rules for Conway's Game of Life
+// according to the standard rules for Conway's Game of Life, or any other Life-like rule
+//
+// Usage: GameOfLife [-engine int|bit|hash|sparse|byte] [-isa auto|scalar|sse2|avx2|avx512] [-size WIDTHxHEIGHT]
+//                   [-edge dead|torus|mirror] [-threads N] [-jump K] [-cache MB] [-seed FILE]
+//                   [-batch N [-every K] [-output FILE] [-population]] [-render text|ansi|half|braille] [-animate]
+//                   [-detect P [-stop]] [-rule RULE]
+//                   [-metrics FILE [-metrics-format csv|jsonl]] [-checkpoint FILE [-checkpoint-every N]] [-resume FILE]
+//                   [-history FILE [-keyframe-every N]]
+//      -engine int - step the int matrix one cell at a time (default)
+//      -engine bit - step a bit-packed copy of the matrix 64 cells at a time (see bitlife.h)
+//      -engine hash - step an unbounded quadtree copy of the matrix with HashLife (see hashlife.h)
+//      -engine sparse - step an unbounded tiled copy of the matrix, only where it changes (see sparselife.h)
+//      -engine byte - step a byte-per-cell copy of the matrix a SIMD vector at a time (see bytelife.h)
+//      -isa - byte engine only: the instruction set to step with (default auto, the widest the processor has)
+//      -size - the size of the matrix (default 25x25)
+//      -edge dead - everything outside the matrix is dead (default)
+//      -edge torus - the matrix wraps around at its edges
+//      -edge mirror - the matrix is reflected at its edges
+//      -threads - the number of threads that step each generation (default 1, 0 = one per core)
+//      -jump - hash engine only: advance 2^K generations each time (default 0, one generation)
+//      -cache - hash engine only: the most memory its node cache may use (default 1024)
+//      -seed - read the seed from a 0/1 grid, RLE or Life 1.06 file instead of asking for it cell by cell.
+//              Without -size an RLE file sets the size of the matrix from its header.
+//      -batch - run N generations without displaying or prompting, then write the final board.
+//               Without -seed the seed is read from standard input in the 0/1 grid format.
+//      -every - batch only: also write the board every K generations (default 0, final board only)
+//      -output - batch only: write to FILE instead of standard output
+//      -population - batch only: write "generation population" lines instead of whole boards
+//      -render text - print the whole matrix for every generation (default when not writing to a terminal)
+//      -render ansi - redraw only the cells that changed, shrinking big boards to fit the terminal (default)
+//      -render half - as ansi, with Unicode half blocks: two cells per character
+//      -render braille - as ansi, with Unicode braille: eight cells per character
+//      -animate - keep stepping and redrawing without asking to continue, until Ctrl+C
+//      -detect - report when the board dies out, stops changing or repeats with a period up to P.
+//                Batch runs skip the rest of the run once it repeats.
+//      -stop - with -detect: end the run as soon as one of those is found
+//      -rule - the birth and survival counts as a rulestring, such as B36/S23 for HighLife or B2/S for Seeds
+//              (default B3/S23, or the rule in the header of an RLE seed). The hash and sparse engines
+//              do not support rules with B0.
+//      -metrics - write the population, births, deaths, bounding box, step time and render time of every
+//                 generation to FILE ("-" for standard error), and a histogram of step times at exit.
+//                 Only in builds with -DLIFE_METRICS (see metrics.h). Batch runs step one generation at a time.
+//      -metrics-format - csv (default) or jsonl, one JSON object per line
+//      -checkpoint - int, bit and byte engines only: save the board to FILE when the run ends, in the binary
+//                    format of checkpoint.h, replacing the last checkpoint only once the new one is written
+//      -checkpoint-every - with -checkpoint: also save it every N generations, from a background thread.
+//                          A checkpoint that comes due while the last one is still being written is skipped.
+//      -resume - int, bit and byte engines only: carry on from a checkpoint, which sets the size, the generation
+//                and (unless -rule or -edge is given) the rule and edge mode. Not with -seed or -size.
+//      -history - int, bit and byte engines only: log every generation to FILE (see history.h), from a background
+//                 thread, for LifeReplay to play back or seek in. Batch runs step one generation at a time.
+//      -keyframe-every - with -history: store the whole board every N generations, and only what changed in
+//                        between (default 1024). Smaller values make seeking faster and the log bigger.
+//
+// Build: g++ -O2 -pthread main.cpp grid.cpp intlife.cpp bitlife.cpp bytelife.cpp threadpool.cpp hashlife.cpp
+//            sparselife.cpp simulation.cpp patternio.cpp mappedfile.cpp render.cpp cycle.cpp rule.cpp metrics.cpp
+//            checkpoint.cpp history.cpp -o GameOfLife
 
 #include <iostream>
-
-#define WIDTH 25
-#define HEIGHT 25
-#define ALIVE 1
-#define DEAD 0
-
-// TableType
-// Purpose: stores a matrix of integers, either 1 or 0, representing living and dead cells
-typedef int TableType[WIDTH][HEIGHT];
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <csignal>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "grid.h"
+#include "bitlife.h"
+#include "threadpool.h"
+#include "hashlife.h"
+#include "simulation.h"
+#include "patternio.h"
+#include "render.h"
+#include "cycle.h"
+#include "rule.h"
+#include "metrics.h"
+#include "checkpoint.h"
+#include "history.h"
+
+#define DEFAULT_WIDTH 25
+#define DEFAULT_HEIGHT 25
+#define DEFAULT_CACHE_MB 1024
+#define BATCH_BUFFER_BYTES (1 << 20)
+#define STATUS_LINES 6 // Lines under the board used by the status, the prompt and the echoed answer
+
+static volatile std::sig_atomic_t stopRequested = 0; // Set by requestStop to end an -animate run
 
 
 //// BEGIN FUNCTION PROTOTYPES ////
@@ -23,49 +98,82 @@ typedef int TableType[WIDTH][HEIGHT];
 // Purpose: retrieve the initial state of the matrix from the user
 // Input:
 //      frontTable - the matrix that will be drawn
-//      backTable - the matrix on which operations are performed
 // Output:
-//      No return type. The function, once completed, will have assigned input to the backTable.
-void getSeed(TableType frontTable, TableType backTable);
+//      No return type. The function, once completed, will have assigned input to the frontTable.
+void getSeed(TableType &frontTable);
 
-// iterate
-// Purpose: update the matrix according to the game rules and display the next cycle
+// displaySimulation
+// Purpose: display the current generation of whichever engine is running
 // Input:
-//      frontTable - the matrix that will be drawn
-//      backTable - the matrix on which operations are performed
+//      sim - the simulation to draw
+//      displayTable - the matrix every engine but the int engine copies the board into to draw it
+//      renderer - draws the board
+//      status - text to display under the board
 // Output:
-//      No return type. The function, once completed, will advance the game by one cycle.
-void iterate(TableType frontTable, TableType backTable);
+//      No return type. The hash and sparse engines also display the population of the whole plane.
+void displaySimulation(const Simulation &sim, TableType &displayTable, Renderer &renderer, const std::string &status);
 
-// countNeighbors
-// Purpose: count the living neighbors surrounding a single cell
+// requestStop
+// Purpose: signal handler that ends an -animate run at the end of the current frame
 // Input:
-//      frontTable - the matrix that was drawn last
-//      x - the x position of the cell
-//      y - the y position of the cell
+//      signalNumber - the signal that arrived
 // Output:
-//      Returns an integer containing the total number of living neighbors to the cell.
-int countNeighbors(TableType frontTable, int x, int y);
+//      No return type. A second interrupt stops the program straight away.
+void requestStop(int signalNumber);
 
-// calculateCell
-// Purpose: determine whether a cell is alive or dead, and update it accordingly
+// runBatch
+// Purpose: advance the board without displaying or prompting, writing it out as it goes
 // Input:
-//      backTable - the matrix on which operations are performed
-//      x - the x position of the cell
-//      y - the y position of the cell
-//      numOfNeighbors - the number of living neighbors to the cell
+//      sim - the simulation to advance
+//      generations - the number of generations to run
+//      every - also write the board every this many generations; 0 writes only the final board
+//      output - the file to write to
+//      populationOnly - write only the generation and population instead of the board
+//      maxPeriod - look for cycles up to this period; 0 turns detection off
+//      stopOnCycle - stop as soon as a cycle is found instead of running to the end
+//      metrics - the log every generation is recorded in, stepping one at a time; nullptr for none
+//      checkpoints - saves the board every checkpointEvery generations; nullptr for none
+//      checkpointEvery - how often to save the board; 0 for only at the end
+//      checkpointPath - the file the board is saved to
+//      history - the log every generation is recorded in, stepping one at a time; nullptr for none.
+//                Once a cycle is found the rest of the run is still stepped, so the log has every generation.
 // Output:
-//      No return type. The function, once completed, assigns the updated state of the cell to backTable.
-void calculateCell(TableType backTable, int x, int y, int numOfNeighbors);
+//      No return type. A cycle is reported on a "#" comment line. Once one is found the rest of the
+//      run is skipped over, since every later generation repeats one already seen.
+void runBatch(Simulation &sim, unsigned long long generations, unsigned long long every,
+              FILE *output, bool populationOnly, int maxPeriod, bool stopOnCycle, MetricsLog *metrics,
+              CheckpointWriter *checkpoints, unsigned long long checkpointEvery, const char *checkpointPath,
+              HistoryWriter *history);
+
+// nextMultiple
+// Purpose: find where a run has to stop next for something that happens every so many generations
+// Input:
+//      generation - the current generation
+//      every - how often it happens; 0 for never
+//      limit - the furthest the run can go
+// Output:
+//      Returns the first multiple of every after generation, or limit if that comes first.
+unsigned long long nextMultiple(unsigned long long generation, unsigned long long every, unsigned long long limit);
 
-// printTable
-// Purpose: display the matrix with proper formatting to allow easy viewing of results
+// finalCheckpoint
+// Purpose: save the board at the end of a run, after any checkpoint still being written
 // Input:
-//      frontTable - the matrix that will be drawn
-//      backTable - the matrix on which operations are performed
+//      checkpoints - the writer
+//      sim - the simulation to save
+//      path - the file to save it to
+// Output:
+//      Returns false, after reporting it, if any checkpoint of the run could not be written.
+bool finalCheckpoint(CheckpointWriter &checkpoints, const Simulation &sim, const char *path);
+
+// checkRule
+// Purpose: make sure an engine can run a rule, reporting it if not
+// Input:
+//      engine - the engine that will step the board
+//      rule - the rule it will apply
 // Output:
-//      No return type. The function copies backTable to frontTable and then prints frontTable.
-void printTable(TableType frontTable, TableType backTable);
+//      Returns false for a rule with B0 on the hash or sparse engine: every empty cell of an
+//      unbounded plane would come to life at once.
+bool checkRule(EngineType engine, const LifeRule &rule);
 
 //// END FUNCTION PROTOTYPES ////
 
@@ -73,45 +181,470 @@ void printTable(TableType frontTable, TableType backTable);
 int main(int argc, char* argv[]){
 
     char quitProgram = ' ';
-    TableType frontTable; // The table that gets drawn
-    TableType backTable; // The table that is altered
-    int generation = 0; // The number of the current generation
+    Simulation sim; // The board and the engine that steps it
+    TableType seedTable; // The seed, handed to the engine once it is read
+    TableType displayTable; // The hash and sparse engines copy the board here to draw it
+    int width = DEFAULT_WIDTH; // The number of columns in the matrix
+    int height = DEFAULT_HEIGHT; // The number of rows in the matrix
+    bool sizeGiven = false; // Whether -size was given, rather than taking the size from the seed file
+    EdgeMode edgeMode = EDGE_DEAD; // How cells on the edge see past it
+    bool edgeGiven = false; // Whether -edge was given, rather than taking the edge mode from the checkpoint
+    EngineType engine = ENGINE_INT; // The engine that steps the matrix
+    ByteKernel byteKernel = BYTE_KERNEL_SCALAR; // The instruction set the byte engine steps with, if -isa was given
+    bool isaGiven = false; // Whether -isa was given, rather than choosing by the processor
+    double cellsPerSecond; // Stepping speed of the last generation
+    int numThreads = 1; // The number of threads that step each generation
+    int jumpLog = 0; // log2 of the generations the hash engine advances at a time
+    int cacheMegabytes = DEFAULT_CACHE_MB; // Memory the hash engine's node cache may use
+    const char *seedPath = nullptr; // File to read the seed from, if any
+    Pattern seedPattern; // The open seed file
+    const char *outputPath = nullptr; // File batch output goes to, if not standard output
+    bool batchMode = false; // Run headless instead of interactively
+    unsigned long long batchGenerations = 0; // Generations a batch run advances
+    unsigned long long writeEvery = 0; // Batch output interval; 0 = final board only
+    bool populationOnly = false; // Batch output is population lines instead of boards
+    Renderer renderer; // Draws the board in interactive runs
+    RenderMode renderMode = RENDER_TEXT; // How the board is drawn
+    bool renderGiven = false; // Whether -render was given, rather than choosing by the terminal
+    bool animate = false; // Step and redraw continuously instead of prompting
+    int maxPeriod = 0; // The longest cycle looked for; 0 = no detection
+    bool stopOnCycle = false; // End the run once a cycle is found
+    CycleDetector detector; // Watches interactive runs for cycles
+    LifeRule rule; // The birth and survival counts
+    bool ruleGiven = false; // Whether -rule was given, rather than taking the rule from the seed file
+    const char *metricsPath = nullptr; // File the per-generation metrics go to, if any
+    bool metricsJson = false; // Write the metrics as JSON lines instead of CSV
+    MetricsLog metrics; // The per-generation metrics
+    const char *checkpointPath = nullptr; // File the board is saved to, if any
+    unsigned long long checkpointEvery = 0; // Checkpoint interval; 0 = at the end only
+    const char *resumePath = nullptr; // Checkpoint to carry on from, if any
+    CheckpointWriter checkpoints; // Saves the board in the background
+    const char *historyPath = nullptr; // File every generation is logged to, if any
+    unsigned keyframeEvery = DEFAULT_KEYFRAME_EVERY; // Generations between whole boards in the log
+    bool keyframeGiven = false; // Whether -keyframe-every was given
+    HistoryWriter history; // Logs every generation in the background
+
+    makeRule(rule, RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVE);
+
+    for(int i=1; i < argc; i++){
+        if(std::strcmp(argv[i], "-engine") == 0 && i+1 < argc){
+            i++;
+            if(!parseEngineType(argv[i], engine)){
+                std::cout << "ERROR, unknown engine: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-isa") == 0 && i+1 < argc){
+            i++;
+            isaGiven = std::strcmp(argv[i], "auto") != 0;
+            if(isaGiven && !parseByteKernel(argv[i], byteKernel)){
+                std::cout << "ERROR, isa must be auto, scalar, sse2, avx2 or avx512: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-size") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%dx%d", &width, &height) != 2 || width < 1 || height < 1){
+                std::cout << "ERROR, size must look like 1024x768: " << argv[i] << "\n";
+                return 1;
+            }
+            sizeGiven = true;
+        }
+        else if(std::strcmp(argv[i], "-edge") == 0 && i+1 < argc){
+            i++;
+            if(!parseEdgeMode(argv[i], edgeMode)){
+                std::cout << "ERROR, unknown edge mode: " << argv[i] << "\n";
+                return 1;
+            }
+            edgeGiven = true;
+        }
+        else if(std::strcmp(argv[i], "-threads") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%d", &numThreads) != 1 || numThreads < 0){
+                std::cout << "ERROR, thread count must be 0 or more: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-jump") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%d", &jumpLog) != 1 || jumpLog < 0 || jumpLog > HASH_MAX_LEVEL - 3){
+                std::cout << "ERROR, jump must be from 0 to " << HASH_MAX_LEVEL - 3 << ": " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-cache") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%d", &cacheMegabytes) != 1 || cacheMegabytes < 1){
+                std::cout << "ERROR, cache size must be at least 1 MB: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-seed") == 0 && i+1 < argc){
+            seedPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-batch") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%llu", &batchGenerations) != 1 || argv[i][0] == '-'){
+                std::cout << "ERROR, batch must be a number of generations: " << argv[i] << "\n";
+                return 1;
+            }
+            batchMode = true;
+        }
+        else if(std::strcmp(argv[i], "-every") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%llu", &writeEvery) != 1 || argv[i][0] == '-'){
+                std::cout << "ERROR, every must be a number of generations: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-output") == 0 && i+1 < argc){
+            outputPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-population") == 0){
+            populationOnly = true;
+        }
+        else if(std::strcmp(argv[i], "-render") == 0 && i+1 < argc){
+            i++;
+            if(!parseRenderMode(argv[i], renderMode)){
+                std::cout << "ERROR, unknown render mode: " << argv[i] << "\n";
+                return 1;
+            }
+            renderGiven = true;
+        }
+        else if(std::strcmp(argv[i], "-animate") == 0){
+            animate = true;
+        }
+        else if(std::strcmp(argv[i], "-detect") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%d", &maxPeriod) != 1 || maxPeriod < 1){
+                std::cout << "ERROR, the longest period to detect must be at least 1: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-stop") == 0){
+            stopOnCycle = true;
+        }
+        else if(std::strcmp(argv[i], "-metrics") == 0 && i+1 < argc){
+            metricsPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-metrics-format") == 0 && i+1 < argc){
+            i++;
+            if(std::strcmp(argv[i], "csv") != 0 && std::strcmp(argv[i], "jsonl") != 0){
+                std::cout << "ERROR, metrics format must be csv or jsonl: " << argv[i] << "\n";
+                return 1;
+            }
+            metricsJson = (std::strcmp(argv[i], "jsonl") == 0);
+        }
+        else if(std::strcmp(argv[i], "-rule") == 0 && i+1 < argc){
+            i++;
+            if(!parseRule(argv[i], rule)){
+                std::cout << "ERROR, rule must look like B3/S23: " << argv[i] << "\n";
+                return 1;
+            }
+            ruleGiven = true;
+        }
+        else if(std::strcmp(argv[i], "-checkpoint") == 0 && i+1 < argc){
+            checkpointPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-checkpoint-every") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%llu", &checkpointEvery) != 1 || argv[i][0] == '-'){
+                std::cout << "ERROR, checkpoint-every must be a number of generations: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-resume") == 0 && i+1 < argc){
+            resumePath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-history") == 0 && i+1 < argc){
+            historyPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-keyframe-every") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%u", &keyframeEvery) != 1 || argv[i][0] == '-' || keyframeEvery < 1){
+                std::cout << "ERROR, keyframe-every must be at least 1: " << argv[i] << "\n";
+                return 1;
+            }
+            keyframeGiven = true;
+        }
+        else{
+            std::cout << "Usage: " << argv[0] << " [-engine int|bit|hash|sparse|byte] [-isa auto|scalar|sse2|avx2|avx512]"
+                      << " [-size WIDTHxHEIGHT] [-edge dead|torus|mirror] [-threads N] [-jump K] [-cache MB] [-seed FILE]"
+                      << " [-batch N [-every K] [-output FILE] [-population]] [-render text|ansi|half|braille] [-animate]"
+                      << " [-detect P [-stop]] [-rule RULE] [-metrics FILE [-metrics-format csv|jsonl]]"
+                      << " [-checkpoint FILE [-checkpoint-every N]] [-resume FILE] [-history FILE [-keyframe-every N]]\n";
+            return 1;
+        }
+    }
 
-    getSeed(frontTable, backTable); // Get the seed data from the user
+    if((engine == ENGINE_HASH || engine == ENGINE_SPARSE) && edgeMode != EDGE_DEAD){
+        std::cout << "ERROR, the " << ENGINE_NAMES[engine] << " engine runs on an unbounded plane and only supports -edge dead\n";
+        return 1;
+    }
+    if(isaGiven && engine != ENGINE_BYTE){
+        std::cout << "ERROR, -isa only applies with -engine byte\n";
+        return 1;
+    }
+    if(isaGiven && !byteKernelSupported(byteKernel)){
+        std::cout << "ERROR, this processor or build cannot run the " << BYTE_KERNEL_NAMES[byteKernel] << " kernel\n";
+        return 1;
+    }
+    if(!batchMode && (writeEvery != 0 || outputPath != nullptr || populationOnly)){
+        std::cout << "ERROR, -every, -output and -population only apply with -batch\n";
+        return 1;
+    }
+    if(stopOnCycle && maxPeriod == 0){
+        std::cout << "ERROR, -stop only applies with -detect\n";
+        return 1;
+    }
+    if(metricsPath != nullptr && !METRICS_ENABLED){
+        std::cout << "ERROR, -metrics needs a build with -DLIFE_METRICS\n";
+        return 1;
+    }
+    if((checkpointPath != nullptr || resumePath != nullptr) && (engine == ENGINE_HASH || engine == ENGINE_SPARSE)){
+        std::cout << "ERROR, checkpoints hold a bounded board, which the " << ENGINE_NAMES[engine] << " engine does not have\n";
+        return 1;
+    }
+    if(historyPath != nullptr && (engine == ENGINE_HASH || engine == ENGINE_SPARSE)){
+        std::cout << "ERROR, history logs hold a bounded board, which the " << ENGINE_NAMES[engine] << " engine does not have\n";
+        return 1;
+    }
+    if(keyframeGiven && historyPath == nullptr){
+        std::cout << "ERROR, -keyframe-every only applies with -history\n";
+        return 1;
+    }
+    if(checkpointEvery != 0 && checkpointPath == nullptr){
+        std::cout << "ERROR, -checkpoint-every only applies with -checkpoint\n";
+        return 1;
+    }
+    if(resumePath != nullptr && (seedPath != nullptr || sizeGiven)){
+        std::cout << "ERROR, -resume takes the board from the checkpoint and cannot be used with -seed or -size\n";
+        return 1;
+    }
 
-    do{
-        generation++;
-        iterate(frontTable, backTable); // Update the table by one cycle
-        std::cout << "\nGENERATION: " << generation << "\nEnter 'q' to quit or 'c' to continue: ";
-        std::cin >> quitProgram;
-        std::cout << "\n";
-    }while(quitProgram != 'q');
+    ThreadPool pool(numThreads); // Started once, reused every generation
 
-    return 0;
-}
+    if(resumePath != nullptr){
+        MappedFile checkpointFile; // The checkpoint, read straight from the mapping
+        CheckpointHeader header; // Its size, rule, edge mode and generation
+        std::string error; // Why it could not be opened
+        if(!openCheckpoint(resumePath, checkpointFile, header, error)){
+            std::cerr << "ERROR, " << error << ": " << resumePath << "\n";
+            return 1;
+        }
+        width = (int)header.width;
+        height = (int)header.height;
+        if(!ruleGiven){
+            makeRule(rule, header.birth, header.survive);
+        }
+        if(!edgeGiven){
+            edgeMode = (EdgeMode)header.edgeMode;
+        }
+        bool resumed;
+        try{
+            resumed = resumeCheckpoint(sim, engine, edgeMode, rule, pool, checkpointFile, header);
+        }
+        catch(const std::exception &){ // bad_alloc, or length_error for a size that does not even fit in memory
+            unmapFile(checkpointFile);
+            std::cerr << "ERROR, not enough memory for a " << width << "x" << height << " board\n";
+            return 1;
+        }
+        unmapFile(checkpointFile);
+        if(!resumed){
+            std::cerr << "ERROR, the cells in " << resumePath << " do not match its checksum\n";
+            return 1;
+        }
+    }
+    else if(seedPath != nullptr){
+        if(!openPattern(seedPath, seedPattern)){
+            std::cerr << "ERROR, could not open the pattern file " << seedPath << "\n";
+            return 1;
+        }
+        if(!sizeGiven && seedPattern.width > 0 && seedPattern.height > 0){
+            width = seedPattern.width; // RLE files say how big they are
+            height = seedPattern.height;
+        }
+        if(!ruleGiven && !seedPattern.rule.empty() && !parseRule(seedPattern.rule.c_str(), rule)){
+            std::cerr << "ERROR, unknown rule in " << seedPath << ": " << seedPattern.rule << "\n";
+            closePattern(seedPattern);
+            return 1;
+        }
+        if(!checkRule(engine, rule)){
+            closePattern(seedPattern);
+            return 1;
+        }
+        LoadResult loaded = loadSimulation(sim, engine, edgeMode, rule, pool, (size_t)cacheMegabytes << 20, seedPattern,
+                                           width, height);
+        closePattern(seedPattern);
+        if(loaded == LOAD_NO_MEMORY){
+            std::cerr << "ERROR, not enough memory for a " << width << "x" << height << " board\n";
+            return 1;
+        }
+        if(loaded == LOAD_BAD_PATTERN){
+            std::cerr << "ERROR, could not read a " << width << "x" << height << " board from " << seedPath << "\n";
+            return 1;
+        }
+    }
+    else{
+        if(!checkRule(engine, rule)){
+            return 1;
+        }
+        try{
+            initTable(seedTable, width, height);
+            if(batchMode){
+                if(!readGridPattern(std::cin, seedTable)){
+                    std::cerr << "ERROR, could not read a " << width << "x" << height << " 0/1 grid from standard input\n";
+                    return 1;
+                }
+            }
+            else{
+                getSeed(seedTable); // Get the seed data from the user
+            }
+            initSimulation(sim, engine, edgeMode, rule, pool, (size_t)cacheMegabytes << 20, seedTable);
+        }
+        catch(const std::exception &){ // bad_alloc, or length_error for a size that does not even fit in memory
+            std::cerr << "ERROR, not enough memory for a " << width << "x" << height << " board\n";
+            return 1;
+        }
+    }
 
-void iterate(TableType frontTable, TableType backTable){
-    int x; // The column currently being looked at
-    int y; // The row currently being looked at
-    int numOfNeighbors; // The number of live neighbors to the cell
+    if(isaGiven){
+        sim.byteKernel = byteKernel;
+    }
+    if(historyPath != nullptr && !history.open(historyPath, sim, keyframeEvery)){
+        std::cerr << "ERROR, could not open " << historyPath << " for writing\n";
+        return 1;
+    }
+    if(metricsPath != nullptr){
+        if(!openMetricsLog(metrics, metricsPath, metricsJson)){
+            std::cerr << "ERROR, could not open " << metricsPath << " for writing\n";
+            return 1;
+        }
+        sim.countStats = true;
+    }
 
-    for(x=0; x < WIDTH; x++){
-        for(y=0; y < HEIGHT; y++){
-            numOfNeighbors = countNeighbors(frontTable, x, y);
-            calculateCell(backTable, x, y, numOfNeighbors);
+    if(batchMode){
+        FILE *output = stdout; // Where the boards are written
+        if(outputPath != nullptr){
+            output = std::fopen(outputPath, "w");
+            if(output == nullptr){
+                std::cerr << "ERROR, could not open " << outputPath << " for writing\n";
+                return 1;
+            }
+        }
+        std::setvbuf(output, nullptr, _IOFBF, BATCH_BUFFER_BYTES);
+        runBatch(sim, batchGenerations, writeEvery, output, populationOnly, maxPeriod, stopOnCycle,
+                 (metricsPath != nullptr) ? &metrics : nullptr,
+                 (checkpointPath != nullptr) ? &checkpoints : nullptr, checkpointEvery, checkpointPath,
+                 (historyPath != nullptr) ? &history : nullptr);
+        if(std::fflush(output) != 0 || (output != stdout && std::fclose(output) != 0)){
+            std::cerr << "ERROR, could not finish writing the output\n";
+            return 1;
+        }
+        if(metricsPath != nullptr && !closeMetricsLog(metrics, stderr)){
+            std::cerr << "ERROR, could not finish writing the metrics\n";
+            return 1;
         }
+        if(checkpointPath != nullptr && !finalCheckpoint(checkpoints, sim, checkpointPath)){
+            return 1;
+        }
+        if(historyPath != nullptr && !history.close()){
+            std::cerr << "ERROR, could not finish writing the history log\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if(!renderGiven){
+        renderMode = outputIsTerminal() ? RENDER_ANSI : RENDER_TEXT;
+    }
+    initRenderer(renderer, renderMode, width, height, STATUS_LINES);
+    if(engine != ENGINE_INT){
+        initTable(displayTable, width, height);
+    }
+    if(animate){
+        std::signal(SIGINT, requestStop);
+    }
+    displaySimulation(sim, displayTable, renderer, ""); // Display the seed table
+    if(maxPeriod > 0){
+        initCycleDetector(detector, maxPeriod);
+        observeGeneration(detector, sim);
     }
 
-    printTable(frontTable, backTable);
+    auto lastFrame = std::chrono::high_resolution_clock::now(); // When the last frame was drawn
+    do{
+        std::ostringstream status; // The lines under the board
+        unsigned long long stepSize = (engine == ENGINE_HASH) ? 1ull << jumpLog : 1; // Generations per update
+        auto t_start = std::chrono::high_resolution_clock::now();
+        advanceSimulation(sim, stepSize); // Update the board
+        auto t_end = std::chrono::high_resolution_clock::now();
+        cellsPerSecond = (double)width * height * stepSize / std::chrono::duration<double>(t_end - t_start).count();
+
+        if(maxPeriod > 0){
+            observeGeneration(detector, sim);
+        }
+        if(checkpointEvery != 0 && sim.generation % checkpointEvery == 0){
+            checkpoints.submit(sim, checkpointPath);
+        }
+        if(historyPath != nullptr){
+            history.record(sim);
+        }
+
+        status << "\nGENERATION: " << sim.generation << " (" << ENGINE_NAMES[engine] << " engine, " << ruleName(rule) << ", "
+               << cellsPerSecond << " cells/second";
+        if(animate){
+            status << ", " << 1.0 / std::chrono::duration<double>(t_end - lastFrame).count() << " frames/second)";
+            status << "\nPress Ctrl+C to stop";
+        }
+        else{
+            status << ")\nEnter 'q' to quit or 'c' to continue: ";
+        }
+        if(maxPeriod > 0 && detector.kind != CYCLE_NONE){
+            status << "\n" << describeCycle(detector);
+        }
+        lastFrame = t_end;
+        displaySimulation(sim, displayTable, renderer, status.str());
+        if(metricsPath != nullptr){
+            auto t_drawn = std::chrono::high_resolution_clock::now();
+            recordGeneration(metrics, sim.generation, sim.stats,
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(t_end - t_start).count(),
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(t_drawn - t_end).count());
+        }
+
+        if(maxPeriod > 0 && stopOnCycle && detector.kind != CYCLE_NONE){
+            quitProgram = 'q';
+        }
+        else if(animate){
+            quitProgram = stopRequested ? 'q' : ' ';
+        }
+        else{
+            std::cin >> quitProgram;
+            std::cout << "\n";
+        }
+    }while(quitProgram != 'q');
+
+    finishRenderer(renderer);
+    if(metricsPath != nullptr && !closeMetricsLog(metrics, stderr)){
+        std::cerr << "ERROR, could not finish writing the metrics\n";
+        return 1;
+    }
+    if(checkpointPath != nullptr && !finalCheckpoint(checkpoints, sim, checkpointPath)){
+        return 1;
+    }
+    if(historyPath != nullptr && !history.close()){
+        std::cerr << "ERROR, could not finish writing the history log\n";
+        return 1;
+    }
+    return 0;
 }
 
-void getSeed(TableType frontTable, TableType backTable){
+void getSeed(TableType &frontTable){
     int x; // The column currently being looked at
     int y; // The row currently being looked at
     int input; // The number the user enters
 
-    for(y=0; y < HEIGHT; y++){
-        for(x=0; x < WIDTH; x++){
+    for(y=0; y < frontTable.height; y++){
+        for(x=0; x < frontTable.width; x++){
             std::cout << "Please enter data for cell " << x << "," << y << ". (1 = alive, 0 = dead): ";
             std::cin >> input;
             if((input != 1) && (input != 0)){
@@ -119,105 +652,117 @@ void getSeed(TableType frontTable, TableType backTable){
                 std::cout << "Please enter data for cell " << x << "," << y << ". (1 = alive, 0 = dead): ";
                 std::cin >> input;
             }
-            backTable[x][y] = input;
+            tableRow(frontTable, y)[x] = input;
             std::cout << "\n";
         }
     }
-    printTable(frontTable, backTable); // Display the seed table
 }
 
-int countNeighbors(TableType frontTable, int x, int y){
-    int numOfNeighbors = 0; // The number of live neighbors to the cell
-
-    // For this cell, count all living neighbors in the eight surrounding spaces
-
-    // check top-left cell
-    if(x>0 && y>0){
-        if(frontTable[x-1][y-1] == ALIVE){
-            numOfNeighbors++;
+void runBatch(Simulation &sim, unsigned long long generations, unsigned long long every,
+              FILE *output, bool populationOnly, int maxPeriod, bool stopOnCycle, MetricsLog *metrics,
+              CheckpointWriter *checkpoints, unsigned long long checkpointEvery, const char *checkpointPath,
+              HistoryWriter *history){
+    unsigned long long target = sim.generation + generations; // The generation the run stops at
+    unsigned long long next; // The next generation that is written or is the target
+    CycleDetector detector; // Watches for cycles when maxPeriod is set
+
+    if(maxPeriod > 0){
+        initCycleDetector(detector, maxPeriod);
+        if(observeGeneration(detector, sim)){
+            std::fprintf(output, "# %s\n", describeCycle(detector).c_str());
         }
     }
-    // check top cell
-    if(y>0){
-        if(frontTable[x][y-1] == ALIVE){
-            numOfNeighbors++;
+
+    while(sim.generation < target){
+        next = nextMultiple(sim.generation, every, target);
+        if(checkpoints != nullptr){
+            next = nextMultiple(sim.generation, checkpointEvery, next);
         }
-    }
-    // check top-right cell
-    if(x<WIDTH-1 && y>0){
-        if(frontTable[x+1][y-1] == ALIVE){
-            numOfNeighbors++;
+
+        if(maxPeriod > 0 && detector.kind != CYCLE_NONE && stopOnCycle){
+            break;
         }
-    }
-    // check left cell
-    if(x>0){
-        if(frontTable[x-1][y] == ALIVE){
-            numOfNeighbors++;
+        if(maxPeriod > 0 && detector.kind != CYCLE_NONE && history == nullptr){
+            // Generation next looks the same as the one (next - generation) mod period steps on
+            advanceSimulation(sim, (next - sim.generation) % detector.period);
+            sim.generation = next;
         }
-    }
-    // check right cell
-    if(x<WIDTH-1){
-        if(frontTable[x+1][y] == ALIVE){
-            numOfNeighbors++;
+        else if(maxPeriod > 0 || metrics != nullptr || history != nullptr){
+            auto t_start = std::chrono::high_resolution_clock::now();
+            advanceSimulation(sim, 1);
+            auto t_end = std::chrono::high_resolution_clock::now();
+            if(metrics != nullptr){
+                recordGeneration(*metrics, sim.generation, sim.stats,
+                                 std::chrono::duration_cast<std::chrono::nanoseconds>(t_end - t_start).count(), -1);
+            }
+            if(history != nullptr){
+                history->record(sim);
+            }
+            if(maxPeriod > 0 && observeGeneration(detector, sim)){
+                std::fprintf(output, "# %s\n", describeCycle(detector).c_str());
+            }
         }
-    }
-    // check bottom-left cell
-    if(x>0 && y<HEIGHT-1){
-        if(frontTable[x-1][y+1] == ALIVE){
-            numOfNeighbors++;
+        else{
+            advanceSimulation(sim, next - sim.generation);
         }
-    }
-    // check bottom cell
-    if(y<HEIGHT-1){
-        if(frontTable[x][y+1] == ALIVE){
-            numOfNeighbors++;
+
+        if(sim.generation < target && every != 0 && sim.generation % every == 0){
+            writeSimulation(output, sim, populationOnly);
         }
-    }
-    // check bottom-right cell
-    if(x<WIDTH-1 && y<HEIGHT-1){
-        if(frontTable[x+1][y+1] == ALIVE){
-            numOfNeighbors++;
+        if(sim.generation < target && checkpoints != nullptr && checkpointEvery != 0 && sim.generation % checkpointEvery == 0){
+            checkpoints->submit(sim, checkpointPath);
         }
     }
-
-    return numOfNeighbors;
+    writeSimulation(output, sim, populationOnly);
 }
 
-void calculateCell(TableType backTable, int x, int y, int numOfNeighbors){
-    if(numOfNeighbors < 2){
-        backTable[x][y] = DEAD;
+void displaySimulation(const Simulation &sim, TableType &displayTable, Renderer &renderer, const std::string &status){
+    std::ostringstream text; // The status, after the population line of the unbounded engines
+
+    if(sim.engine == ENGINE_HASH || sim.engine == ENGINE_SPARSE){
+        text << "\nPOPULATION: " << simulationPopulation(sim);
+        if(sim.engine == ENGINE_SPARSE){
+            text << " in " << sim.sparseLife.tiles.size() << " tiles";
+        }
     }
-    if(numOfNeighbors > 3){
-        backTable[x][y] = DEAD;
+    text << status;
+
+    if(sim.engine == ENGINE_INT){
+        renderFrame(renderer, sim.frontTable, text.str());
     }
-    if(numOfNeighbors == 3){
-        backTable[x][y] = ALIVE;
+    else{
+        storeSimulation(sim, displayTable);
+        renderFrame(renderer, displayTable, text.str());
     }
 }
 
-void printTable(TableType frontTable, TableType backTable){
-
-    int x; // The column currently being looked at
-    int y; // The row currently being looked at
+void requestStop(int signalNumber){
+    stopRequested = 1;
+    std::signal(signalNumber, SIG_DFL);
+}
 
-    // Update the front table with the information
-    for(x=0; x < WIDTH; x++){
-        for(y=0; y < HEIGHT; y++){
-            frontTable[x][y] = backTable[x][y];
-        }
+unsigned long long nextMultiple(unsigned long long generation, unsigned long long every, unsigned long long limit){
+    if(every != 0 && every - generation % every < limit - generation){
+        return generation + every - generation % every;
     }
+    return limit;
+}
 
-    std::cout << "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n"; // print 30 blank lines to clear display
+bool finalCheckpoint(CheckpointWriter &checkpoints, const Simulation &sim, const char *path){
+    checkpoints.finish();
+    checkpoints.submit(sim, path);
+    if(!checkpoints.finish()){
+        std::cerr << "ERROR, could not write the checkpoint " << path << "\n";
+        return false;
+    }
+    return true;
+}
 
-    for(y=0; y < HEIGHT; y++){
-        for(x=0; x < WIDTH; x++){
-            if(frontTable[x][y] == ALIVE){
-                std::cout << "#";
-            }
-            else{
-                std::cout << "_";
-            }
-        }
-        std::cout << "\n"; // move to next row
+bool checkRule(EngineType engine, const LifeRule &rule){
+    if((engine == ENGINE_HASH || engine == ENGINE_SPARSE) && (rule.birth & 1)){
+        std::cout << "ERROR, the " << ENGINE_NAMES[engine] << " engine runs on an unbounded plane and does not support B0 rules: "
+                  << ruleName(rule) << "\n";
+        return false;
     }
+    return true;
 }
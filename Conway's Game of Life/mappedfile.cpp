@@ -0,0 +1,99 @@
+// Conway's Game of Life
+// mappedfile.cpp
+//
+// Memory-mapped file views. See mappedfile.h.
+
+#include "mappedfile.h"
+#include <cstdio>
+#include <cstdlib>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+
+bool mapFile(const char *path, MappedFile &file){
+    struct stat info; // Gives the size of the file
+    void *view; // The mapping
+    int fd = open(path, O_RDONLY);
+
+    file.data = nullptr;
+    file.size = 0;
+    file.mapped = false;
+    if(fd < 0){
+        return false;
+    }
+    if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)){
+        close(fd);
+        return false;
+    }
+    if(info.st_size == 0){
+        close(fd);
+        return true;
+    }
+
+    view = mmap(nullptr, (std::size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file open
+    if(view == MAP_FAILED){
+        return false;
+    }
+    madvise(view, (std::size_t)info.st_size, MADV_SEQUENTIAL); // Read ahead, the parsers go front to back
+    file.data = (const char *)view;
+    file.size = (std::size_t)info.st_size;
+    file.mapped = true;
+    return true;
+}
+
+void unmapFile(MappedFile &file){
+    if(file.mapped){
+        munmap((void *)file.data, file.size);
+    }
+    else{
+        std::free((void *)file.data);
+    }
+    file.data = nullptr;
+    file.size = 0;
+    file.mapped = false;
+}
+
+#else
+
+bool mapFile(const char *path, MappedFile &file){
+    std::FILE *stream = std::fopen(path, "rb");
+    char *buffer = nullptr; // The copy of the file
+    long size; // The number of bytes in the file
+
+    file.data = nullptr;
+    file.size = 0;
+    file.mapped = false;
+    if(stream == nullptr){
+        return false;
+    }
+    if(std::fseek(stream, 0, SEEK_END) != 0 || (size = std::ftell(stream)) < 0 || std::fseek(stream, 0, SEEK_SET) != 0){
+        std::fclose(stream);
+        return false;
+    }
+    if(size > 0){
+        buffer = (char *)std::malloc((std::size_t)size);
+        if(buffer == nullptr || std::fread(buffer, 1, (std::size_t)size, stream) != (std::size_t)size){
+            std::free(buffer);
+            std::fclose(stream);
+            return false;
+        }
+    }
+    std::fclose(stream);
+    file.data = buffer;
+    file.size = (std::size_t)size;
+    return true;
+}
+
+void unmapFile(MappedFile &file){
+    std::free((void *)file.data);
+    file.data = nullptr;
+    file.size = 0;
+}
+
+#endif
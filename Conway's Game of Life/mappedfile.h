@@ -0,0 +1,42 @@
+// Conway's Game of Life
+// mappedfile.h
+//
+// Read-only views of whole files. On POSIX systems the file is memory-mapped so large
+// pattern files are read straight out of the page cache; elsewhere it is read into memory.
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+
+// MappedFile
+// Purpose: the contents of a file, readable as one block of memory
+struct MappedFile{
+    const char *data; // The first byte of the file; nullptr if the file is empty
+    std::size_t size; // The number of bytes in the file
+    bool mapped; // Whether data is a mapping (true) or a heap copy (false)
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// mapFile
+// Purpose: open a file and make its contents readable
+// Input:
+//      path - the file to open
+//      file - receives the view of the file
+// Output:
+//      Returns false if the file could not be opened or read.
+bool mapFile(const char *path, MappedFile &file);
+
+// unmapFile
+// Purpose: release a file opened by mapFile
+// Input:
+//      file - the view to release; it is left empty
+// Output:
+//      No return type.
+void unmapFile(MappedFile &file);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,148 @@
+// Conway's Game of Life
+// metrics.cpp
+//
+// Per-generation measurements. See metrics.h.
+
+#include "metrics.h"
+#include <cinttypes>
+#include <cstring>
+#include <string>
+
+#define HISTOGRAM_BAR_WIDTH 40 // Characters in the longest bar of the histogram
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// Helpers used only by the log itself
+
+// formatDuration
+// Purpose: write a time in nanoseconds with a unit that keeps it short, such as "1.5ms"
+static void formatDuration(char *text, size_t size, double nanoseconds);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+void clearStepStats(StepStats &stats){
+    stats.cellsCounted = true;
+    stats.population = 0;
+    stats.births = 0;
+    stats.deaths = 0;
+    stats.minX = INT64_MAX;
+    stats.minY = INT64_MAX;
+    stats.maxX = INT64_MIN;
+    stats.maxY = INT64_MIN;
+}
+
+void mergeStepStats(StepStats &into, const StepStats &from){
+    into.cellsCounted = into.cellsCounted && from.cellsCounted;
+    into.population += from.population;
+    into.births += from.births;
+    into.deaths += from.deaths;
+    into.minX = std::min(into.minX, from.minX);
+    into.minY = std::min(into.minY, from.minY);
+    into.maxX = std::max(into.maxX, from.maxX);
+    into.maxY = std::max(into.maxY, from.maxY);
+}
+
+bool openMetricsLog(MetricsLog &log, const char *path, bool json){
+    log.output = (std::strcmp(path, "-") == 0) ? stderr : std::fopen(path, "w");
+    if(log.output == nullptr){
+        return false;
+    }
+    log.json = json;
+    log.steps = 0;
+    log.totalNanoseconds = 0;
+    log.minNanoseconds = UINT64_MAX;
+    log.maxNanoseconds = 0;
+    log.histogram.assign(LATENCY_BUCKETS, 0);
+    if(!json){
+        std::fprintf(log.output, "generation,population,births,deaths,min_x,min_y,max_x,max_y,step_ns,render_ns\n");
+    }
+    return true;
+}
+
+void recordGeneration(MetricsLog &log, unsigned long long generation, const StepStats &stats,
+                      uint64_t stepNanoseconds, int64_t renderNanoseconds){
+    bool hasBox = stats.cellsCounted && stats.minX <= stats.maxX; // Whether there is a bounding box to write
+    int bucket = 0; // The histogram bucket of the step time
+
+    while(bucket < LATENCY_BUCKETS - 1 && (stepNanoseconds >> (bucket + 1)) != 0){
+        bucket++;
+    }
+    log.histogram[bucket]++;
+    log.steps++;
+    log.totalNanoseconds += stepNanoseconds;
+    log.minNanoseconds = std::min(log.minNanoseconds, stepNanoseconds);
+    log.maxNanoseconds = std::max(log.maxNanoseconds, stepNanoseconds);
+
+    // Values that were not measured are left empty in CSV and written as null in JSON
+    const char *missing = log.json ? "null" : "";
+    char births[24], deaths[24], box[4][24], render[24];
+    std::snprintf(births, sizeof(births), "%" PRIu64, stats.births);
+    std::snprintf(deaths, sizeof(deaths), "%" PRIu64, stats.deaths);
+    std::snprintf(box[0], sizeof(box[0]), "%" PRId64, stats.minX);
+    std::snprintf(box[1], sizeof(box[1]), "%" PRId64, stats.minY);
+    std::snprintf(box[2], sizeof(box[2]), "%" PRId64, stats.maxX);
+    std::snprintf(box[3], sizeof(box[3]), "%" PRId64, stats.maxY);
+    std::snprintf(render, sizeof(render), "%" PRId64, renderNanoseconds);
+
+    std::fprintf(log.output, log.json
+                 ? "{\"generation\":%llu,\"population\":%" PRIu64 ",\"births\":%s,\"deaths\":%s,\"min_x\":%s,\"min_y\":%s,"
+                   "\"max_x\":%s,\"max_y\":%s,\"step_ns\":%" PRIu64 ",\"render_ns\":%s}\n"
+                 : "%llu,%" PRIu64 ",%s,%s,%s,%s,%s,%s,%" PRIu64 ",%s\n",
+                 generation, stats.population,
+                 stats.cellsCounted ? births : missing, stats.cellsCounted ? deaths : missing,
+                 hasBox ? box[0] : missing, hasBox ? box[1] : missing, hasBox ? box[2] : missing, hasBox ? box[3] : missing,
+                 stepNanoseconds, (renderNanoseconds >= 0) ? render : missing);
+}
+
+bool closeMetricsLog(MetricsLog &log, FILE *summary){
+    uint64_t most = 0; // The fullest bucket, which gets the longest bar
+    int first = LATENCY_BUCKETS; // The first bucket with a step in it
+    int last = -1; // The last bucket with a step in it
+    int b;
+    bool written = (std::fflush(log.output) == 0);
+
+    if(log.output != stderr && std::fclose(log.output) != 0){
+        written = false;
+    }
+    if(log.steps == 0){
+        return written;
+    }
+
+    for(b=0; b < LATENCY_BUCKETS; b++){
+        if(log.histogram[b] != 0){
+            first = std::min(first, b);
+            last = b;
+            most = std::max(most, log.histogram[b]);
+        }
+    }
+
+    char low[16], high[16], mean[16];
+    formatDuration(low, sizeof(low), (double)log.minNanoseconds);
+    formatDuration(high, sizeof(high), (double)log.maxNanoseconds);
+    formatDuration(mean, sizeof(mean), (double)log.totalNanoseconds / log.steps);
+    std::fprintf(summary, "\nStep times over %" PRIu64 " steps: min %s, mean %s, max %s\n", log.steps, low, mean, high);
+    for(b=first; b <= last; b++){
+        int bar = (int)((log.histogram[b] * HISTOGRAM_BAR_WIDTH + most - 1) / most);
+        formatDuration(low, sizeof(low), (double)((uint64_t)1 << b));
+        formatDuration(high, sizeof(high), (double)((uint64_t)1 << (b + 1)));
+        std::fprintf(summary, "%9s - %-9s %-*s %" PRIu64 "\n", low, high, HISTOGRAM_BAR_WIDTH,
+                     std::string((size_t)bar, '#').c_str(), log.histogram[b]);
+    }
+    return written;
+}
+
+static void formatDuration(char *text, size_t size, double nanoseconds){
+    if(nanoseconds < 1e3){
+        std::snprintf(text, size, "%.0fns", nanoseconds);
+    }
+    else if(nanoseconds < 1e6){
+        std::snprintf(text, size, "%.1fus", nanoseconds / 1e3);
+    }
+    else if(nanoseconds < 1e9){
+        std::snprintf(text, size, "%.1fms", nanoseconds / 1e6);
+    }
+    else{
+        std::snprintf(text, size, "%.2fs", nanoseconds / 1e9);
+    }
+}
@@ -0,0 +1,211 @@
+// Conway's Game of Life
+// metrics.h
+//
+// Per-generation measurements. The engines count the population, births, deaths and the
+// bounding box of the living cells row by row while they step, with the row still in the
+// cache, and the program times each step and each frame. Everything is written to a log as
+// CSV or JSON lines, and a histogram of the step times is printed when the log is closed.
+//
+// The counting is only compiled in when LIFE_METRICS is defined (g++ -DLIFE_METRICS ...,
+// best with -mpopcnt as well where the processor has it).
+// Otherwise METRICS_ENABLED is 0 and the compiler drops every "if(METRICS_ENABLED && ...)"
+// from the stepping loops, so the normal build runs exactly as fast as before.
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#ifdef LIFE_METRICS
+#define METRICS_ENABLED 1
+#else
+#define METRICS_ENABLED 0
+#endif
+
+#define LATENCY_BUCKETS 40 // Power-of-two buckets of step time, from 1 ns up
+
+// StepStats
+// Purpose: what one generation did, counted while it was stepped
+struct StepStats{
+    bool cellsCounted; // False when only the population is known (the hash engine never sees single cells)
+    uint64_t population; // Living cells after the step
+    uint64_t births; // Cells that came to life
+    uint64_t deaths; // Cells that died
+    int64_t minX; // The bounding box of the living cells after the step; minX > maxX when there are none
+    int64_t minY;
+    int64_t maxX;
+    int64_t maxY;
+};
+
+// MetricsLog
+// Purpose: where the measurements go, and the step times seen so far
+struct MetricsLog{
+    FILE *output; // The log file
+    bool json; // JSON lines instead of CSV
+    uint64_t steps; // Steps recorded
+    uint64_t totalNanoseconds; // All of their times added up
+    uint64_t minNanoseconds; // The fastest step
+    uint64_t maxNanoseconds; // The slowest step
+    std::vector<uint64_t> histogram; // Steps by time, bucket b holding times from 2^b up to 2^(b+1) ns
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// clearStepStats
+// Purpose: empty a set of counts before a step
+// Input:
+//      stats - the counts to clear
+// Output:
+//      No return type.
+void clearStepStats(StepStats &stats);
+
+// mergeStepStats
+// Purpose: add counts from one part of the board to the counts of the whole
+// Input:
+//      into - the counts of the whole board
+//      from - the counts of one part, such as one band of rows
+// Output:
+//      No return type.
+void mergeStepStats(StepStats &into, const StepStats &from);
+
+// openMetricsLog
+// Purpose: start a log
+// Input:
+//      log - the log to set up
+//      path - the file to write, or "-" for standard error
+//      json - true for JSON lines, false for CSV with a header line
+// Output:
+//      Returns false if the file could not be opened.
+bool openMetricsLog(MetricsLog &log, const char *path, bool json);
+
+// recordGeneration
+// Purpose: write the measurements of one step
+// Input:
+//      log - the log to write to
+//      generation - the generation reached by the step
+//      stats - the counts of the step
+//      stepNanoseconds - how long the step took
+//      renderNanoseconds - how long drawing it took, or -1 if it was not drawn
+// Output:
+//      No return type.
+void recordGeneration(MetricsLog &log, unsigned long long generation, const StepStats &stats,
+                      uint64_t stepNanoseconds, int64_t renderNanoseconds);
+
+// closeMetricsLog
+// Purpose: finish a log and print the histogram of step times
+// Input:
+//      log - the log to finish
+//      summary - where the histogram goes
+// Output:
+//      Returns false if the log could not be written.
+bool closeMetricsLog(MetricsLog &log, FILE *summary);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+// metricsBitCount
+// Purpose: count the set bits of a word. Without a popcount instruction (g++ -mpopcnt) the
+//          builtin becomes a library call per word, which would cost more than the step itself,
+//          so plain arithmetic the compiler can spread across SIMD lanes is used instead.
+inline uint64_t metricsBitCount(uint64_t word){
+#ifdef __POPCNT__
+    return __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ull);
+    word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (word * 0x0101010101010101ull) >> 56;
+#endif
+}
+
+// countWordRow
+// Purpose: add one bit-packed row to the counts
+// Input:
+//      stats - the counts to add to
+//      before - the row before the step, one bit per cell
+//      after - the row after the step
+//      words - the number of words in the row
+//      left - the x position of bit 0 of the first word
+//      y - the y position of the row
+inline void countWordRow(StepStats &stats, const uint64_t *before, const uint64_t *after, int words,
+                         int64_t left, int64_t y){
+    uint64_t alive = 0; // Living cells in the row
+    uint64_t changed = 0; // Cells in the row that were born or died
+    int first; // The first word with a living cell
+    int last; // The last word with a living cell
+    int i;
+
+    // Births and deaths both come from the cells that changed: together they are that count, and
+    // their difference is how much the population moved. That saves a bit count per word.
+    for(i=0; i < words; i++){
+        alive += metricsBitCount(after[i]);
+        changed += metricsBitCount(after[i] ^ before[i]);
+    }
+    if(changed != 0){
+        uint64_t wasAlive = 0; // Living cells in the row before the step
+        for(i=0; i < words; i++){
+            wasAlive += metricsBitCount(before[i]);
+        }
+        stats.births += (changed + alive - wasAlive) / 2;
+        stats.deaths += (changed + wasAlive - alive) / 2;
+    }
+    stats.population += alive;
+
+    // Most rows of a big board are either empty or have cells near both ends, so the bounding box
+    // is found by looking in from each end only once the row is known to hold a living cell
+    if(alive != 0){
+        for(first=0; after[first] == 0; first++){
+        }
+        for(last=words-1; after[last] == 0; last--){
+        }
+        stats.minX = std::min(stats.minX, left + 64 * (int64_t)first + __builtin_ctzll(after[first]));
+        stats.maxX = std::max(stats.maxX, left + 64 * (int64_t)last + 63 - __builtin_clzll(after[last]));
+        stats.minY = std::min(stats.minY, y);
+        stats.maxY = std::max(stats.maxY, y);
+    }
+}
+
+// countCellRow
+// Purpose: add one row of the int or byte matrix to the counts
+// Input:
+//      stats - the counts to add to
+//      before - the row before the step, one int or byte (1 or 0) per cell
+//      after - the row after the step
+//      width - the number of cells in the row
+//      y - the y position of the row
+template<typename Cell>
+inline void countCellRow(StepStats &stats, const Cell *before, const Cell *after, int width, int64_t y){
+    int alive = 0; // Living cells in the row
+    int born = 0; // Cells in the row that came to life
+    int died = 0; // Cells in the row that died
+    int first; // The first living cell
+    int last; // The last living cell
+    int x;
+
+    // Written without branches so the compiler can run it across SIMD lanes
+    for(x=0; x < width; x++){
+        alive += after[x];
+        born += after[x] & ~before[x];
+        died += before[x] & ~after[x];
+    }
+    stats.population += alive;
+    stats.births += born;
+    stats.deaths += died;
+
+    if(alive != 0){
+        for(first=0; after[first] == 0; first++){
+        }
+        for(last=width-1; after[last] == 0; last--){
+        }
+        stats.minX = std::min(stats.minX, (int64_t)first);
+        stats.maxX = std::max(stats.maxX, (int64_t)last);
+        stats.minY = std::min(stats.minY, y);
+        stats.maxY = std::max(stats.maxY, y);
+    }
+}
+
+#endif // METRICS_H
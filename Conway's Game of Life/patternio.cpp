@@ -0,0 +1,296 @@
+// Conway's Game of Life
+// patternio.cpp
+//
+// Seed file reading. See patternio.h.
+
+#include "patternio.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+#define PATTERN_MAX_COUNT ((int64_t)1 << 40) // Run counts and coordinates are clamped here so they cannot overflow
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// parseGrid
+// Purpose: pass the living cells of a 0/1 grid to a sink
+// Input:
+//      p, end - the text to parse
+//      width, height - the size of the board; exactly width x height cells are expected
+//      sink - receives each run of living cells
+// Output:
+//      Returns false on an unexpected character or the wrong number of cells.
+static bool parseGrid(const char *p, const char *end, int width, int height, const RunSink &sink);
+
+// parseRle
+// Purpose: pass the living cells of an RLE body to a sink, clipped to the board
+// Input:
+//      p, end - the text after the header line
+//      width, height - the size of the board
+//      sink - receives each run of living cells
+// Output:
+//      Returns false on an unexpected character.
+static bool parseRle(const char *p, const char *end, int width, int height, const RunSink &sink);
+
+// parseLife106
+// Purpose: pass the living cells of a Life 1.06 list to a sink, clipped to the board
+// Input:
+//      p, end - the text after the header line
+//      width, height - the size of the board; coordinate (0, 0) is its middle
+//      sink - receives each living cell as a run of one
+// Output:
+//      Returns false if a line does not hold two integers.
+static bool parseLife106(const char *p, const char *end, int width, int height, const RunSink &sink);
+
+// parseInteger
+// Purpose: read an optionally signed decimal integer, clamped to +-PATTERN_MAX_COUNT
+// Input:
+//      p - the position to read from; moved past the digits
+//      end - the end of the text
+//      value - receives the integer
+// Output:
+//      Returns false if there are no digits at p.
+static bool parseInteger(const char *&p, const char *end, int64_t &value);
+
+// skipLine
+// Purpose: find the start of the next line
+// Input:
+//      p, end - the text to search
+// Output:
+//      Returns the position after the next '\n', or end if there is none.
+static const char *skipLine(const char *p, const char *end);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+static const char *skipLine(const char *p, const char *end){
+    const char *newline = (const char *)std::memchr(p, '\n', end - p);
+
+    return newline != nullptr ? newline + 1 : end;
+}
+
+static bool parseInteger(const char *&p, const char *end, int64_t &value){
+    bool negative = false;
+    const char *digits; // The first digit
+
+    if(p < end && (*p == '-' || *p == '+')){
+        negative = (*p == '-');
+        p++;
+    }
+    digits = p;
+    value = 0;
+    while(p < end && *p >= '0' && *p <= '9'){
+        value = std::min(value * 10 + (*p - '0'), PATTERN_MAX_COUNT);
+        p++;
+    }
+    if(negative){
+        value = -value;
+    }
+    return p != digits;
+}
+
+static bool parseGrid(const char *p, const char *end, int width, int height, const RunSink &sink){
+    int x = 0; // The column of the next cell
+    int y = 0; // The row of the next cell
+    int runStart = -1; // The column the current run of living cells began at, or -1
+    bool lineStart = true; // Whether the next character starts a line
+
+    while(p < end){
+        char c = *p;
+        if(c == '#' && lineStart){
+            p = skipLine(p, end);
+            continue;
+        }
+        lineStart = (c == '\n');
+        p++;
+        if(c == '0' || c == '1'){
+            if(y == height){
+                return false;
+            }
+            if(c == '1'){
+                if(runStart < 0){
+                    runStart = x;
+                }
+            }
+            else if(runStart >= 0){
+                sink(runStart, y, x - runStart);
+                runStart = -1;
+            }
+            x++;
+            if(x == width){
+                if(runStart >= 0){
+                    sink(runStart, y, x - runStart);
+                    runStart = -1;
+                }
+                x = 0;
+                y++;
+            }
+        }
+        else if(c != ' ' && c != '\t' && c != '\r' && c != '\n'){
+            return false;
+        }
+    }
+    return y == height;
+}
+
+static bool parseRle(const char *p, const char *end, int width, int height, const RunSink &sink){
+    int64_t x = 0; // The column of the next cell
+    int64_t y = 0; // The row of the next cell
+    int64_t count = 0; // The repeat count read so far in front of a tag; 0 means none
+    int64_t run; // The length of the run a tag stands for
+
+    for(; p < end; p++){
+        char c = *p;
+        if(c >= '0' && c <= '9'){
+            count = std::min(count * 10 + (c - '0'), PATTERN_MAX_COUNT);
+            continue;
+        }
+        run = (count != 0) ? count : 1;
+        switch(c){
+        case ' ': case '\t': case '\r': case '\n':
+            continue; // A count may be split from its tag by whitespace, so keep it
+        case 'b': case '.':
+            x += run;
+            break;
+        case '$':
+            x = 0;
+            y += run;
+            if(y >= height){
+                return true; // The rest of the pattern falls below the board
+            }
+            break;
+        case '!':
+            return true;
+        case '#':
+            p = skipLine(p, end) - 1;
+            break;
+        default:
+            if(!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))){
+                return false;
+            }
+            // 'o' is a living cell; the letters of multi-state patterns are taken as living too
+            if(x < width){
+                sink((int)x, (int)y, (int)std::min(run, (int64_t)width - x));
+            }
+            x = std::min(x + run, PATTERN_MAX_COUNT);
+            break;
+        }
+        count = 0;
+    }
+    return true;
+}
+
+static bool parseLife106(const char *p, const char *end, int width, int height, const RunSink &sink){
+    int64_t x; // The column of a cell, measured from the middle of the board
+    int64_t y; // The row of a cell, measured from the middle of the board
+
+    while(p < end){
+        char c = *p;
+        if(c == ' ' || c == '\t' || c == '\r' || c == '\n'){
+            p++;
+            continue;
+        }
+        if(c == '#'){
+            p = skipLine(p, end);
+            continue;
+        }
+        if(!parseInteger(p, end, x)){
+            return false;
+        }
+        while(p < end && (*p == ' ' || *p == '\t')){
+            p++;
+        }
+        if(!parseInteger(p, end, y)){
+            return false;
+        }
+        x += width / 2;
+        y += height / 2;
+        if(x >= 0 && x < width && y >= 0 && y < height){
+            sink((int)x, (int)y, 1);
+        }
+    }
+    return true;
+}
+
+bool openPattern(const char *path, Pattern &pattern){
+    const char *p; // The position being looked at
+    const char *end; // The end of the file
+
+    pattern.format = PATTERN_GRID;
+    pattern.width = 0;
+    pattern.height = 0;
+    pattern.rule.clear();
+    pattern.bodyStart = 0;
+    if(!mapFile(path, pattern.file)){
+        return false;
+    }
+    p = pattern.file.data;
+    end = p + pattern.file.size;
+
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')){
+        p++;
+    }
+    if(end - p >= 10 && std::memcmp(p, "#Life 1.06", 10) == 0){
+        pattern.format = PATTERN_LIFE106;
+        pattern.bodyStart = skipLine(p, end) - pattern.file.data;
+        return true;
+    }
+
+    // RLE files may open with '#' comment lines before the "x = W, y = H" header
+    while(p < end && (*p == '#' || *p == '\r' || *p == '\n')){
+        p = skipLine(p, end);
+        while(p < end && (*p == ' ' || *p == '\t')){
+            p++;
+        }
+    }
+    if(p < end && *p == 'x'){
+        const char *lineEnd = skipLine(p, end);
+        std::string header(p, lineEnd);
+        if(std::sscanf(header.c_str(), "x = %d , y = %d", &pattern.width, &pattern.height) != 2 ||
+           pattern.width < 0 || pattern.height < 0){
+            unmapFile(pattern.file);
+            return false;
+        }
+        // An optional "rule = B36/S23" follows; a ":T..." suffix for a bounded plane is not kept
+        std::size_t rulePos = header.find("rule");
+        if(rulePos != std::string::npos){
+            std::size_t first = header.find_first_not_of(" \t=", rulePos + 4);
+            std::size_t last = header.find_first_of(" \t\r\n,:", first);
+            if(first != std::string::npos){
+                pattern.rule = header.substr(first, last - first);
+            }
+        }
+        pattern.format = PATTERN_RLE;
+        pattern.bodyStart = lineEnd - pattern.file.data;
+    }
+    return true;
+}
+
+void closePattern(Pattern &pattern){
+    unmapFile(pattern.file);
+}
+
+bool readPattern(const Pattern &pattern, int width, int height, const RunSink &sink){
+    const char *body = pattern.file.data + pattern.bodyStart;
+    const char *end = pattern.file.data + pattern.file.size;
+
+    if(pattern.format == PATTERN_RLE){
+        return parseRle(body, end, width, height, sink);
+    }
+    if(pattern.format == PATTERN_LIFE106){
+        return parseLife106(body, end, width, height, sink);
+    }
+    return parseGrid(body, end, width, height, sink);
+}
+
+bool readGridPattern(std::istream &input, TableType &table){
+    std::string contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    const char *text = contents.data();
+
+    return parseGrid(text, text + contents.size(), table.width, table.height, [&](int x, int y, int length){
+        std::fill(tableRow(table, y) + x, tableRow(table, y) + x + length, ALIVE);
+    });
+}
@@ -0,0 +1,93 @@
+// Conway's Game of Life
+// patternio.h
+//
+// Reading seed boards from files, so they do not have to be typed in one cell at a time.
+// Three formats are understood:
+//      0/1 grid - every 0 or 1 is one cell, filled in row by row, like "Bar Example.txt"
+//      RLE - the run length encoded format with an "x = W, y = H" header line
+//      Life 1.06 - a "#Life 1.06" header followed by one "x y" coordinate pair per living cell
+// Files are mapped into memory and parsed in one pass, and the living cells are handed
+// over a run at a time so each engine can write them straight into its own storage.
+
+#ifndef PATTERNIO_H
+#define PATTERNIO_H
+
+#include <functional>
+#include <string>
+#include <istream>
+#include "grid.h"
+#include "mappedfile.h"
+
+// PatternFormat
+// Purpose: the way a pattern file is written
+//      PATTERN_GRID - whitespace separated 0/1 cells, row by row
+//      PATTERN_RLE - run length encoded
+//      PATTERN_LIFE106 - a list of living cell coordinates
+enum PatternFormat{
+    PATTERN_GRID,
+    PATTERN_RLE,
+    PATTERN_LIFE106
+};
+
+// Pattern
+// Purpose: an open pattern file, its format, and the size it asks for
+struct Pattern{
+    MappedFile file; // The contents of the file
+    PatternFormat format; // How the file is written
+    int width; // RLE only: the columns given in the header, otherwise 0
+    int height; // RLE only: the rows given in the header, otherwise 0
+    std::string rule; // RLE only: the rulestring given in the header, otherwise empty
+    std::size_t bodyStart; // Offset of the first byte after the header
+};
+
+// RunSink
+// Purpose: receives a run of living cells on one row. The run always lies inside the board.
+typedef std::function<void(int x, int y, int length)> RunSink;
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// openPattern
+// Purpose: open a pattern file, work out its format and read its header
+// Input:
+//      path - the file to open
+//      pattern - receives the open file
+// Output:
+//      Returns false if the file could not be read or has a broken header.
+bool openPattern(const char *path, Pattern &pattern);
+
+// closePattern
+// Purpose: release a file opened by openPattern
+// Input:
+//      pattern - the file to release
+// Output:
+//      No return type.
+void closePattern(Pattern &pattern);
+
+// readPattern
+// Purpose: pass every living cell of a pattern to a sink, clipped to a board.
+//          RLE and grid patterns start at the top-left corner of the board; Life 1.06
+//          coordinates are measured from the middle of the board.
+// Input:
+//      pattern - the open file
+//      width - the number of columns on the board
+//      height - the number of rows on the board
+//      sink - called once for each run of living cells on the board
+// Output:
+//      Returns false if the file is not well formed. A grid pattern must hold exactly
+//      width x height cells.
+bool readPattern(const Pattern &pattern, int width, int height, const RunSink &sink);
+
+// readGridPattern
+// Purpose: read a board in the 0/1 grid format
+// Input:
+//      input - the stream to read from. Every 0 or 1 is one cell, filled in row by row;
+//              whitespace is skipped and lines starting with '#' are comments.
+//      table - the matrix to fill; its size says how many cells are expected
+// Output:
+//      Returns true if exactly width x height cells were read.
+bool readGridPattern(std::istream &input, TableType &table);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // PATTERNIO_H
@@ -0,0 +1,47 @@
+#!/bin/sh
+# Conway's Game of Life
+# regress.sh
+#
+# Runs GameOfLife on small boards whose output is known and reports any that differ.
+#
+# Usage: sh regress.sh [GAMEOFLIFE]
+#      GAMEOFLIFE - the built program to run (default ./GameOfLife)
+
+LIFE=${1:-./GameOfLife}
+SCRATCH=$(mktemp -d)
+trap 'rm -rf "$SCRATCH"' EXIT
+FAILED=0
+
+# expect NAME EXPECTED ARGS... - run GameOfLife with ARGS and compare its output with EXPECTED
+expect(){
+    name=$1
+    expected=$2
+    shift 2
+    actual=$("$LIFE" "$@" 2>&1)
+    if [ "$actual" != "$expected" ]; then
+        printf 'FAIL %s\n  expected: %s\n  got:      %s\n' "$name" "$expected" "$actual"
+        FAILED=1
+    else
+        printf 'ok   %s\n' "$name"
+    fi
+}
+
+printf '0 0 0 0 0\n0 0 0 0 0\n0 0 0 0 0\n0 0 0 0 0\n0 0 0 0 0\n' > "$SCRATCH/empty.txt"
+printf '0 0 0 0 0\n0 0 1 0 0\n0 0 1 0 0\n0 0 1 0 0\n0 0 0 0 0\n' > "$SCRATCH/blinker.txt"
+
+# -detect must not call an empty board extinct under B0, where it fills up on the next step
+for engine in int bit byte; do
+    expect "B0 empty board, $engine engine" "3 25" \
+        -engine $engine -size 5x5 -seed "$SCRATCH/empty.txt" -rule B0/S -batch 3 -population -detect 4
+    expect "B0 empty board oscillates, $engine engine" "# OSCILLATOR: period 2 from generation 0
+11 25" \
+        -engine $engine -size 5x5 -seed "$SCRATCH/empty.txt" -rule B0/S -batch 11 -population -detect 4
+done
+expect "B3/S23 empty board" "# EXTINCT: every cell is dead from generation 0
+3 0" \
+    -size 5x5 -seed "$SCRATCH/empty.txt" -batch 3 -population -detect 4
+expect "B3/S23 blinker" "# OSCILLATOR: period 2 from generation 0
+11 3" \
+    -size 5x5 -seed "$SCRATCH/blinker.txt" -batch 11 -population -detect 4
+
+exit $FAILED
@@ -0,0 +1,345 @@
+// Conway's Game of Life
+// render.cpp
+//
+// Terminal display. See render.h.
+
+#include "render.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#define DEFAULT_TERMINAL_COLUMNS 80
+#define DEFAULT_TERMINAL_ROWS 24
+#define CLEAR_LINES 30 // Blank lines the text mode prints to push the last frame off the screen
+#define SKIP_LIMIT 4 // Unchanged characters rewritten rather than moving the cursor past them
+#define GLYPH_UNKNOWN 0xFFFF // What shown holds where the terminal's contents are not known
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// terminalSize
+// Purpose: find the size of the terminal, falling back on $COLUMNS/$LINES and then 80x24
+// Input:
+//      columns - receives the number of characters across
+//      rows - receives the number of lines down
+// Output:
+//      No return type.
+static void terminalSize(int &columns, int &rows);
+
+// shrinkBoard
+// Purpose: merge each scale x scale square of cells into one dot
+// Input:
+//      renderer - the renderer whose dots are filled
+//      table - the board to shrink
+// Output:
+//      No return type.
+static void shrinkBoard(Renderer &renderer, const TableType &table);
+
+// buildGlyphs
+// Purpose: turn the dots into one character code for each place on the screen
+// Input:
+//      renderer - the renderer whose glyphs are filled from its dots
+// Output:
+//      No return type.
+static void buildGlyphs(Renderer &renderer);
+
+// appendGlyph
+// Purpose: add the bytes of one character to the frame
+// Input:
+//      renderer - the renderer whose frame is added to
+//      glyph - the character code, as made by buildGlyphs
+// Output:
+//      No return type.
+static void appendGlyph(Renderer &renderer, unsigned glyph);
+
+// moveCursor
+// Purpose: add an ANSI cursor move to the frame
+// Input:
+//      frame - the frame to add to
+//      row - the line to move to, counting from 0
+//      column - the character to move to, counting from 0
+// Output:
+//      No return type.
+static void moveCursor(std::string &frame, int row, int column);
+
+// writeFrame
+// Purpose: write the frame to standard output in one call
+// Input:
+//      frame - the bytes to write
+// Output:
+//      No return type.
+static void writeFrame(const std::string &frame);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+bool parseRenderMode(const char *name, RenderMode &mode){
+    if(std::strcmp(name, "text") == 0){
+        mode = RENDER_TEXT;
+    }
+    else if(std::strcmp(name, "ansi") == 0){
+        mode = RENDER_ANSI;
+    }
+    else if(std::strcmp(name, "half") == 0){
+        mode = RENDER_HALF;
+    }
+    else if(std::strcmp(name, "braille") == 0){
+        mode = RENDER_BRAILLE;
+    }
+    else{
+        return false;
+    }
+    return true;
+}
+
+bool outputIsTerminal(){
+#ifdef _WIN32
+    return _isatty(_fileno(stdout)) != 0;
+#else
+    return isatty(STDOUT_FILENO) != 0;
+#endif
+}
+
+static void terminalSize(int &columns, int &rows){
+    const char *variable; // $COLUMNS or $LINES
+
+    columns = 0;
+    rows = 0;
+#ifdef _WIN32
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if(GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)){
+        columns = info.srWindow.Right - info.srWindow.Left + 1;
+        rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+    }
+#else
+    struct winsize size;
+    if(ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0){
+        columns = size.ws_col;
+        rows = size.ws_row;
+    }
+#endif
+    if(columns <= 0 && (variable = std::getenv("COLUMNS")) != nullptr){
+        columns = std::atoi(variable);
+    }
+    if(rows <= 0 && (variable = std::getenv("LINES")) != nullptr){
+        rows = std::atoi(variable);
+    }
+    if(columns <= 0){
+        columns = DEFAULT_TERMINAL_COLUMNS;
+    }
+    if(rows <= 0){
+        rows = DEFAULT_TERMINAL_ROWS;
+    }
+}
+
+void initRenderer(Renderer &renderer, RenderMode mode, int boardWidth, int boardHeight, int statusLines){
+    int terminalColumns; // Characters across the terminal
+    int terminalRows; // Lines down the terminal
+
+    renderer.mode = mode;
+    renderer.boardWidth = boardWidth;
+    renderer.boardHeight = boardHeight;
+    renderer.screenReady = false;
+
+    if(mode == RENDER_TEXT){
+        renderer.scale = 1;
+        renderer.dotsPerColumn = 1;
+        renderer.dotsPerRow = 1;
+        renderer.columns = boardWidth;
+        renderer.rows = boardHeight;
+        renderer.frame.reserve(CLEAR_LINES + (size_t)(boardWidth + 1) * boardHeight + 256);
+        return;
+    }
+
+#ifdef _WIN32
+    // Windows 10 consoles understand ANSI escapes once asked to
+    HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD consoleMode;
+    if(GetConsoleMode(console, &consoleMode)){
+        SetConsoleMode(console, consoleMode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    }
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    renderer.dotsPerColumn = (mode == RENDER_BRAILLE) ? 2 : 1;
+    renderer.dotsPerRow = (mode == RENDER_BRAILLE) ? 4 : (mode == RENDER_HALF) ? 2 : 1;
+
+    terminalSize(terminalColumns, terminalRows);
+    terminalRows = std::max(1, terminalRows - statusLines);
+    int dotsAcross = terminalColumns * renderer.dotsPerColumn; // Dots that fit across the terminal
+    int dotsDown = terminalRows * renderer.dotsPerRow; // Dots that fit down the terminal
+    renderer.scale = std::max(1, std::max((boardWidth + dotsAcross - 1) / dotsAcross,
+                                          (boardHeight + dotsDown - 1) / dotsDown));
+
+    int dotColumns = (boardWidth + renderer.scale - 1) / renderer.scale; // Dots across the shrunk board
+    int dotRows = (boardHeight + renderer.scale - 1) / renderer.scale; // Dots down the shrunk board
+    renderer.columns = (dotColumns + renderer.dotsPerColumn - 1) / renderer.dotsPerColumn;
+    renderer.rows = (dotRows + renderer.dotsPerRow - 1) / renderer.dotsPerRow;
+
+    size_t places = (size_t)renderer.columns * renderer.rows; // Characters on the screen
+    renderer.dots.assign(places * renderer.dotsPerColumn * renderer.dotsPerRow, 0);
+    renderer.glyphs.assign(places, 0);
+    renderer.shown.assign(places, GLYPH_UNKNOWN);
+    renderer.frame.reserve(places * 16 + 256); // Enough for every character to need a cursor move
+}
+
+static void shrinkBoard(Renderer &renderer, const TableType &table){
+    int dotsWide = renderer.columns * renderer.dotsPerColumn; // Dots in one row of renderer.dots
+    int scale = renderer.scale;
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+
+    std::fill(renderer.dots.begin(), renderer.dots.end(), 0);
+    for(y=0; y < table.height; y++){
+        const int *row = tableRow(table, y);
+        uint8_t *dotRow = &renderer.dots[(size_t)(y / scale) * dotsWide];
+        if(scale == 1){
+            for(x=0; x < table.width; x++){
+                dotRow[x] = (uint8_t)row[x];
+            }
+        }
+        else{
+            for(x=0; x < table.width; x++){
+                dotRow[x / scale] |= (uint8_t)row[x];
+            }
+        }
+    }
+}
+
+static void buildGlyphs(Renderer &renderer){
+    // Braille dot numbering: bit (row * 2 + column) of this table gives the bit of the code point
+    static const uint8_t BRAILLE_BITS[8] = { 0x01, 0x08, 0x02, 0x10, 0x04, 0x20, 0x40, 0x80 };
+    int dotsWide = renderer.columns * renderer.dotsPerColumn; // Dots in one row of renderer.dots
+    int column; // The character currently being looked at
+    int row; // The line currently being looked at
+    int dx; // The dot column within the character
+    int dy; // The dot row within the character
+
+    for(row=0; row < renderer.rows; row++){
+        for(column=0; column < renderer.columns; column++){
+            const uint8_t *dot = &renderer.dots[(size_t)row * renderer.dotsPerRow * dotsWide + column * renderer.dotsPerColumn];
+            uint8_t glyph = 0;
+            if(renderer.mode == RENDER_BRAILLE){
+                for(dy=0; dy < 4; dy++){
+                    for(dx=0; dx < 2; dx++){
+                        if(dot[(size_t)dy * dotsWide + dx]){
+                            glyph |= BRAILLE_BITS[dy * 2 + dx];
+                        }
+                    }
+                }
+            }
+            else if(renderer.mode == RENDER_HALF){
+                glyph = dot[0] | (dot[dotsWide] << 1);
+            }
+            else{
+                glyph = dot[0];
+            }
+            renderer.glyphs[(size_t)row * renderer.columns + column] = glyph;
+        }
+    }
+}
+
+static void appendGlyph(Renderer &renderer, unsigned glyph){
+    static const char *const HALF_BLOCKS[4] = { " ", "\xE2\x96\x80", "\xE2\x96\x84", "\xE2\x96\x88" }; // ' ', upper, lower, full
+
+    if(renderer.mode == RENDER_BRAILLE){
+        // U+2800 + glyph, as UTF-8
+        renderer.frame += (char)0xE2;
+        renderer.frame += (char)(0xA0 | (glyph >> 6));
+        renderer.frame += (char)(0x80 | (glyph & 0x3F));
+    }
+    else if(renderer.mode == RENDER_HALF){
+        renderer.frame += HALF_BLOCKS[glyph];
+    }
+    else{
+        renderer.frame += glyph ? '#' : '_';
+    }
+}
+
+static void moveCursor(std::string &frame, int row, int column){
+    char escape[32]; // The escape sequence
+
+    std::snprintf(escape, sizeof(escape), "\x1b[%d;%dH", row + 1, column + 1);
+    frame += escape;
+}
+
+static void writeFrame(const std::string &frame){
+    std::fflush(stdout); // Anything already queued by iostreams goes first
+    std::fwrite(frame.data(), 1, frame.size(), stdout);
+    std::fflush(stdout);
+}
+
+void renderFrame(Renderer &renderer, const TableType &table, const std::string &status){
+    int column; // The character currently being looked at
+    int row; // The line currently being looked at
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+
+    renderer.frame.clear();
+
+    if(renderer.mode == RENDER_TEXT){
+        renderer.frame.append(CLEAR_LINES, '\n'); // push the last frame off the screen
+        for(y=0; y < table.height; y++){
+            const int *cells = tableRow(table, y);
+            for(x=0; x < table.width; x++){
+                renderer.frame += cells[x] ? '#' : '_';
+            }
+            renderer.frame += '\n';
+        }
+        renderer.frame += status;
+        writeFrame(renderer.frame);
+        return;
+    }
+
+    shrinkBoard(renderer, table);
+    buildGlyphs(renderer);
+
+    renderer.frame += "\x1b[?25l"; // hide the cursor while it jumps around
+    if(!renderer.screenReady){
+        renderer.frame += "\x1b[H\x1b[2J"; // clear the screen
+        std::fill(renderer.shown.begin(), renderer.shown.end(), GLYPH_UNKNOWN);
+        renderer.screenReady = true;
+    }
+
+    for(row=0; row < renderer.rows; row++){
+        const uint8_t *wanted = &renderer.glyphs[(size_t)row * renderer.columns];
+        uint16_t *shown = &renderer.shown[(size_t)row * renderer.columns];
+        int cursor = -1; // Where the cursor is on this line, or -1 if it is elsewhere
+        for(column=0; column < renderer.columns; column++){
+            if(wanted[column] == shown[column]){
+                continue;
+            }
+            if(cursor < 0 || column - cursor > SKIP_LIMIT){
+                moveCursor(renderer.frame, row, column);
+            }
+            else{
+                for(; cursor < column; cursor++){
+                    appendGlyph(renderer, shown[cursor]); // cheaper than an escape sequence
+                }
+            }
+            appendGlyph(renderer, wanted[column]);
+            shown[column] = wanted[column];
+            cursor = column + 1;
+        }
+    }
+
+    moveCursor(renderer.frame, renderer.rows, 0);
+    renderer.frame += "\x1b[J"; // clear the old status and anything typed since
+    renderer.frame += status;
+    renderer.frame += "\x1b[?25h"; // show the cursor again, for the prompt
+    writeFrame(renderer.frame);
+}
+
+void finishRenderer(Renderer &renderer){
+    if(renderer.mode != RENDER_TEXT && renderer.screenReady){
+        std::fputs("\x1b[?25h\n", stdout); // the cursor may have been hidden mid-frame by an interrupt
+        std::fflush(stdout);
+    }
+}
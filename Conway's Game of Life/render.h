@@ -0,0 +1,101 @@
+// Conway's Game of Life
+// render.h
+//
+// Terminal display. Each frame is built in one preallocated buffer and written with a
+// single call. The plain text mode draws the whole matrix the way it always has; the ANSI
+// modes keep a copy of what the terminal is showing, move the cursor straight to the
+// characters that changed and redraw only those, and shrink boards bigger than the
+// terminal by merging squares of cells into one dot (any living cell lights the dot).
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "grid.h"
+
+// RenderMode
+// Purpose: how the board is drawn
+//      RENDER_TEXT - the whole matrix, one '#' or '_' per cell, scrolling down the screen
+//      RENDER_ANSI - one '#' or '_' per dot, redrawn in place
+//      RENDER_HALF - Unicode half blocks, two dots per character stacked vertically
+//      RENDER_BRAILLE - Unicode braille, a 2x4 square of dots per character
+enum RenderMode{
+    RENDER_TEXT,
+    RENDER_ANSI,
+    RENDER_HALF,
+    RENDER_BRAILLE
+};
+
+// Renderer
+// Purpose: the state kept between frames
+struct Renderer{
+    RenderMode mode; // How the board is drawn
+    int boardWidth; // The number of columns on the board
+    int boardHeight; // The number of rows on the board
+    int scale; // ANSI modes: board cells along each side of one dot
+    int dotsPerColumn; // ANSI modes: dots across one character
+    int dotsPerRow; // ANSI modes: dots down one character
+    int columns; // ANSI modes: characters across the drawn board
+    int rows; // ANSI modes: characters down the drawn board
+    std::vector<uint8_t> dots; // ANSI modes: the board shrunk to dots, columns * dotsPerColumn across
+    std::vector<uint8_t> glyphs; // ANSI modes: the character wanted in each place this frame
+    std::vector<uint16_t> shown; // ANSI modes: the character the terminal shows in each place
+    bool screenReady; // ANSI modes: whether the screen has been cleared and shown is accurate
+    std::string frame; // The bytes of the frame being built
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// parseRenderMode
+// Purpose: turn a display mode given on the command line into a RenderMode
+// Input:
+//      name - "text", "ansi", "half" or "braille"
+//      mode - receives the parsed mode
+// Output:
+//      Returns true if the name was recognized.
+bool parseRenderMode(const char *name, RenderMode &mode);
+
+// outputIsTerminal
+// Purpose: tell whether standard output is a terminal, so the ANSI modes can be chosen by default
+// Input:
+//      None.
+// Output:
+//      Returns true if standard output is a terminal.
+bool outputIsTerminal();
+
+// initRenderer
+// Purpose: set up a renderer for a board, fitting the ANSI modes to the terminal
+// Input:
+//      renderer - the renderer to set up
+//      mode - how the board is drawn
+//      boardWidth - the number of columns on the board
+//      boardHeight - the number of rows on the board
+//      statusLines - terminal lines to leave free under the board for the status text
+// Output:
+//      No return type.
+void initRenderer(Renderer &renderer, RenderMode mode, int boardWidth, int boardHeight, int statusLines);
+
+// renderFrame
+// Purpose: draw the board followed by some status text, in one write
+// Input:
+//      renderer - the renderer to draw with
+//      table - the board to draw
+//      status - text written after the board; the ANSI modes clear what was under the board first
+// Output:
+//      No return type.
+void renderFrame(Renderer &renderer, const TableType &table, const std::string &status);
+
+// finishRenderer
+// Purpose: leave the terminal the way it was found, with the cursor under the last frame
+// Input:
+//      renderer - the renderer to finish
+// Output:
+//      No return type.
+void finishRenderer(Renderer &renderer);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // RENDER_H
@@ -0,0 +1,231 @@
+// Conway's Game of Life
+// replay.cpp
+//
+// Plays back a history log written with GameOfLife -history, without stepping anything:
+// any generation is decoded from the keyframe before it, and a range of generations is
+// decoded one delta after another. Boards are written in the same format as batch runs.
+//
+// Usage: LifeReplay FILE [-info] [-at G] [-to G] [-every K] [-population] [-output FILE]
+//      -info - describe the log (size, rule, generations, keyframes and how much smaller it is than
+//              the boards it holds) instead of writing boards
+//      -at - the first generation to write (default the first in the log)
+//      -to - the last generation to write (default the same as -at)
+//      -every - write only every K-th generation from -at to -to (default 1)
+//      -population - write "generation population" lines instead of whole boards
+//      -output - write to FILE instead of standard output
+//
+// Build: g++ -O2 -pthread replay.cpp grid.cpp intlife.cpp bitlife.cpp bytelife.cpp threadpool.cpp hashlife.cpp
+//            sparselife.cpp simulation.cpp patternio.cpp mappedfile.cpp rule.cpp metrics.cpp history.cpp
+//            -o LifeReplay
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "bitlife.h"
+#include "history.h"
+#include "rule.h"
+#include "simulation.h"
+#include "threadpool.h"
+
+#define OUTPUT_BUFFER_BYTES (1 << 20)
+
+const char *const EDGE_NAMES[] = { "dead", "torus", "mirror" };
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// describeHistory
+// Purpose: write what is in a log
+// Input:
+//      output - the file to write to
+//      reader - the open log
+//      path - the name of the log
+// Output:
+//      No return type. Also times a seek to the generation that is furthest from a keyframe.
+void describeHistory(FILE *output, HistoryReader &reader, const char *path);
+
+// writeBoard
+// Purpose: write one decoded generation
+// Input:
+//      output - the file to write to
+//      reader - the open log, for the size and rule of the board
+//      generation - the number of the generation
+//      words - the generation as packed rows
+//      populationOnly - write only the generation and population on one line instead of the board
+//      pool - the threads of the simulation the board is put in to be written
+// Output:
+//      No return type.
+void writeBoard(FILE *output, const HistoryReader &reader, unsigned long long generation,
+                const std::vector<uint64_t> &words, bool populationOnly, ThreadPool &pool);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+int main(int argc, char* argv[]){
+    const char *path = nullptr; // The log to play back
+    bool info = false; // Describe the log instead of writing boards
+    unsigned long long from = 0; // The first generation to write
+    bool fromGiven = false; // Whether -at was given, rather than starting at the first generation
+    unsigned long long to = 0; // The last generation to write
+    bool toGiven = false; // Whether -to was given, rather than writing one generation
+    unsigned long long every = 1; // Write every this many generations
+    bool populationOnly = false; // Write population lines instead of boards
+    const char *outputPath = nullptr; // File the boards go to, if not standard output
+    FILE *output = stdout; // Where the boards go
+    HistoryReader reader; // The open log
+    std::string error; // Why the log could not be opened
+    std::vector<uint64_t> words; // The generation last decoded
+    ThreadPool pool(1); // For the simulation each board is written from
+    unsigned long long g; // The generation currently being decoded
+
+    for(int i=1; i < argc; i++){
+        if(std::strcmp(argv[i], "-info") == 0){
+            info = true;
+        }
+        else if(std::strcmp(argv[i], "-at") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%llu", &from) != 1 || argv[i][0] == '-'){
+                std::cerr << "ERROR, at must be a generation: " << argv[i] << "\n";
+                return 1;
+            }
+            fromGiven = true;
+        }
+        else if(std::strcmp(argv[i], "-to") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%llu", &to) != 1 || argv[i][0] == '-'){
+                std::cerr << "ERROR, to must be a generation: " << argv[i] << "\n";
+                return 1;
+            }
+            toGiven = true;
+        }
+        else if(std::strcmp(argv[i], "-every") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%llu", &every) != 1 || argv[i][0] == '-' || every < 1){
+                std::cerr << "ERROR, every must be at least 1: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-population") == 0){
+            populationOnly = true;
+        }
+        else if(std::strcmp(argv[i], "-output") == 0 && i+1 < argc){
+            outputPath = argv[++i];
+        }
+        else if(path == nullptr && argv[i][0] != '-'){
+            path = argv[i];
+        }
+        else{
+            path = nullptr;
+            break;
+        }
+    }
+    if(path == nullptr){
+        std::cerr << "Usage: " << argv[0] << " FILE [-info] [-at G] [-to G] [-every K] [-population] [-output FILE]\n";
+        return 1;
+    }
+
+    if(!openHistory(path, reader, error)){
+        std::cerr << "ERROR, " << error << ": " << path << "\n";
+        return 1;
+    }
+    if(!fromGiven){
+        from = reader.header.firstGeneration;
+    }
+    if(!toGiven){
+        to = from;
+    }
+    if(from < reader.header.firstGeneration || to > reader.lastGeneration || from > to){
+        std::cerr << "ERROR, the log holds generations " << reader.header.firstGeneration << " to "
+                  << reader.lastGeneration << "\n";
+        closeHistory(reader);
+        return 1;
+    }
+
+    if(outputPath != nullptr){
+        output = std::fopen(outputPath, "w");
+        if(output == nullptr){
+            std::cerr << "ERROR, could not open " << outputPath << " for writing\n";
+            closeHistory(reader);
+            return 1;
+        }
+    }
+    std::setvbuf(output, nullptr, _IOFBF, OUTPUT_BUFFER_BYTES);
+
+    if(info){
+        describeHistory(output, reader, path);
+    }
+    else{
+        if(!seekHistory(reader, from, words)){
+            std::cerr << "ERROR, the log is damaged before generation " << from << "\n";
+            closeHistory(reader);
+            return 1;
+        }
+        writeBoard(output, reader, from, words, populationOnly, pool);
+        for(g=from + 1; g <= to; g++){
+            if(!nextHistory(reader, words)){
+                std::cerr << "ERROR, the log is damaged at generation " << g << "\n";
+                closeHistory(reader);
+                return 1;
+            }
+            if((g - from) % every == 0){
+                writeBoard(output, reader, g, words, populationOnly, pool);
+            }
+        }
+    }
+
+    closeHistory(reader);
+    if(std::fflush(output) != 0 || (output != stdout && std::fclose(output) != 0)){
+        std::cerr << "ERROR, could not finish writing the output\n";
+        return 1;
+    }
+    return 0;
+}
+
+void describeHistory(FILE *output, HistoryReader &reader, const char *path){
+    const HistoryHeader &header = reader.header;
+    LifeRule rule; // The rule of the run
+    unsigned long long generations = reader.lastGeneration - header.firstGeneration + 1; // Generations in the log
+    double rawBytes = (double)generations * header.height * header.rowWords * sizeof(uint64_t); // As whole boards
+    unsigned long long farthest; // The generation with the most deltas to decode
+    std::vector<uint64_t> words; // The board decoded by the timed seek
+
+    makeRule(rule, header.birth, header.survive);
+    std::fprintf(output, "%s: %ux%u board, %s, %s edges\n", path, header.width, header.height, ruleName(rule).c_str(),
+                 header.edgeMode <= EDGE_MIRROR ? EDGE_NAMES[header.edgeMode] : "unknown");
+    std::fprintf(output, "generations %llu to %llu, %zu keyframes, one every %u generations\n",
+                 (unsigned long long)header.firstGeneration, reader.lastGeneration, reader.keyframes.size(),
+                 header.keyframeEvery);
+    std::fprintf(output, "%zu bytes, %.1f bytes per generation, %.4f of the boards it holds\n", reader.file.size,
+                 (double)reader.file.size / generations, reader.file.size / rawBytes);
+
+    farthest = std::min(reader.lastGeneration, (unsigned long long)(reader.keyframes[0].generation + header.keyframeEvery - 1));
+    auto t_start = std::chrono::high_resolution_clock::now();
+    bool found = seekHistory(reader, farthest, words); // Whether the seek worked
+    auto t_end = std::chrono::high_resolution_clock::now();
+    std::fprintf(output, "seek to generation %llu: %s in %.3f ms\n", farthest, found ? "decoded" : "failed",
+                 std::chrono::duration<double, std::milli>(t_end - t_start).count());
+}
+
+void writeBoard(FILE *output, const HistoryReader &reader, unsigned long long generation,
+                const std::vector<uint64_t> &words, bool populationOnly, ThreadPool &pool){
+    Simulation sim; // The board, put in the bit engine to be written
+    LifeRule rule; // The rule of the run
+    uint64_t population = 0;
+
+    if(populationOnly){
+        for(size_t i=0; i < words.size(); i++){
+            population += countBits(words[i]);
+        }
+        std::fprintf(output, "%llu %llu\n", generation, (unsigned long long)population);
+        return;
+    }
+    makeRule(rule, reader.header.birth, reader.header.survive);
+    restoreSimulation(sim, ENGINE_BIT, (EdgeMode)reader.header.edgeMode, rule, pool, (int)reader.header.width,
+                      (int)reader.header.height, words.data(), generation);
+    writeSimulation(output, sim, false);
+}
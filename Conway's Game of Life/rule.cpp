@@ -0,0 +1,94 @@
+// Conway's Game of Life
+// rule.cpp
+//
+// Rulestrings and lookup tables. See rule.h.
+
+#include "rule.h"
+#include <cctype>
+
+void makeRule(LifeRule &rule, uint16_t birth, uint16_t survive){
+    int n; // A neighbor count
+
+    rule.birth = birth & 0x1FF;
+    rule.survive = survive & 0x1FF;
+    for(n=0; n <= 8; n++){
+        rule.next[0][n] = (uint8_t)((rule.birth >> n) & 1);
+        rule.next[1][n] = (uint8_t)((rule.survive >> n) & 1);
+    }
+}
+
+bool parseRule(const char *text, LifeRule &rule){
+    uint16_t masks[2] = { 0, 0 }; // Counts read for each part, in the order they were written
+    uint16_t *target = nullptr; // The mask digits are going into
+    uint16_t birth = 0;
+    uint16_t survive = 0;
+    bool named = false; // Whether the parts are labelled with B and S
+    int part = 0; // The part being read, for the unlabelled style
+    const char *p;
+
+    for(p=text; *p != '\0'; p++){
+        char c = (char)std::toupper((unsigned char)*p);
+        if(c == 'B'){
+            named = true;
+            target = &birth;
+        }
+        else if(c == 'S'){
+            named = true;
+            target = &survive;
+        }
+        else if(c >= '0' && c <= '8'){
+            if(target == nullptr){
+                if(named){
+                    return false;
+                }
+                target = &masks[part];
+            }
+            *target |= (uint16_t)(1 << (c - '0'));
+        }
+        else if(c == '/'){
+            if(!named){
+                if(part == 1){
+                    return false;
+                }
+                part = 1;
+                target = nullptr;
+            }
+        }
+        else{
+            return false;
+        }
+    }
+
+    if(named){
+        makeRule(rule, birth, survive);
+    }
+    else{
+        if(part != 1){
+            return false;
+        }
+        makeRule(rule, masks[1], masks[0]); // survival/birth
+    }
+    return true;
+}
+
+std::string ruleName(const LifeRule &rule){
+    std::string name = "B";
+    int n; // A neighbor count
+
+    for(n=0; n <= 8; n++){
+        if((rule.birth >> n) & 1){
+            name += (char)('0' + n);
+        }
+    }
+    name += "/S";
+    for(n=0; n <= 8; n++){
+        if((rule.survive >> n) & 1){
+            name += (char)('0' + n);
+        }
+    }
+    return name;
+}
+
+bool isConwayRule(const LifeRule &rule){
+    return rule.birth == RULE_CONWAY_BIRTH && rule.survive == RULE_CONWAY_SURVIVE;
+}
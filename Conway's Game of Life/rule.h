@@ -0,0 +1,67 @@
+// Conway's Game of Life
+// rule.h
+//
+// Life-like rules. A rule says for which neighbor counts a dead cell is born and a living
+// cell survives, written as a rulestring such as B3/S23 (Conway's Life), B36/S23 (HighLife)
+// or B2/S (Seeds). The engines look the next state up in a small table instead of testing
+// the counts one by one, and the bit engine builds each rule out of word-wide logic.
+
+#ifndef RULE_H
+#define RULE_H
+
+#include <cstdint>
+#include <string>
+
+#define RULE_CONWAY_BIRTH (1 << 3)
+#define RULE_CONWAY_SURVIVE ((1 << 2) | (1 << 3))
+
+// LifeRule
+// Purpose: a rule and the lookup table made from it
+struct LifeRule{
+    uint16_t birth; // Bit n set: a dead cell with n living neighbors comes to life
+    uint16_t survive; // Bit n set: a living cell with n living neighbors stays alive
+    uint8_t next[2][9]; // The next state of a cell, as [current state][living neighbors]
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// makeRule
+// Purpose: build a rule and its lookup table from birth and survival masks
+// Input:
+//      rule - the rule to fill in
+//      birth - bit n set if a dead cell with n neighbors is born
+//      survive - bit n set if a living cell with n neighbors survives
+// Output:
+//      No return type.
+void makeRule(LifeRule &rule, uint16_t birth, uint16_t survive);
+
+// parseRule
+// Purpose: read a rulestring
+// Input:
+//      text - "B3/S23" style (case and the slash are optional, the parts may come in either order)
+//             or the older "23/3" survival/birth style
+//      rule - receives the rule
+// Output:
+//      Returns false if the text is not a rulestring.
+bool parseRule(const char *text, LifeRule &rule);
+
+// ruleName
+// Purpose: write a rule as a rulestring
+// Input:
+//      rule - the rule to write
+// Output:
+//      Returns the rule in B/S form, such as "B3/S23".
+std::string ruleName(const LifeRule &rule);
+
+// isConwayRule
+// Purpose: tell whether a rule is B3/S23
+// Input:
+//      rule - the rule to look at
+// Output:
+//      Returns true for Conway's Life.
+bool isConwayRule(const LifeRule &rule);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // RULE_H
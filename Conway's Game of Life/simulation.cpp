@@ -0,0 +1,507 @@
+// Conway's Game of Life
+// simulation.cpp
+//
+// One interface over all of the engines. See simulation.h.
+
+#include "simulation.h"
+#include "intlife.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+const char *const ENGINE_NAMES[] = { "int", "bit", "hash", "sparse", "byte" };
+
+bool parseEngineType(const char *name, EngineType &engine){
+    int i;
+
+    for(i=0; i <= ENGINE_BYTE; i++){
+        if(std::strcmp(name, ENGINE_NAMES[i]) == 0){
+            engine = (EngineType)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// setupSimulation
+// Purpose: fill in the fields shared by every way of starting a board
+// Input:
+//      sim, engine, edgeMode, rule, pool - as for initSimulation
+//      width, height - the size of the board
+// Output:
+//      No return type. The storage of the engine is not touched.
+static void setupSimulation(Simulation &sim, EngineType engine, EdgeMode edgeMode, const LifeRule &rule,
+                            ThreadPool &pool, int width, int height){
+    sim.engine = engine;
+    sim.edgeMode = edgeMode;
+    sim.rule = rule;
+    sim.width = width;
+    sim.height = height;
+    sim.generation = 0;
+    sim.pool = &pool;
+    sim.rowsPerBand = bandRows(height, pool);
+    sim.byteKernel = detectByteKernel();
+    sim.countStats = false;
+    clearStepStats(sim.stats);
+}
+
+void initSimulation(Simulation &sim, EngineType engine, EdgeMode edgeMode, const LifeRule &rule, ThreadPool &pool,
+                    size_t cacheBytes, TableType &seed){
+    setupSimulation(sim, engine, edgeMode, rule, pool, seed.width, seed.height);
+
+    if(engine == ENGINE_INT){
+        initTable(sim.backTable, seed.width, seed.height);
+        sim.frontTable.width = seed.width;
+        sim.frontTable.height = seed.height;
+        sim.frontTable.stride = seed.stride;
+        sim.frontTable.cells.swap(seed.cells);
+    }
+    else if(engine == ENGINE_BIT){
+        initBitTable(sim.bitFront, seed.width, seed.height);
+        initBitTable(sim.bitBack, seed.width, seed.height);
+        packTable(seed, sim.bitFront);
+    }
+    else if(engine == ENGINE_BYTE){
+        initByteTable(sim.byteFront, seed.width, seed.height);
+        initByteTable(sim.byteBack, seed.width, seed.height);
+        for(int y=0; y < seed.height; y++){
+            std::copy(tableRow(seed, y), tableRow(seed, y) + seed.width, byteRow(sim.byteFront, y));
+        }
+    }
+    else if(engine == ENGINE_HASH){
+        initHashLife(sim.hashLife, cacheBytes, rule);
+        hashLoadTable(sim.hashLife, seed);
+    }
+    else{
+        sparseLoadTable(sim.sparseLife, seed);
+    }
+
+    // Every engine but the int engine keeps its own copy, so give back the memory held by the seed
+    std::vector<int, AlignedAllocator<int> >().swap(seed.cells);
+}
+
+LoadResult loadSimulation(Simulation &sim, EngineType engine, EdgeMode edgeMode, const LifeRule &rule, ThreadPool &pool,
+                    size_t cacheBytes, const Pattern &pattern, int width, int height){
+    TableType seed; // hash engine only: the quadtree is built from a matrix
+    bool loaded; // Whether the pattern was well formed
+
+    // A file can ask for any size in its header; one too big to allocate is a bad file, not a crash
+    try{
+        setupSimulation(sim, engine, edgeMode, rule, pool, width, height);
+
+        if(engine == ENGINE_INT){
+            initTable(sim.frontTable, width, height);
+            initTable(sim.backTable, width, height);
+            loaded = readPattern(pattern, width, height, [&](int x, int y, int length){
+                std::fill(tableRow(sim.frontTable, y) + x, tableRow(sim.frontTable, y) + x + length, ALIVE);
+            });
+        }
+        else if(engine == ENGINE_BIT){
+            initBitTable(sim.bitFront, width, height);
+            initBitTable(sim.bitBack, width, height);
+            loaded = readPattern(pattern, width, height, [&](int x, int y, int length){
+                setBitRun(sim.bitFront, x, y, length);
+            });
+        }
+        else if(engine == ENGINE_BYTE){
+            initByteTable(sim.byteFront, width, height);
+            initByteTable(sim.byteBack, width, height);
+            loaded = readPattern(pattern, width, height, [&](int x, int y, int length){
+                std::memset(byteRow(sim.byteFront, y) + x, 1, length);
+            });
+        }
+        else if(engine == ENGINE_HASH){
+            initTable(seed, width, height);
+            loaded = readPattern(pattern, width, height, [&](int x, int y, int length){
+                std::fill(tableRow(seed, y) + x, tableRow(seed, y) + x + length, ALIVE);
+            });
+            initHashLife(sim.hashLife, cacheBytes, rule);
+            hashLoadTable(sim.hashLife, seed);
+        }
+        else{
+            initSparseLife(sim.sparseLife);
+            loaded = readPattern(pattern, width, height, [&](int x, int y, int length){
+                for(int i=0; i < length; i++){
+                    sparseSetCell(sim.sparseLife, x + i, y);
+                }
+            });
+        }
+    }
+    catch(const std::exception &){ // bad_alloc, or length_error for a size that does not even fit in memory
+        return LOAD_NO_MEMORY;
+    }
+    return loaded ? LOAD_OK : LOAD_BAD_PATTERN;
+}
+
+void restoreSimulation(Simulation &sim, EngineType engine, EdgeMode edgeMode, const LifeRule &rule, ThreadPool &pool,
+                       int width, int height, const uint64_t *words, unsigned long long generation){
+    int rowWords = (width + 63) / 64; // Words per packed row
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+
+    setupSimulation(sim, engine, edgeMode, rule, pool, width, height);
+    sim.generation = generation;
+
+    if(engine == ENGINE_BIT){
+        initBitTable(sim.bitFront, width, height);
+        initBitTable(sim.bitBack, width, height);
+        for(y=0; y < height; y++){
+            WordType *row = &sim.bitFront.words[(size_t)(y + 1) * sim.bitFront.wordsPerRow];
+            std::memcpy(row + 1, words + (size_t)y * rowWords, rowWords * sizeof(WordType));
+            row[rowWords] &= sim.bitFront.lastMask; // Cells past the edge are left to fillBitBorder
+        }
+    }
+    else if(engine == ENGINE_BYTE){
+        initByteTable(sim.byteFront, width, height);
+        initByteTable(sim.byteBack, width, height);
+        for(y=0; y < height; y++){
+            const uint64_t *packed = words + (size_t)y * rowWords;
+            uint8_t *row = byteRow(sim.byteFront, y);
+            for(x=0; x < width; x++){
+                row[x] = (uint8_t)((packed[x / 64] >> (x % 64)) & 1);
+            }
+        }
+    }
+    else{
+        initTable(sim.frontTable, width, height);
+        initTable(sim.backTable, width, height);
+        for(y=0; y < height; y++){
+            const uint64_t *packed = words + (size_t)y * rowWords;
+            int *row = tableRow(sim.frontTable, y);
+            for(x=0; x < width; x++){
+                row[x] = (int)((packed[x / 64] >> (x % 64)) & 1);
+            }
+        }
+    }
+}
+
+void advanceSimulation(Simulation &sim, unsigned long long generations){
+    unsigned long long g; // The generation currently being computed
+    StepStats *stats = (METRICS_ENABLED && sim.countStats) ? &sim.stats : nullptr; // Where the engines count
+    std::mutex statsLock; // Guards stats while the bands of the bit and byte engines add their counts to it
+
+    if(sim.engine == ENGINE_HASH){
+        hashAdvance(sim.hashLife, generations);
+        if(stats != nullptr){
+            clearStepStats(sim.stats);
+            sim.stats.cellsCounted = false;
+            sim.stats.population = hashPopulation(sim.hashLife);
+        }
+    }
+    else if(sim.engine == ENGINE_SPARSE){
+        for(g=0; g < generations; g++){
+            if(stats != nullptr){
+                clearStepStats(sim.stats);
+            }
+            sparseIterate(sim.sparseLife, sim.rule, stats);
+        }
+    }
+    else if(sim.engine == ENGINE_BIT){
+        for(g=0; g < generations; g++){
+            if(stats != nullptr){
+                clearStepStats(sim.stats);
+            }
+            fillBitBorder(sim.bitFront, sim.edgeMode);
+            sim.pool->parallelFor(0, sim.height, sim.rowsPerBand, [&](int firstRow, int endRow){
+                if(stats != nullptr){
+                    StepStats bandStats; // Counted without the lock, then added in once
+                    clearStepStats(bandStats);
+                    bitIterateRows(sim.bitFront, sim.bitBack, firstRow, endRow, sim.rule, &bandStats);
+                    std::lock_guard<std::mutex> hold(statsLock);
+                    mergeStepStats(*stats, bandStats);
+                }
+                else{
+                    bitIterateRows(sim.bitFront, sim.bitBack, firstRow, endRow, sim.rule, nullptr);
+                }
+            });
+            std::swap(sim.bitFront.words, sim.bitBack.words);
+        }
+    }
+    else if(sim.engine == ENGINE_BYTE){
+        for(g=0; g < generations; g++){
+            if(stats != nullptr){
+                clearStepStats(sim.stats);
+            }
+            fillByteBorder(sim.byteFront, sim.edgeMode);
+            sim.pool->parallelFor(0, sim.height, sim.rowsPerBand, [&](int firstRow, int endRow){
+                if(stats != nullptr){
+                    StepStats bandStats; // Counted without the lock, then added in once
+                    clearStepStats(bandStats);
+                    byteIterateRows(sim.byteFront, sim.byteBack, firstRow, endRow, sim.rule, sim.byteKernel, &bandStats);
+                    std::lock_guard<std::mutex> hold(statsLock);
+                    mergeStepStats(*stats, bandStats);
+                }
+                else{
+                    byteIterateRows(sim.byteFront, sim.byteBack, firstRow, endRow, sim.rule, sim.byteKernel, nullptr);
+                }
+            });
+            std::swap(sim.byteFront.cells, sim.byteBack.cells);
+        }
+    }
+    else{
+        for(g=0; g < generations; g++){
+            if(stats != nullptr){
+                clearStepStats(sim.stats);
+            }
+            iterate(sim.frontTable, sim.backTable, sim.edgeMode, sim.rule, *sim.pool, stats);
+            std::swap(sim.frontTable.cells, sim.backTable.cells);
+        }
+    }
+    sim.generation += generations;
+}
+
+void storeSimulation(const Simulation &sim, TableType &table){
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+
+    if(sim.engine == ENGINE_HASH){
+        hashStoreTable(sim.hashLife, table);
+    }
+    else if(sim.engine == ENGINE_SPARSE){
+        sparseStoreTable(sim.sparseLife, table);
+    }
+    else if(sim.engine == ENGINE_BIT){
+        for(y=0; y < sim.height; y++){
+            int *row = tableRow(table, y);
+            for(x=0; x < sim.width; x++){
+                row[x] = getBitCell(sim.bitFront, x, y);
+            }
+        }
+    }
+    else if(sim.engine == ENGINE_BYTE){
+        for(y=0; y < sim.height; y++){
+            std::copy(byteRow(sim.byteFront, y), byteRow(sim.byteFront, y) + sim.width, tableRow(table, y));
+        }
+    }
+    else{
+        for(y=0; y < sim.height; y++){
+            std::memcpy(tableRow(table, y), tableRow(sim.frontTable, y), sim.width * sizeof(int));
+        }
+    }
+}
+
+uint64_t simulationPopulation(const Simulation &sim){
+    uint64_t population = 0;
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+
+    if(sim.engine == ENGINE_HASH){
+        return hashPopulation(sim.hashLife);
+    }
+    if(sim.engine == ENGINE_SPARSE){
+        return sparsePopulation(sim.sparseLife);
+    }
+    if(sim.engine == ENGINE_BIT){
+        return bitPopulation(sim.bitFront);
+    }
+    if(sim.engine == ENGINE_BYTE){
+        for(y=0; y < sim.height; y++){
+            const uint8_t *row = byteRow(sim.byteFront, y);
+            for(x=0; x < sim.width; x++){
+                population += row[x];
+            }
+        }
+        return population;
+    }
+    for(y=0; y < sim.height; y++){
+        const int *row = tableRow(sim.frontTable, y);
+        for(x=0; x < sim.width; x++){
+            population += row[x];
+        }
+    }
+    return population;
+}
+
+// mixWord
+// Purpose: fold one word into a running fingerprint
+// Input:
+//      hash - the fingerprint so far
+//      word - the word to add
+// Output:
+//      Returns the new fingerprint.
+static inline uint64_t mixWord(uint64_t hash, uint64_t word){
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 31);
+}
+
+// packCellRow
+// Purpose: pack one row of the int or byte matrix into words, 64 cells to a word
+// Input:
+//      row - the first cell of the row
+//      width - the number of cells in the row
+//      word - the index of the word to fill, counting from 0
+// Output:
+//      Returns the packed word.
+template<typename Cell>
+static inline uint64_t packCellRow(const Cell *row, int width, int word){
+    uint64_t bits = 0;
+    int end = std::min(width, (word + 1) * 64); // One past the last cell of the word
+
+    for(int x=word * 64; x < end; x++){
+        bits |= (uint64_t)(row[x] != 0) << (x % 64);
+    }
+    return bits;
+}
+
+// sparseTileHash
+// Purpose: fingerprint one tile of the sparse engine together with its place on the plane
+// Input:
+//      key - the tile's key
+//      tile - the tile
+// Output:
+//      Returns the fingerprint, or 0 for an empty tile.
+static uint64_t sparseTileHash(TileKey key, const SparseTile &tile){
+    uint64_t hash = mixWord(0, key);
+    WordType any = 0; // Any living cell in the tile
+
+    for(int r=0; r < TILE_SIZE; r++){
+        hash = mixWord(hash, tile.cells[r]);
+        any |= tile.cells[r];
+    }
+    return any ? hash : 0;
+}
+
+uint64_t simulationHash(const Simulation &sim){
+    uint64_t hash = 0;
+    int y; // The row currently being looked at
+    int i; // The word currently being looked at
+
+    if(sim.engine == ENGINE_HASH){
+        return hashPlaneHash(sim.hashLife);
+    }
+    if(sim.engine == ENGINE_SPARSE){
+        // Summed so the order the map visits its tiles in does not matter
+        for(auto it = sim.sparseLife.tiles.begin(); it != sim.sparseLife.tiles.end(); ++it){
+            hash += sparseTileHash(it->first, it->second);
+        }
+        return hash;
+    }
+    if(sim.engine == ENGINE_BIT){
+        const BitTable &table = sim.bitFront;
+        for(y=1; y <= table.height; y++){
+            const WordType *row = &table.words[(size_t)y * table.wordsPerRow];
+            for(i=1; i < table.dataWords; i++){
+                hash = mixWord(hash, row[i]);
+            }
+            hash = mixWord(hash, row[table.dataWords] & table.lastMask); // the right ghost may share this word
+        }
+        return hash;
+    }
+    if(sim.engine == ENGINE_BYTE){
+        for(y=0; y < sim.height; y++){
+            const uint8_t *row = byteRow(sim.byteFront, y);
+            for(i=0; i * 64 < sim.width; i++){
+                hash = mixWord(hash, packCellRow(row, sim.width, i));
+            }
+        }
+        return hash;
+    }
+    for(y=0; y < sim.height; y++){
+        const int *row = tableRow(sim.frontTable, y);
+        for(i=0; i * 64 < sim.width; i++){
+            hash = mixWord(hash, packCellRow(row, sim.width, i));
+        }
+    }
+    return hash;
+}
+
+void snapshotSimulation(const Simulation &sim, std::vector<uint64_t> &snapshot){
+    int y; // The row currently being looked at
+    int i; // The word currently being looked at
+
+    snapshot.clear();
+    if(sim.engine == ENGINE_HASH){
+        std::vector<int64_t> cells; // x, y of each living cell
+        hashLiveCells(sim.hashLife, cells);
+        snapshot.assign(cells.begin(), cells.end());
+    }
+    else if(sim.engine == ENGINE_SPARSE){
+        std::vector<TileKey> keys; // The tiles with living cells, in order
+        for(auto it = sim.sparseLife.tiles.begin(); it != sim.sparseLife.tiles.end(); ++it){
+            if(sparseTileHash(it->first, it->second) != 0){
+                keys.push_back(it->first);
+            }
+        }
+        std::sort(keys.begin(), keys.end());
+        for(i=0; i < (int)keys.size(); i++){
+            const SparseTile &tile = sim.sparseLife.tiles.find(keys[i])->second;
+            snapshot.push_back(keys[i]);
+            snapshot.insert(snapshot.end(), tile.cells, tile.cells + TILE_SIZE);
+        }
+    }
+    else if(sim.engine == ENGINE_BIT){
+        const BitTable &table = sim.bitFront;
+        for(y=1; y <= table.height; y++){
+            const WordType *row = &table.words[(size_t)y * table.wordsPerRow];
+            snapshot.insert(snapshot.end(), row + 1, row + table.dataWords);
+            snapshot.push_back(row[table.dataWords] & table.lastMask);
+        }
+    }
+    else if(sim.engine == ENGINE_BYTE){
+        for(y=0; y < sim.height; y++){
+            const uint8_t *row = byteRow(sim.byteFront, y);
+            for(i=0; i * 64 < sim.width; i++){
+                snapshot.push_back(packCellRow(row, sim.width, i));
+            }
+        }
+    }
+    else{
+        for(y=0; y < sim.height; y++){
+            const int *row = tableRow(sim.frontTable, y);
+            for(i=0; i * 64 < sim.width; i++){
+                snapshot.push_back(packCellRow(row, sim.width, i));
+            }
+        }
+    }
+}
+
+void writeSimulation(FILE *output, const Simulation &sim, bool populationOnly){
+    std::string line; // One row of the board, built up before it is written
+    TableType scratch; // The plane under the board, for the engines that are not stored as a matrix
+    const TableType *table = &sim.frontTable;
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+
+    if(populationOnly){
+        std::fprintf(output, "%llu %llu\n", sim.generation, (unsigned long long)simulationPopulation(sim));
+        return;
+    }
+
+    std::fprintf(output, "# generation %llu population %llu\n", sim.generation, (unsigned long long)simulationPopulation(sim));
+
+    if(sim.engine == ENGINE_HASH || sim.engine == ENGINE_SPARSE){
+        initTable(scratch, sim.width, sim.height);
+        storeSimulation(sim, scratch);
+        table = &scratch;
+    }
+
+    line.resize((size_t)sim.width * 2);
+    for(y=0; y < sim.height; y++){
+        if(sim.engine == ENGINE_BIT){
+            for(x=0; x < sim.width; x++){
+                line[2*x] = getBitCell(sim.bitFront, x, y) ? '1' : '0';
+                line[2*x + 1] = ' ';
+            }
+        }
+        else if(sim.engine == ENGINE_BYTE){
+            const uint8_t *row = byteRow(sim.byteFront, y);
+            for(x=0; x < sim.width; x++){
+                line[2*x] = row[x] ? '1' : '0';
+                line[2*x + 1] = ' ';
+            }
+        }
+        else{
+            const int *row = tableRow(*table, y);
+            for(x=0; x < sim.width; x++){
+                line[2*x] = row[x] ? '1' : '0';
+                line[2*x + 1] = ' ';
+            }
+        }
+        line[line.size() - 1] = '\n';
+        std::fwrite(line.data(), 1, line.size(), output);
+    }
+}
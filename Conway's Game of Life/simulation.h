@@ -0,0 +1,186 @@
+// Conway's Game of Life
+// simulation.h
+//
+// Ties the engines together behind one interface, so the interactive loop and batch
+// runs can seed, advance, read back and write out a board without caring which engine
+// is stepping it.
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "grid.h"
+#include "metrics.h"
+#include "patternio.h"
+#include "rule.h"
+#include "bitlife.h"
+#include "bytelife.h"
+#include "hashlife.h"
+#include "sparselife.h"
+#include "threadpool.h"
+
+// EngineType
+// Purpose: which engine steps the matrix
+//      ENGINE_INT - the int matrix, one cell at a time
+//      ENGINE_BIT - the bit-packed table, 64 cells at a time
+//      ENGINE_HASH - the HashLife quadtree, any power of two generations at a time
+//      ENGINE_SPARSE - the tiled plane, only the tiles that are changing
+//      ENGINE_BYTE - the byte matrix, a SIMD vector of cells at a time
+enum EngineType{
+    ENGINE_INT,
+    ENGINE_BIT,
+    ENGINE_HASH,
+    ENGINE_SPARSE,
+    ENGINE_BYTE
+};
+
+extern const char *const ENGINE_NAMES[];
+
+// Simulation
+// Purpose: a board being stepped by one of the engines. Only the storage of that engine is used.
+struct Simulation{
+    EngineType engine; // The engine that steps the board
+    EdgeMode edgeMode; // How cells on the edge see past it
+    LifeRule rule; // The birth and survival counts
+    int width; // The number of columns on the board
+    int height; // The number of rows on the board
+    unsigned long long generation; // The number of the current generation
+    ThreadPool *pool; // The threads that share each generation
+    int rowsPerBand; // Rows each thread takes at once
+    TableType frontTable; // int engine: the current generation
+    TableType backTable; // int engine: receives the next generation
+    BitTable bitFront; // bit engine: the current generation
+    BitTable bitBack; // bit engine: receives the next generation
+    ByteTable byteFront; // byte engine: the current generation
+    ByteTable byteBack; // byte engine: receives the next generation
+    ByteKernel byteKernel; // byte engine: the instruction set it steps with, the widest the processor has unless changed
+    HashLife hashLife; // hash engine: the plane
+    SparseLife sparseLife; // sparse engine: the plane
+    bool countStats; // Whether the engines count stats while they step; only with METRICS_ENABLED
+    StepStats stats; // The counts of the last generation stepped, when countStats is set
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// parseEngineType
+// Purpose: turn an engine name given on the command line into an EngineType
+// Input:
+//      name - "int", "bit", "hash", "sparse" or "byte"
+//      engine - receives the parsed engine
+// Output:
+//      Returns true if the name was recognized.
+bool parseEngineType(const char *name, EngineType &engine);
+
+// initSimulation
+// Purpose: start a board from a seed
+// Input:
+//      sim - the simulation to set up
+//      engine - the engine that will step the board
+//      edgeMode - how cells on the edge see past it; the hash and sparse engines only support EDGE_DEAD
+//      rule - the rule to apply; the hash and sparse engines do not support B0
+//      pool - the threads that share each generation; must outlive the simulation
+//      cacheBytes - hash engine only: how much memory its node cache may use
+//      seed - the starting board, which also sets the size. Its cells are taken over and it is left empty.
+// Output:
+//      No return type.
+void initSimulation(Simulation &sim, EngineType engine, EdgeMode edgeMode, const LifeRule &rule, ThreadPool &pool,
+                    size_t cacheBytes, TableType &seed);
+
+// LoadResult
+// Purpose: how starting a board from a pattern file went
+//      LOAD_OK - the board holds the pattern
+//      LOAD_BAD_PATTERN - the pattern file is not well formed
+//      LOAD_NO_MEMORY - the board is too big to allocate; the file may be fine
+enum LoadResult{
+    LOAD_OK,
+    LOAD_BAD_PATTERN,
+    LOAD_NO_MEMORY
+};
+
+// loadSimulation
+// Purpose: start a board from a pattern file, writing its cells straight into the engine
+// Input:
+//      sim, engine, edgeMode, rule, pool, cacheBytes - as for initSimulation
+//      pattern - the open pattern file to read the seed from
+//      width - the number of columns on the board
+//      height - the number of rows on the board
+// Output:
+//      Returns LOAD_OK, or why the board could not be started.
+LoadResult loadSimulation(Simulation &sim, EngineType engine, EdgeMode edgeMode, const LifeRule &rule, ThreadPool &pool,
+                    size_t cacheBytes, const Pattern &pattern, int width, int height);
+
+// restoreSimulation
+// Purpose: start a board from cells packed 64 to a word, as recorded by snapshotSimulation
+// Input:
+//      sim, engine, edgeMode, rule, pool - as for initSimulation; the int, bit and byte engines only
+//      width - the number of columns on the board
+//      height - the number of rows on the board
+//      words - the cells, row by row, each row (width + 63) / 64 words with bit n of word i being column 64i + n
+//      generation - the number of the generation the cells belong to
+// Output:
+//      No return type. The bit engine copies each row as it is; the int and byte engines unpack it.
+void restoreSimulation(Simulation &sim, EngineType engine, EdgeMode edgeMode, const LifeRule &rule, ThreadPool &pool,
+                       int width, int height, const uint64_t *words, unsigned long long generation);
+
+// advanceSimulation
+// Purpose: step the board forward
+// Input:
+//      sim - the simulation to advance
+//      generations - the number of generations to advance
+// Output:
+//      No return type. Nothing is displayed or written while the board is advanced. With countStats
+//      set, stats describes the last generation; the hash engine only gives its population.
+void advanceSimulation(Simulation &sim, unsigned long long generations);
+
+// storeSimulation
+// Purpose: copy the current generation into a matrix
+// Input:
+//      sim - the simulation to copy from
+//      table - the matrix to fill; must be the size of the board
+// Output:
+//      No return type. The hash and sparse engines copy the part of the plane under the board.
+void storeSimulation(const Simulation &sim, TableType &table);
+
+// simulationPopulation
+// Purpose: count the living cells
+// Input:
+//      sim - the simulation to look at
+// Output:
+//      Returns the number of living cells; the hash and sparse engines count the whole plane.
+uint64_t simulationPopulation(const Simulation &sim);
+
+// simulationHash
+// Purpose: fingerprint the current generation, for spotting repeats
+// Input:
+//      sim - the simulation to look at
+// Output:
+//      Returns a value that is always equal for equal generations and almost always differs otherwise.
+//      The hash and sparse engines fingerprint the whole plane, so a moving pattern never repeats.
+uint64_t simulationHash(const Simulation &sim);
+
+// snapshotSimulation
+// Purpose: record the current generation exactly, so it can be compared with a later one
+// Input:
+//      sim - the simulation to record
+//      snapshot - receives the record; two records are equal only if their generations are
+// Output:
+//      No return type.
+void snapshotSimulation(const Simulation &sim, std::vector<uint64_t> &snapshot);
+
+// writeSimulation
+// Purpose: write the current generation in the same 0/1 grid format that seeds are read in
+// Input:
+//      output - the file to write to
+//      sim - the simulation to write
+//      populationOnly - write only the generation and population on one line instead of the board
+// Output:
+//      No return type. A board is preceded by a "#" comment line giving its generation and population.
+void writeSimulation(FILE *output, const Simulation &sim, bool populationOnly);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // SIMULATION_H
@@ -0,0 +1,293 @@
+// Conway's Game of Life
+// soup.cpp
+//
+// Soup search: runs a numbered range of random soups until each one dies out, stops
+// changing or starts to oscillate, and writes one record per soup with what it settled
+// into, when, its final population and a fingerprint of the final pattern that is the
+// same wherever the pattern ended up and whichever way round it is. See soupsearch.h.
+//
+// Usage: LifeSoup [-count N] [-first I] [-key K] [-size WIDTHxHEIGHT] [-soup S] [-edge dead|torus|mirror]
+//                 [-rule RULE] [-max-generations G] [-max-period P] [-threads N] [-format csv|jsonl]
+//                 [-output FILE] [-show I]
+//      -count - the number of soups to run (default 100000)
+//      -first - the number of the first soup (default 0)
+//      -key - picks the sequence of soups; the same key and number always give the same soup (default 1)
+//      -size - the size of each board (default 32x32)
+//      -soup - the soup fills an SxS square of random cells, half of them alive, in the middle of the board (default 16)
+//      -edge - how cells on the edge of a board see past it (default dead)
+//      -rule - the rule to run (default B3/S23)
+//      -max-generations - give up on a soup that has not settled after G generations (default 10000)
+//      -max-period - the longest oscillator period looked for (default 30)
+//      -threads - the number of threads sharing the soups (default 0, one per core)
+//      -format - csv (default) or jsonl, one JSON object per line
+//      -output - write to FILE instead of standard output
+//      -show - write the starting board of soup I in the 0/1 grid format, to run with GameOfLife -seed
+//
+// A summary with the number of soups per second is written to standard error.
+//
+// Build: g++ -O2 -pthread soup.cpp soupsearch.cpp grid.cpp rule.cpp threadpool.cpp -o LifeSoup
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "grid.h"
+#include "rule.h"
+#include "soupsearch.h"
+#include "threadpool.h"
+
+#define DEFAULT_COUNT 100000
+#define DEFAULT_SIZE 32
+#define DEFAULT_SOUP 16
+#define DEFAULT_MAX_GENERATIONS 10000
+#define DEFAULT_MAX_PERIOD 30
+#define TASK_SOUPS 1024 // Soups handed to a thread at once, enough to keep all 64 lanes busy for most of the task
+#define TASKS_PER_THREAD 16 // Tasks per thread in each chunk, so threads that finish early can steal the rest
+#define OUTPUT_BUFFER_BYTES (1 << 20)
+
+const char *const OUTCOME_NAMES[] = { "unsettled", "extinct", "still", "oscillator" }; // By CycleKind
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// writeSoupResult
+// Purpose: write the record of one soup
+// Input:
+//      output - the file to write to
+//      json - true for a JSON object, false for a CSV line
+//      index - the number of the soup
+//      result - what it settled into
+// Output:
+//      No return type.
+void writeSoupResult(FILE *output, bool json, uint64_t index, const SoupResult &result);
+
+// showSoup
+// Purpose: write the starting board of one soup in the 0/1 grid format
+// Input:
+//      output - the file to write to
+//      config - how the soups are made
+//      index - the number of the soup
+// Output:
+//      No return type.
+void showSoup(FILE *output, const SoupConfig &config, uint64_t index);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+int main(int argc, char* argv[]){
+    SoupConfig config; // How the soups are made and run
+    unsigned long long count = DEFAULT_COUNT; // The number of soups to run
+    unsigned long long first = 0; // The number of the first soup
+    unsigned long long key = 1; // Picks the sequence of soups
+    unsigned long long show = 0; // The soup to write out
+    bool showGiven = false; // Whether -show was given
+    int numThreads = 0; // The number of threads sharing the soups
+    bool json = false; // Write JSON lines instead of CSV
+    const char *outputPath = nullptr; // File the records go to, if not standard output
+    FILE *output = stdout; // Where the records go
+    std::vector<SoupResult> results; // The records of one chunk of soups
+    unsigned long long counts[CYCLE_OSCILLATOR + 1] = { 0, 0, 0, 0 }; // Soups by outcome
+    unsigned long long done; // Soups run so far
+
+    config.width = DEFAULT_SIZE;
+    config.height = DEFAULT_SIZE;
+    config.soupSize = DEFAULT_SOUP;
+    config.edgeMode = EDGE_DEAD;
+    config.maxGenerations = DEFAULT_MAX_GENERATIONS;
+    config.maxPeriod = DEFAULT_MAX_PERIOD;
+    makeRule(config.rule, RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVE);
+
+    for(int i=1; i < argc; i++){
+        if(std::strcmp(argv[i], "-count") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%llu", &count) != 1 || argv[i][0] == '-'){
+                std::cerr << "ERROR, count must be a number of soups: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-first") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%llu", &first) != 1 || argv[i][0] == '-'){
+                std::cerr << "ERROR, first must be the number of a soup: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-key") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%llu", &key) != 1 || argv[i][0] == '-'){
+                std::cerr << "ERROR, key must be a number: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-size") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%dx%d", &config.width, &config.height) != 2 || config.width < 1 || config.height < 1){
+                std::cerr << "ERROR, size must look like 32x32: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-soup") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%d", &config.soupSize) != 1 || config.soupSize < 1){
+                std::cerr << "ERROR, soup must be at least 1: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-edge") == 0 && i+1 < argc){
+            i++;
+            if(!parseEdgeMode(argv[i], config.edgeMode)){
+                std::cerr << "ERROR, unknown edge mode: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-rule") == 0 && i+1 < argc){
+            i++;
+            if(!parseRule(argv[i], config.rule)){
+                std::cerr << "ERROR, rule must look like B3/S23: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-max-generations") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%d", &config.maxGenerations) != 1 || config.maxGenerations < 1){
+                std::cerr << "ERROR, max-generations must be at least 1: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-max-period") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%d", &config.maxPeriod) != 1 || config.maxPeriod < 1){
+                std::cerr << "ERROR, max-period must be at least 1: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-threads") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%d", &numThreads) != 1 || numThreads < 0){
+                std::cerr << "ERROR, thread count must be 0 or more: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if(std::strcmp(argv[i], "-format") == 0 && i+1 < argc){
+            i++;
+            if(std::strcmp(argv[i], "csv") != 0 && std::strcmp(argv[i], "jsonl") != 0){
+                std::cerr << "ERROR, format must be csv or jsonl: " << argv[i] << "\n";
+                return 1;
+            }
+            json = (std::strcmp(argv[i], "jsonl") == 0);
+        }
+        else if(std::strcmp(argv[i], "-output") == 0 && i+1 < argc){
+            outputPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "-show") == 0 && i+1 < argc){
+            i++;
+            if(std::sscanf(argv[i], "%llu", &show) != 1 || argv[i][0] == '-'){
+                std::cerr << "ERROR, show must be the number of a soup: " << argv[i] << "\n";
+                return 1;
+            }
+            showGiven = true;
+        }
+        else{
+            std::cerr << "Usage: " << argv[0] << " [-count N] [-first I] [-key K] [-size WIDTHxHEIGHT] [-soup S]"
+                      << " [-edge dead|torus|mirror] [-rule RULE] [-max-generations G] [-max-period P] [-threads N]"
+                      << " [-format csv|jsonl] [-output FILE] [-show I]\n";
+            return 1;
+        }
+    }
+    if(config.soupSize > config.width || config.soupSize > config.height){
+        std::cerr << "ERROR, the soup does not fit on a " << config.width << "x" << config.height << " board\n";
+        return 1;
+    }
+    config.key = key;
+
+    if(outputPath != nullptr){
+        output = std::fopen(outputPath, "w");
+        if(output == nullptr){
+            std::cerr << "ERROR, could not open " << outputPath << " for writing\n";
+            return 1;
+        }
+    }
+    std::setvbuf(output, nullptr, _IOFBF, OUTPUT_BUFFER_BYTES);
+
+    if(showGiven){
+        showSoup(output, config, show);
+    }
+    else{
+        ThreadPool pool(numThreads); // Shares each chunk of soups
+        unsigned long long chunk = (unsigned long long)TASK_SOUPS * TASKS_PER_THREAD * pool.threadCount(); // Soups per chunk
+        auto t_start = std::chrono::high_resolution_clock::now();
+
+        if(!json){
+            std::fprintf(output, "soup,outcome,generations,period,population,hash\n");
+        }
+        // The soups are run a chunk at a time so the records can be written in order as they go
+        for(done=0; done < count; done += chunk){
+            unsigned long long size = std::min(chunk, count - done); // Soups in this chunk
+            int tasks = (int)((size + TASK_SOUPS - 1) / TASK_SOUPS);
+            results.resize(size);
+            pool.parallelFor(0, tasks, 1, [&](int begin, int end){
+                for(int task=begin; task < end; task++){
+                    unsigned long long start = (unsigned long long)task * TASK_SOUPS; // The task's first soup in the chunk
+                    searchSoups(config, first + done + start, (int)std::min((unsigned long long)TASK_SOUPS, size - start),
+                                &results[start]);
+                }
+            });
+            for(unsigned long long i=0; i < size; i++){
+                writeSoupResult(output, json, first + done + i, results[i]);
+                counts[results[i].kind]++;
+            }
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+        std::fprintf(stderr, "%llu soups in %.3f seconds, %.0f soups/second on %d threads\n", count, seconds,
+                     count / seconds, pool.threadCount());
+        std::fprintf(stderr, "%llu extinct, %llu still, %llu oscillating, %llu unsettled after %d generations\n",
+                     counts[CYCLE_EXTINCT], counts[CYCLE_STILL], counts[CYCLE_OSCILLATOR], counts[CYCLE_NONE],
+                     config.maxGenerations);
+    }
+
+    if(std::fflush(output) != 0 || (output != stdout && std::fclose(output) != 0)){
+        std::cerr << "ERROR, could not finish writing the output\n";
+        return 1;
+    }
+    return 0;
+}
+
+void writeSoupResult(FILE *output, bool json, uint64_t index, const SoupResult &result){
+    if(json){
+        std::fprintf(output, "{\"soup\":%llu,\"outcome\":\"%s\",\"generations\":%d,\"period\":%d,\"population\":%llu,"
+                             "\"hash\":\"%016llx\"}\n",
+                     (unsigned long long)index, OUTCOME_NAMES[result.kind], result.generations, result.period,
+                     (unsigned long long)result.population, (unsigned long long)result.hash);
+    }
+    else{
+        std::fprintf(output, "%llu,%s,%d,%d,%llu,%016llx\n", (unsigned long long)index, OUTCOME_NAMES[result.kind],
+                     result.generations, result.period, (unsigned long long)result.population,
+                     (unsigned long long)result.hash);
+    }
+}
+
+void showSoup(FILE *output, const SoupConfig &config, uint64_t index){
+    TableType table; // The starting board
+    int population = 0;
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+
+    initTable(table, config.width, config.height);
+    makeSoup(config, index, table);
+    for(y=0; y < config.height; y++){
+        for(x=0; x < config.width; x++){
+            population += tableRow(table, y)[x];
+        }
+    }
+    std::fprintf(output, "# soup %llu key %llu population %d\n", (unsigned long long)index,
+                 (unsigned long long)config.key, population);
+    for(y=0; y < config.height; y++){
+        for(x=0; x < config.width; x++){
+            std::fprintf(output, (x + 1 < config.width) ? "%d " : "%d\n", tableRow(table, y)[x]);
+        }
+    }
+}
@@ -0,0 +1,427 @@
+// Conway's Game of Life
+// soupsearch.cpp
+//
+// Bit-sliced stepping of many soups at once. See soupsearch.h.
+
+#include "soupsearch.h"
+#include <algorithm>
+#include <utility>
+
+// SlicedSearch
+// Purpose: the boards of one call to searchSoups
+struct SlicedSearch{
+    const SoupConfig *config; // How the soups are made and run
+    int stride; // Words from one row to the next: the board plus a border cell at each end
+    size_t boardWords; // Words in one generation, border included
+    int slots; // Generations kept, maxPeriod + 1
+    int current; // The slot holding the current generation
+    std::vector<uint64_t> history; // slots generations of boardWords words each
+    std::vector<uint64_t> columnSum; // Per column of a row: bit 0 of above + middle + below
+    std::vector<uint64_t> columnCarry; // Per column of a row: bit 1 of above + middle + below
+    uint64_t birthMask[9]; // All ones where the rule has birth on n neighbors
+    uint64_t surviveMask[9]; // All ones where the rule has survival on n neighbors
+};
+
+// nextRandom
+// Purpose: step a small random number generator (splitmix64)
+// Input:
+//      state - the generator state, updated
+// Output:
+//      Returns the next random 64-bit number.
+static inline uint64_t nextRandom(uint64_t &state){
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// mixWord
+// Purpose: fold one word into a running fingerprint
+// Input:
+//      hash - the fingerprint so far
+//      word - the word to add
+// Output:
+//      Returns the new fingerprint.
+static inline uint64_t mixWord(uint64_t hash, uint64_t word){
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 31);
+}
+
+// soupCells
+// Purpose: make the cells of one soup, one random bit per cell
+// Input:
+//      config - how the soups are made
+//      index - the number of the soup
+//      bits - receives soupSize x soupSize bits, row by row, 64 to a word
+// Output:
+//      No return type.
+static void soupCells(const SoupConfig &config, uint64_t index, std::vector<uint64_t> &bits){
+    uint64_t state = config.key ^ (index * 0xD1B54A32D192ED03ull); // Each soup gets its own generator
+    size_t cells = (size_t)config.soupSize * config.soupSize;
+
+    nextRandom(state);
+    bits.resize((cells + 63) / 64);
+    for(size_t i=0; i < bits.size(); i++){
+        bits[i] = nextRandom(state);
+    }
+}
+
+// slotBoard
+// Purpose: find a generation kept in the history
+// Input:
+//      search - the boards
+//      back - how many generations before the current one
+// Output:
+//      Returns the word of the top left border cell of that generation.
+static inline uint64_t *slotBoard(SlicedSearch &search, int back){
+    int slot = (search.current - back + search.slots) % search.slots;
+    return &search.history[(size_t)slot * search.boardWords];
+}
+
+// fillSlicedBorder
+// Purpose: set the border cells around a board for the edge mode; a dead border is never written
+// Input:
+//      board - the board to fill
+//      width, height, stride - its shape
+//      edgeMode - how cells on the edge see past it
+// Output:
+//      No return type.
+static void fillSlicedBorder(uint64_t *board, int width, int height, int stride, EdgeMode edgeMode){
+    int x;
+    int y;
+
+    if(edgeMode == EDGE_DEAD){
+        return;
+    }
+    for(y=1; y <= height; y++){
+        uint64_t *row = board + (size_t)y * stride;
+        row[0] = (edgeMode == EDGE_TORUS) ? row[width] : row[1];
+        row[width + 1] = (edgeMode == EDGE_TORUS) ? row[1] : row[width];
+    }
+    for(x=0; x < stride; x++){
+        board[x] = board[(size_t)((edgeMode == EDGE_TORUS) ? height : 1) * stride + x];
+        board[(size_t)(height + 1) * stride + x] = board[(size_t)((edgeMode == EDGE_TORUS) ? 1 : height) * stride + x];
+    }
+}
+
+// stepSliced
+// Purpose: step every board one generation, from the current slot into the next
+// Input:
+//      search - the boards; the current slot moves on by one
+// Output:
+//      No return type.
+template<bool CONWAY>
+static void stepSliced(SlicedSearch &search){
+    const SoupConfig &config = *search.config;
+    uint64_t *from = slotBoard(search, 0);
+    uint64_t *to;
+    uint64_t *sum = search.columnSum.data();
+    uint64_t *carry = search.columnCarry.data();
+    int stride = search.stride;
+    int x;
+    int y;
+
+    fillSlicedBorder(from, config.width, config.height, stride, config.edgeMode);
+    search.current = (search.current + 1) % search.slots;
+    to = slotBoard(search, 0);
+
+    for(y=1; y <= config.height; y++){
+        const uint64_t *above = from + (size_t)(y - 1) * stride;
+        const uint64_t *middle = from + (size_t)y * stride;
+        const uint64_t *below = from + (size_t)(y + 1) * stride;
+        uint64_t *out = to + (size_t)y * stride;
+
+        // Each column's three cells are added once and shared by the cells either side of it
+        for(x=0; x < stride; x++){
+            sum[x] = above[x] ^ middle[x] ^ below[x];
+            carry[x] = (above[x] & middle[x]) | (middle[x] & below[x]) | (above[x] & below[x]);
+        }
+
+        for(x=1; x <= config.width; x++){
+            uint64_t alive = middle[x];
+            uint64_t centerSum = above[x] ^ below[x]; // The center column without the cell itself
+            uint64_t centerCarry = above[x] & below[x];
+            uint64_t leftSum = sum[x-1];
+            uint64_t rightSum = sum[x+1];
+
+            // Add the three columns, two bits each, into the four bits of the neighbor count
+            uint64_t count0 = leftSum ^ centerSum ^ rightSum;
+            uint64_t carry0 = (leftSum & centerSum) | (centerSum & rightSum) | (leftSum & rightSum);
+            uint64_t half1 = carry[x-1] ^ centerCarry;
+            uint64_t high1 = carry[x-1] & centerCarry;
+            uint64_t half2 = carry[x+1] ^ carry0;
+            uint64_t high2 = carry[x+1] & carry0;
+            uint64_t count1 = half1 ^ half2;
+            uint64_t high3 = half1 & half2;
+            uint64_t count2 = high1 ^ high2 ^ high3;
+            uint64_t count3 = (high1 & high2) | (high3 & (high1 ^ high2));
+
+            if(CONWAY){
+                out[x] = ~count3 & ~count2 & count1 & (count0 | alive);
+            }
+            else{
+                uint64_t next = 0;
+                for(int n=0; n <= 8; n++){
+                    if(search.birthMask[n] | search.surviveMask[n]){
+                        uint64_t lives = (alive & search.surviveMask[n]) | (~alive & search.birthMask[n]); // Lanes that live on n
+                        next |= lives & ((n & 1) ? count0 : ~count0) & ((n & 2) ? count1 : ~count1)
+                                      & ((n & 4) ? count2 : ~count2) & ((n & 8) ? count3 : ~count3);
+                    }
+                }
+                out[x] = next;
+            }
+        }
+    }
+}
+
+// loadLane
+// Purpose: put a soup into one bit of the current generation
+// Input:
+//      search - the boards
+//      lane - the bit to fill
+//      index - the number of the soup
+//      bits - scratch for the soup's cells
+// Output:
+//      No return type.
+static void loadLane(SlicedSearch &search, int lane, uint64_t index, std::vector<uint64_t> &bits){
+    const SoupConfig &config = *search.config;
+    uint64_t *board = slotBoard(search, 0);
+    uint64_t bit = (uint64_t)1 << lane;
+    int left = (config.width - config.soupSize) / 2; // Where the soup goes
+    int top = (config.height - config.soupSize) / 2;
+    int x;
+    int y;
+
+    for(y=1; y <= config.height; y++){
+        uint64_t *row = board + (size_t)y * search.stride;
+        for(x=1; x <= config.width; x++){
+            row[x] &= ~bit;
+        }
+    }
+    soupCells(config, index, bits);
+    for(y=0; y < config.soupSize; y++){
+        uint64_t *row = board + (size_t)(top + y + 1) * search.stride + left + 1;
+        for(x=0; x < config.soupSize; x++){
+            size_t cell = (size_t)y * config.soupSize + x;
+            row[x] |= ((bits[cell / 64] >> (cell % 64)) & 1) << lane;
+        }
+    }
+}
+
+// laneCells
+// Purpose: list the living cells of one board in a kept generation
+// Input:
+//      search - the boards
+//      back - how many generations before the current one
+//      lane - the board
+//      cells - receives x, y of each living cell
+// Output:
+//      No return type.
+static void laneCells(SlicedSearch &search, int back, int lane, std::vector<std::pair<int, int> > &cells){
+    const SoupConfig &config = *search.config;
+    const uint64_t *board = slotBoard(search, back);
+    int x;
+    int y;
+
+    cells.clear();
+    for(y=1; y <= config.height; y++){
+        const uint64_t *row = board + (size_t)y * search.stride;
+        for(x=1; x <= config.width; x++){
+            if((row[x] >> lane) & 1){
+                cells.push_back(std::make_pair(x - 1, y - 1));
+            }
+        }
+    }
+}
+
+// canonicalHash
+// Purpose: fingerprint a pattern the same way wherever it is and whichever way round it is
+// Input:
+//      cells - its living cells
+//      scratch - room for the turned copies
+// Output:
+//      Returns the smallest fingerprint of the eight rotations and reflections, each moved to the origin.
+static uint64_t canonicalHash(const std::vector<std::pair<int, int> > &cells, std::vector<std::pair<int, int> > &scratch){
+    uint64_t best = ~(uint64_t)0;
+
+    for(int turn=0; turn < 8; turn++){
+        int minX = 0;
+        int minY = 0;
+        uint64_t hash = mixWord(0, cells.size());
+
+        scratch.resize(cells.size());
+        for(size_t i=0; i < cells.size(); i++){
+            int x = (turn & 1) ? -cells[i].first : cells[i].first;
+            int y = (turn & 2) ? -cells[i].second : cells[i].second;
+            scratch[i] = (turn & 4) ? std::make_pair(y, x) : std::make_pair(x, y);
+            minX = (i == 0) ? scratch[i].first : std::min(minX, scratch[i].first);
+            minY = (i == 0) ? scratch[i].second : std::min(minY, scratch[i].second);
+        }
+        for(size_t i=0; i < scratch.size(); i++){
+            scratch[i].first -= minX;
+            scratch[i].second -= minY;
+        }
+        std::sort(scratch.begin(), scratch.end());
+        for(size_t i=0; i < scratch.size(); i++){
+            hash = mixWord(hash, ((uint64_t)(uint32_t)scratch[i].second << 32) | (uint32_t)scratch[i].first);
+        }
+        best = std::min(best, hash);
+    }
+    return best;
+}
+
+// recordLane
+// Purpose: fill in the result of a board once it has settled or run out of generations
+// Input:
+//      search - the boards
+//      lane - the board
+//      period - the period it repeats with, or 0 if it has not settled
+//      generations - the first generation of the repeating part, or the generation it was given up at
+//      result - receives the result
+// Output:
+//      No return type.
+static void recordLane(SlicedSearch &search, int lane, int period, int generations, SoupResult &result){
+    std::vector<std::pair<int, int> > cells; // The living cells of one phase
+    std::vector<std::pair<int, int> > scratch; // Room for canonicalHash
+    int phase;
+
+    laneCells(search, 0, lane, cells);
+    result.period = period;
+    result.generations = generations;
+    result.population = cells.size();
+    if(period == 0){
+        result.kind = CYCLE_NONE;
+        result.hash = canonicalHash(cells, scratch);
+        return;
+    }
+    result.kind = cells.empty() ? CYCLE_EXTINCT : (period == 1) ? CYCLE_STILL : CYCLE_OSCILLATOR;
+
+    // Every phase of an oscillator is kept in the history, so the smallest of their fingerprints
+    // is the same whichever phase the cycle was caught in
+    result.hash = canonicalHash(cells, scratch);
+    for(phase=1; phase < period; phase++){
+        laneCells(search, phase, lane, cells);
+        result.hash = std::min(result.hash, canonicalHash(cells, scratch));
+    }
+}
+
+void searchSoups(const SoupConfig &config, uint64_t first, int count, SoupResult *results){
+    SlicedSearch search; // The boards
+    int soupOf[SOUP_LANES]; // The result slot of the soup in each lane
+    int age[SOUP_LANES]; // Generations each lane's soup has run
+    uint64_t running = 0; // Lanes holding a soup
+    int loaded = 0; // Soups put into a lane so far
+    std::vector<uint64_t> bits; // Scratch for soupCells
+    int lane;
+    int p;
+
+    search.config = &config;
+    search.stride = config.width + 2;
+    search.boardWords = (size_t)search.stride * (config.height + 2);
+    search.slots = config.maxPeriod + 1;
+    search.current = 0;
+    search.history.assign(search.boardWords * search.slots, 0);
+    search.columnSum.resize(search.stride);
+    search.columnCarry.resize(search.stride);
+    for(p=0; p <= 8; p++){
+        search.birthMask[p] = ((config.rule.birth >> p) & 1) ? ~(uint64_t)0 : 0;
+        search.surviveMask[p] = ((config.rule.survive >> p) & 1) ? ~(uint64_t)0 : 0;
+    }
+
+    for(lane=0; lane < SOUP_LANES && loaded < count; lane++){
+        loadLane(search, lane, first + loaded, bits);
+        soupOf[lane] = loaded++;
+        age[lane] = 0;
+        running |= (uint64_t)1 << lane;
+    }
+
+    while(running != 0){
+        uint64_t settled = 0; // Lanes whose cycle has been found this generation
+
+        if(isConwayRule(config.rule)){
+            stepSliced<true>(search);
+        }
+        else{
+            stepSliced<false>(search);
+        }
+        for(lane=0; lane < SOUP_LANES; lane++){
+            age[lane]++;
+        }
+
+        // Compare with each of the last maxPeriod generations, shortest period first. Lanes only
+        // take part for periods they have lived through, and a comparison stops as soon as every
+        // lane taking part is known to differ, which for boards still changing is almost at once.
+        for(p=1; p <= config.maxPeriod; p++){
+            uint64_t candidates = 0; // Lanes that could repeat with period p
+            uint64_t differ = 0; // Lanes seen to differ from p generations ago
+            const uint64_t *now = slotBoard(search, 0);
+            const uint64_t *then = slotBoard(search, p);
+
+            for(lane=0; lane < SOUP_LANES; lane++){
+                if(age[lane] >= p){
+                    candidates |= (uint64_t)1 << lane;
+                }
+            }
+            candidates &= running & ~settled;
+            if(candidates == 0){
+                continue;
+            }
+            for(int y=1; y <= config.height && (differ & candidates) != candidates; y++){
+                const uint64_t *nowRow = now + (size_t)y * search.stride;
+                const uint64_t *thenRow = then + (size_t)y * search.stride;
+                for(int x=1; x <= config.width; x++){
+                    differ |= nowRow[x] ^ thenRow[x];
+                }
+            }
+            for(uint64_t found = candidates & ~differ; found != 0; found &= found - 1){
+                lane = __builtin_ctzll(found);
+                recordLane(search, lane, p, age[lane] - p, results[soupOf[lane]]);
+                settled |= (uint64_t)1 << lane;
+            }
+        }
+
+        for(lane=0; lane < SOUP_LANES; lane++){
+            uint64_t bit = (uint64_t)1 << lane;
+            if((running & bit) && !(settled & bit) && age[lane] >= config.maxGenerations){
+                recordLane(search, lane, 0, age[lane], results[soupOf[lane]]);
+                settled |= bit;
+            }
+        }
+
+        // Refill the lanes that are done, or empty them once there are no soups left
+        for(uint64_t done = settled; done != 0; done &= done - 1){
+            lane = __builtin_ctzll(done);
+            if(loaded < count){
+                loadLane(search, lane, first + loaded, bits);
+                soupOf[lane] = loaded++;
+                age[lane] = 0;
+            }
+            else{
+                uint64_t *board = slotBoard(search, 0);
+                for(size_t i=0; i < search.boardWords; i++){
+                    board[i] &= ~((uint64_t)1 << lane);
+                }
+                running &= ~((uint64_t)1 << lane);
+            }
+        }
+    }
+}
+
+void makeSoup(const SoupConfig &config, uint64_t index, TableType &table){
+    std::vector<uint64_t> bits; // The soup's cells
+    int left = (config.width - config.soupSize) / 2;
+    int top = (config.height - config.soupSize) / 2;
+
+    soupCells(config, index, bits);
+    for(int y=0; y < config.height; y++){
+        std::fill(tableRow(table, y), tableRow(table, y) + config.width, 0);
+    }
+    for(int y=0; y < config.soupSize; y++){
+        int *row = tableRow(table, top + y) + left;
+        for(int x=0; x < config.soupSize; x++){
+            size_t cell = (size_t)y * config.soupSize + x;
+            row[x] = (int)((bits[cell / 64] >> (cell % 64)) & 1);
+        }
+    }
+}
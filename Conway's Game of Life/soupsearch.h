@@ -0,0 +1,73 @@
+// Conway's Game of Life
+// soupsearch.h
+//
+// Running a great many small random boards ("soups") to see what each one settles into.
+// The boards are bit-sliced: every cell of the board is one 64-bit word, and bit b of each
+// word belongs to board b, so one pass of word-wide adder logic steps 64 boards at once.
+// A board that settles is recorded and its bit is refilled with the next soup straight
+// away, so the words stay full of boards that are still running.
+//
+// Each soup is made from its number alone, so a soup gives the same result however the
+// search is split up, and any soup can be written out again to look at it in the game.
+
+#ifndef SOUPSEARCH_H
+#define SOUPSEARCH_H
+
+#include <cstdint>
+#include <vector>
+#include "cycle.h"
+#include "grid.h"
+#include "rule.h"
+
+#define SOUP_LANES 64 // Boards stepped together, one per bit of a word
+
+// SoupConfig
+// Purpose: how the soups are made and run
+struct SoupConfig{
+    int width; // The number of columns on each board
+    int height; // The number of rows on each board
+    int soupSize; // The soup fills a square this size in the middle of the board
+    EdgeMode edgeMode; // How cells on the edge see past it
+    LifeRule rule; // The birth and survival counts
+    int maxGenerations; // Give up on a soup that has not settled after this many generations
+    int maxPeriod; // The longest oscillator period looked for
+    uint64_t key; // Picks the sequence of soups; the same key always gives the same soups
+};
+
+// SoupResult
+// Purpose: what one soup settled into
+struct SoupResult{
+    CycleKind kind; // CYCLE_NONE if it had not settled after maxGenerations
+    int period; // The period it repeats with; 0 if it had not settled
+    int generations; // The first generation of the repeating part, or maxGenerations if it had not settled
+    uint64_t population; // Living cells at that generation
+    uint64_t hash; // The same for every translation, rotation, reflection and phase of the final pattern
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// searchSoups
+// Purpose: run a range of soups to the end
+// Input:
+//      config - how the soups are made and run
+//      first - the number of the first soup
+//      count - the number of soups
+//      results - receives one result per soup, in order
+// Output:
+//      No return type. Safe to call from several threads at once.
+void searchSoups(const SoupConfig &config, uint64_t first, int count, SoupResult *results);
+
+// makeSoup
+// Purpose: build the starting board of one soup
+// Input:
+//      config - how the soups are made
+//      index - the number of the soup
+//      table - receives the board; must already be config.width x config.height
+// Output:
+//      No return type.
+void makeSoup(const SoupConfig &config, uint64_t index, TableType &table);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // SOUPSEARCH_H
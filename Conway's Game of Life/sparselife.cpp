@@ -0,0 +1,253 @@
+// Conway's Game of Life
+// sparselife.cpp
+//
+// Sparse tiled engine. See sparselife.h.
+
+#include "sparselife.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// Helpers used only by the engine itself
+
+static const SparseTile *findTile(const SparseLife &life, int32_t tileX, int32_t tileY);
+static bool facesTile(const SparseTile &tile, int dx, int dy);
+static void stepTile(SparseTile &tile, const SparseTile *neighbors[3][3], BitRowStepper step, const LifeRule &rule);
+
+//// END FUNCTION PROTOTYPES ////
+
+
+// floorDiv
+// Purpose: divide rounding towards minus infinity, so cell -1 lands in tile -1
+static int64_t floorDiv(int64_t value, int64_t divisor){
+    return (value >= 0) ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+static int32_t tileXOf(TileKey key){
+    return (int32_t)(uint32_t)(key >> 32);
+}
+
+static int32_t tileYOf(TileKey key){
+    return (int32_t)(uint32_t)key;
+}
+
+TileKey makeTileKey(int32_t tileX, int32_t tileY){
+    return ((TileKey)(uint32_t)tileX << 32) | (uint32_t)tileY;
+}
+
+void initSparseLife(SparseLife &life){
+    life.tiles.clear();
+    life.changed.clear();
+}
+
+void sparseSetCell(SparseLife &life, int64_t x, int64_t y){
+    int32_t tileX = (int32_t)floorDiv(x, TILE_SIZE);
+    int32_t tileY = (int32_t)floorDiv(y, TILE_SIZE);
+    TileKey key = makeTileKey(tileX, tileY);
+    SparseTile &tile = life.tiles[key]; // Made empty if it is not there yet
+
+    tile.cells[y - (int64_t)tileY * TILE_SIZE] |= (WordType)1 << (x - (int64_t)tileX * TILE_SIZE);
+    // Cells are usually set in runs along a row, so one entry covers a whole run in a tile;
+    // the next step sorts out any tile that is still listed twice
+    if(life.changed.empty() || life.changed.back() != key){
+        life.changed.push_back(key);
+    }
+}
+
+void sparseLoadTable(SparseLife &life, const TableType &table){
+    int x; // The column currently being looked at
+    int y; // The row currently being looked at
+
+    initSparseLife(life);
+    for(y=0; y < table.height; y++){
+        const int *row = tableRow(table, y);
+        for(x=0; x < table.width; x++){
+            if(row[x]){
+                sparseSetCell(life, x, y);
+            }
+        }
+    }
+}
+
+void sparseStoreTable(const SparseLife &life, TableType &table){
+    int y;
+
+    for(y=0; y < table.height; y++){
+        std::memset(tableRow(table, y), 0, table.width * sizeof(int));
+    }
+
+    for(auto it = life.tiles.begin(); it != life.tiles.end(); ++it){
+        int64_t left = (int64_t)tileXOf(it->first) * TILE_SIZE;
+        int64_t top = (int64_t)tileYOf(it->first) * TILE_SIZE;
+        int r, c;
+
+        if(left >= table.width || top >= table.height || left + TILE_SIZE <= 0 || top + TILE_SIZE <= 0){
+            continue;
+        }
+        for(r=0; r < TILE_SIZE; r++){
+            for(c=0; c < TILE_SIZE; c++){
+                int64_t x = left + c;
+                int64_t y = top + r;
+                if(x >= 0 && y >= 0 && x < table.width && y < table.height && ((it->second.cells[r] >> c) & 1)){
+                    tableRow(table, (int)y)[x] = 1;
+                }
+            }
+        }
+    }
+}
+
+uint64_t sparsePopulation(const SparseLife &life){
+    uint64_t population = 0;
+
+    for(auto it = life.tiles.begin(); it != life.tiles.end(); ++it){
+        for(int r=0; r < TILE_SIZE; r++){
+            population += countBits(it->second.cells[r]);
+        }
+    }
+    return population;
+}
+
+static const SparseTile *findTile(const SparseLife &life, int32_t tileX, int32_t tileY){
+    auto it = life.tiles.find(makeTileKey(tileX, tileY));
+    return (it == life.tiles.end()) ? nullptr : &it->second;
+}
+
+static bool facesTile(const SparseTile &tile, int dx, int dy){
+    // tile sits at offset (dx, dy) from an empty square; only its cells on the side
+    // touching that square can give birth to anything in it
+    WordType columns = (dx < 0) ? ((WordType)1 << 63) : (dx > 0) ? (WordType)1 : ~(WordType)0;
+    int firstRow = (dy > 0) ? 0 : TILE_SIZE - 1;
+    int lastRow = (dy < 0) ? TILE_SIZE - 1 : 0;
+    int r;
+
+    if(dy == 0){
+        firstRow = 0;
+        lastRow = TILE_SIZE - 1;
+    }
+    for(r=firstRow; r <= lastRow; r++){
+        if(tile.cells[r] & columns){
+            return true;
+        }
+    }
+    return false;
+}
+
+static void stepTile(SparseTile &tile, const SparseTile *neighbors[3][3], BitRowStepper step, const LifeRule &rule){
+    static const WordType noCells[TILE_SIZE] = { 0 };
+    WordType rows[TILE_SIZE + 2][3]; // Each row as west, centre and east words, with the rows above and below the tile
+    WordType out[3]; // The stepped row, in the centre word
+    int r;
+    int column;
+
+    for(column=0; column < 3; column++){
+        const WordType *above = neighbors[0][column] ? neighbors[0][column]->cells : noCells;
+        const WordType *middle = neighbors[1][column] ? neighbors[1][column]->cells : noCells;
+        const WordType *below = neighbors[2][column] ? neighbors[2][column]->cells : noCells;
+
+        rows[0][column] = above[TILE_SIZE - 1];
+        for(r=0; r < TILE_SIZE; r++){
+            rows[r + 1][column] = middle[r];
+        }
+        rows[TILE_SIZE + 1][column] = below[0];
+    }
+
+    for(r=0; r < TILE_SIZE; r++){
+        step(rows[r], rows[r + 1], rows[r + 2], out, 1, ~(WordType)0, rule);
+        tile.next[r] = out[1];
+    }
+}
+
+void sparseIterate(SparseLife &life, const LifeRule &rule, StepStats *stats){
+    BitRowStepper step = bitRowStepper(rule); // The row kernel for the rule
+    std::vector<TileKey> candidates; // Tiles that might change this generation
+    std::vector<std::pair<TileKey, SparseTile *> > active; // Candidates that exist or have to be made
+    size_t i;
+    int dx, dy;
+
+    // A tile can only change if it or a neighbor changed last generation
+    for(i=0; i < life.changed.size(); i++){
+        int32_t tileX = tileXOf(life.changed[i]);
+        int32_t tileY = tileYOf(life.changed[i]);
+        for(dy=-1; dy <= 1; dy++){
+            for(dx=-1; dx <= 1; dx++){
+                candidates.push_back(makeTileKey(tileX + dx, tileY + dy));
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    // Make missing tiles only where living cells on a neighbor's edge could give birth in them
+    for(i=0; i < candidates.size(); i++){
+        int32_t tileX = tileXOf(candidates[i]);
+        int32_t tileY = tileYOf(candidates[i]);
+        auto it = life.tiles.find(candidates[i]);
+        bool needed = (it != life.tiles.end());
+
+        for(dy=-1; dy <= 1 && !needed; dy++){
+            for(dx=-1; dx <= 1 && !needed; dx++){
+                const SparseTile *neighbor = findTile(life, tileX + dx, tileY + dy);
+                if((dx != 0 || dy != 0) && neighbor != nullptr && facesTile(*neighbor, dx, dy)){
+                    needed = true;
+                }
+            }
+        }
+        if(needed){
+            active.push_back(std::make_pair(candidates[i], &life.tiles[candidates[i]]));
+        }
+    }
+
+    // Step every active tile from the current generation of its neighbors
+    for(i=0; i < active.size(); i++){
+        const SparseTile *neighbors[3][3];
+        int32_t tileX = tileXOf(active[i].first);
+        int32_t tileY = tileYOf(active[i].first);
+        for(dy=-1; dy <= 1; dy++){
+            for(dx=-1; dx <= 1; dx++){
+                neighbors[dy + 1][dx + 1] = findTile(life, tileX + dx, tileY + dy);
+            }
+        }
+        stepTile(*active[i].second, neighbors, step, rule);
+    }
+
+    // Only now that every tile has been stepped can the new generation replace the old one
+    life.changed.clear();
+    for(i=0; i < active.size(); i++){
+        SparseTile &tile = *active[i].second;
+        WordType anyAlive = 0;
+        int r;
+
+        if(std::memcmp(tile.cells, tile.next, sizeof(tile.cells)) != 0){
+            if(METRICS_ENABLED && stats != nullptr){
+                // Only births and deaths here; tiles that were not stepped still hold living cells
+                StepStats changes;
+                clearStepStats(changes);
+                countWordRow(changes, tile.cells, tile.next, TILE_SIZE, 0, 0);
+                stats->births += changes.births;
+                stats->deaths += changes.deaths;
+            }
+            std::memcpy(tile.cells, tile.next, sizeof(tile.cells));
+            life.changed.push_back(active[i].first);
+        }
+        for(r=0; r < TILE_SIZE; r++){
+            anyAlive |= tile.cells[r];
+        }
+        if(anyAlive == 0){
+            life.tiles.erase(active[i].first);
+        }
+    }
+
+    // The population and bounding box take in every tile, stepped or not; a row counted
+    // against itself adds no births or deaths
+    if(METRICS_ENABLED && stats != nullptr){
+        for(auto it = life.tiles.begin(); it != life.tiles.end(); ++it){
+            int64_t left = (int64_t)tileXOf(it->first) * TILE_SIZE;
+            int64_t top = (int64_t)tileYOf(it->first) * TILE_SIZE;
+            for(int r=0; r < TILE_SIZE; r++){
+                countWordRow(*stats, &it->second.cells[r], &it->second.cells[r], 1, left, top + r);
+            }
+        }
+    }
+}
@@ -0,0 +1,108 @@
+// Conway's Game of Life
+// sparselife.h
+//
+// Sparse engine. The plane has no edge and is stored as a hash map of 64x64 tiles, each
+// a bit-packed square stepped with the same word-at-a-time logic as the bit engine.
+// Tiles are made when living cells reach them and freed once they are empty, and a
+// generation only recomputes the tiles that changed last time and the tiles around
+// them, so the cost follows how much of the pattern is active rather than its area.
+
+#ifndef SPARSELIFE_H
+#define SPARSELIFE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "grid.h"
+#include "bitlife.h"
+
+#define TILE_SIZE 64
+
+// TileKey
+// Purpose: names a tile by its tile column and row, packed into one integer
+typedef uint64_t TileKey;
+
+// SparseTile
+// Purpose: one 64x64 square of the plane. Bit n of row r is cell (n, r) of the tile.
+struct SparseTile{
+    WordType cells[TILE_SIZE]; // The current generation
+    WordType next[TILE_SIZE]; // The next generation, while a step is in progress
+};
+
+// SparseLife
+// Purpose: the tiles of the plane and the record of which ones changed
+struct SparseLife{
+    std::unordered_map<TileKey, SparseTile> tiles; // Every tile with living cells in it
+    std::vector<TileKey> changed; // Tiles that changed in the last generation, freed ones included
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// makeTileKey
+// Purpose: pack a tile position into a key
+// Input:
+//      tileX - the tile column; cell x belongs to column floor(x / TILE_SIZE)
+//      tileY - the tile row
+// Output:
+//      Returns the key.
+TileKey makeTileKey(int32_t tileX, int32_t tileY);
+
+// initSparseLife
+// Purpose: set up an empty plane
+// Input:
+//      life - the engine to set up
+// Output:
+//      No return type.
+void initSparseLife(SparseLife &life);
+
+// sparseSetCell
+// Purpose: bring a single cell to life, making its tile if needed
+// Input:
+//      life - the engine to write to
+//      x - the x position of the cell on the plane
+//      y - the y position of the cell on the plane
+// Output:
+//      No return type. The tile is marked as changed so the next step looks at it.
+void sparseSetCell(SparseLife &life, int64_t x, int64_t y);
+
+// sparseLoadTable
+// Purpose: replace the plane with the contents of a matrix, its top-left cell at (0, 0)
+// Input:
+//      life - the engine to load into
+//      table - the matrix to copy
+// Output:
+//      No return type.
+void sparseLoadTable(SparseLife &life, const TableType &table);
+
+// sparseStoreTable
+// Purpose: copy the square of the plane covered by a matrix back into it
+// Input:
+//      life - the engine to copy from
+//      table - the matrix to fill; cells (0, 0) to (width-1, height-1) of the plane are copied
+// Output:
+//      No return type.
+void sparseStoreTable(const SparseLife &life, TableType &table);
+
+// sparseIterate
+// Purpose: advance the plane by one generation
+// Input:
+//      life - the engine to advance
+//      rule - the rule to apply; it must not contain B0, which would bring every empty tile to life
+//      stats - counts of the step are added to it, with METRICS_ENABLED; nullptr to count nothing.
+//              The bounding box is in plane coordinates.
+// Output:
+//      No return type.
+void sparseIterate(SparseLife &life, const LifeRule &rule, StepStats *stats);
+
+// sparsePopulation
+// Purpose: count the living cells on the plane
+// Input:
+//      life - the engine to look at
+// Output:
+//      Returns the number of living cells.
+uint64_t sparsePopulation(const SparseLife &life);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // SPARSELIFE_H
@@ -0,0 +1,144 @@
+// Conway's Game of Life
+// threadpool.cpp
+//
+// Persistent work-stealing thread pool. See threadpool.h.
+
+#include "threadpool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int numThreads) : currentBody(nullptr), bandsLeft(0), jobNumber(0), stopping(false){
+    int i;
+
+    if(numThreads <= 0){
+        numThreads = (int)std::thread::hardware_concurrency();
+        if(numThreads < 1){
+            numThreads = 1;
+        }
+    }
+
+    for(i=0; i < numThreads; i++){
+        queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue));
+    }
+    for(i=1; i < numThreads; i++){
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> guard(jobLock);
+        stopping = true;
+    }
+    jobReady.notify_all();
+
+    for(size_t i=0; i < workers.size(); i++){
+        workers[i].join();
+    }
+}
+
+int ThreadPool::threadCount() const{
+    return (int)queues.size();
+}
+
+void ThreadPool::parallelFor(int begin, int end, int grain, const RangeBody &body){
+    int numThreads = (int)queues.size();
+    int numBands; // The number of bands the range is split into
+    int band; // The band currently being handed out
+    int t; // The thread currently being handed bands
+
+    if(end <= begin){
+        return;
+    }
+    if(grain < 1){
+        grain = 1;
+    }
+    numBands = (end - begin + grain - 1) / grain;
+
+    // Nothing to share, so skip waking the workers
+    if(numThreads == 1 || numBands == 1){
+        for(band=0; band < numBands; band++){
+            body(begin + band * grain, std::min(end, begin + (band + 1) * grain));
+        }
+        return;
+    }
+
+    currentBody = &body;
+    bandsLeft.store(numBands);
+
+    // Give each thread a run of neighboring bands, so it walks memory in order until it has to steal
+    for(t=0; t < numThreads; t++){
+        std::lock_guard<std::mutex> guard(queues[t]->lock);
+        for(band = numBands * t / numThreads; band < numBands * (t + 1) / numThreads; band++){
+            queues[t]->bands.push_back(std::make_pair(begin + band * grain, std::min(end, begin + (band + 1) * grain)));
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(jobLock);
+        jobNumber++;
+    }
+    jobReady.notify_all();
+
+    // The calling thread works too, then waits for any bands still running elsewhere
+    runBands(0);
+    {
+        std::unique_lock<std::mutex> guard(jobLock);
+        jobDone.wait(guard, [this]{ return bandsLeft.load() == 0; });
+    }
+    currentBody = nullptr;
+}
+
+void ThreadPool::workerLoop(int index){
+    unsigned long lastJob = 0; // The last job this thread worked on
+
+    for(;;){
+        {
+            std::unique_lock<std::mutex> guard(jobLock);
+            jobReady.wait(guard, [&]{ return stopping || jobNumber != lastJob; });
+            if(stopping){
+                return;
+            }
+            lastJob = jobNumber;
+        }
+        runBands(index);
+    }
+}
+
+void ThreadPool::runBands(int index){
+    std::pair<int, int> band;
+
+    while(takeBand(index, band)){
+        (*currentBody)(band.first, band.second);
+        if(bandsLeft.fetch_sub(1) == 1){
+            std::lock_guard<std::mutex> guard(jobLock);
+            jobDone.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::takeBand(int index, std::pair<int, int> &band){
+    int numThreads = (int)queues.size();
+    int k;
+
+    // Own bands come off the front, in memory order
+    {
+        std::lock_guard<std::mutex> guard(queues[index]->lock);
+        if(!queues[index]->bands.empty()){
+            band = queues[index]->bands.front();
+            queues[index]->bands.pop_front();
+            return true;
+        }
+    }
+
+    // Stolen bands come off the back, furthest from where the owner is working
+    for(k=1; k < numThreads; k++){
+        WorkQueue &victim = *queues[(index + k) % numThreads];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if(!victim.bands.empty()){
+            band = victim.bands.back();
+            victim.bands.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
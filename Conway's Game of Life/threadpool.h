@@ -0,0 +1,80 @@
+// Conway's Game of Life
+// threadpool.h
+//
+// Persistent pool of worker threads for stepping a generation in parallel. The threads
+// are started once and sleep between generations. Each job is split into row bands,
+// and every thread (the caller included) starts on its own run of bands; a thread
+// that runs out of work steals bands from the far end of another thread's queue, so
+// bands that take longer than the rest get spread back out.
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// RangeBody
+// Purpose: the work done on one band, given as [begin, end)
+typedef std::function<void(int begin, int end)> RangeBody;
+
+class ThreadPool{
+public:
+    // ThreadPool
+    // Purpose: start the worker threads
+    // Input:
+    //      numThreads - the number of threads that share a job, the calling thread included;
+    //                   0 means one per hardware thread
+    explicit ThreadPool(int numThreads);
+
+    // ~ThreadPool
+    // Purpose: wake and join every worker thread
+    ~ThreadPool();
+
+    // threadCount
+    // Purpose: get the number of threads that share a job, the calling thread included
+    int threadCount() const;
+
+    // parallelFor
+    // Purpose: run body over [begin, end) split into bands of at most grain, and wait for it to finish
+    // Input:
+    //      begin - the first index
+    //      end - one past the last index
+    //      grain - the largest band handed to body at once
+    //      body - the work to do on each band; called from several threads at the same time
+    // Output:
+    //      No return type. Every index has been handed to body exactly once when the function returns.
+    void parallelFor(int begin, int end, int grain, const RangeBody &body);
+
+private:
+    // WorkQueue
+    // Purpose: the bands waiting to be run by one thread
+    struct WorkQueue{
+        std::mutex lock;
+        std::deque<std::pair<int, int> > bands;
+    };
+
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+    void workerLoop(int index);
+    void runBands(int index);
+    bool takeBand(int index, std::pair<int, int> &band);
+
+    std::vector<std::unique_ptr<WorkQueue> > queues; // One queue per thread; queue 0 belongs to the caller
+    std::vector<std::thread> workers; // Threads 1 and up
+    const RangeBody *currentBody; // The body of the job being run
+    std::atomic<int> bandsLeft; // Bands of the current job that have not finished
+    std::mutex jobLock; // Guards jobNumber and stopping
+    std::condition_variable jobReady; // Signalled when a job is posted or the pool shuts down
+    std::condition_variable jobDone; // Signalled when the last band of a job finishes
+    unsigned long jobNumber; // Counts the jobs posted so far
+    bool stopping; // Set when the pool is shutting down
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,386 @@
+// Conway's Game of Life
+// transport.cpp
+//
+// Shared memory and socket transports between worker processes. See transport.h.
+
+#include "transport.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// SharedRing
+// Purpose: the control words of one ring buffer in shared memory; the TRANSPORT_RING_BYTES of
+//          data follow it. Each count only ever grows and has one writer, so no locks are needed.
+struct SharedRing{
+    std::atomic<uint64_t> written; // Bytes the sender has put in the ring so far
+    char writtenPadding[56]; // Keeps the two counts on separate cache lines
+    std::atomic<uint64_t> read; // Bytes the receiver has taken out so far
+    char readPadding[56];
+};
+
+// SharedTransport
+// Purpose: a ring buffer in one shared mapping for each ordered pair of ranks
+class SharedTransport : public HaloTransport{
+public:
+    explicit SharedTransport(int ranks);
+    ~SharedTransport();
+    bool create(std::string &error);
+    void attach(int rank);
+
+protected:
+    long writeSome(int peer, const char *data, size_t bytes);
+    long readSome(int peer, char *data, size_t bytes);
+    void waitForData(int peer);
+
+private:
+    SharedRing *ring(int from, int to) const;
+
+    char *mapping; // Every ring, from rank major, to rank minor
+    size_t mappingBytes; // The size of the mapping
+};
+
+// SocketTransport
+// Purpose: a connected pair of Unix domain stream sockets for each pair of ranks
+class SocketTransport : public HaloTransport{
+public:
+    explicit SocketTransport(int ranks);
+    ~SocketTransport();
+    bool create(std::string &error);
+    void attach(int rank);
+
+protected:
+    long writeSome(int peer, const char *data, size_t bytes);
+    long readSome(int peer, char *data, size_t bytes);
+    void waitForData(int peer);
+
+private:
+    std::vector<int> sockets; // ranks x ranks: the socket rank i talks to rank j through, or -1
+    std::vector<pollfd> waits; // Scratch for waitForData
+};
+
+
+HaloTransport::HaloTransport(int ranks) : ownRank(-1), ranks(ranks), pending(ranks), pendingSent(ranks, 0), anyPending(false){
+}
+
+HaloTransport::~HaloTransport(){
+}
+
+int HaloTransport::rank() const{
+    return ownRank;
+}
+
+int HaloTransport::size() const{
+    return ranks;
+}
+
+bool HaloTransport::hasPending(int peer) const{
+    return !pending[peer].empty();
+}
+
+bool HaloTransport::send(int peer, int tag, const void *data, size_t bytes){
+    MessageHeader header; // Goes in front of the message
+
+    header.tag = (uint32_t)tag;
+    header.reserved = 0;
+    header.bytes = bytes;
+    return queueBytes(peer, (const char *)&header, sizeof(header)) && queueBytes(peer, (const char *)data, bytes);
+}
+
+bool HaloTransport::receive(int peer, int tag, void *data, size_t bytes){
+    MessageHeader header; // What the sender put in front of the message
+
+    if(!readBytes(peer, (char *)&header, sizeof(header))){
+        return false;
+    }
+    if(header.tag != (uint32_t)tag || header.bytes != bytes){
+        return false;
+    }
+    return readBytes(peer, (char *)data, bytes);
+}
+
+bool HaloTransport::flush(int peer){
+    while(!pending[peer].empty()){
+        if(!progress()){
+            return false;
+        }
+        if(!pending[peer].empty()){
+            waitForData(-1);
+        }
+    }
+    return true;
+}
+
+// queueBytes
+// Purpose: send bytes straight away if nothing is queued ahead of them, and queue what does not fit
+bool HaloTransport::queueBytes(int peer, const char *data, size_t bytes){
+    long sent = 0; // Bytes that went straight away
+
+    if(pending[peer].empty()){
+        sent = writeSome(peer, data, bytes);
+        if(sent < 0){
+            return false;
+        }
+    }
+    if((size_t)sent < bytes){
+        pending[peer].insert(pending[peer].end(), data + sent, data + bytes);
+        anyPending = true;
+    }
+    return true;
+}
+
+// pushPending
+// Purpose: send as much of what is queued for one peer as fits
+bool HaloTransport::pushPending(int peer){
+    std::vector<char> &queue = pending[peer];
+
+    while(pendingSent[peer] < queue.size()){
+        long sent = writeSome(peer, queue.data() + pendingSent[peer], queue.size() - pendingSent[peer]);
+        if(sent < 0){
+            return false;
+        }
+        if(sent == 0){
+            return true;
+        }
+        pendingSent[peer] += sent;
+    }
+    queue.clear();
+    pendingSent[peer] = 0;
+    return true;
+}
+
+// progress
+// Purpose: push along what is queued for every peer
+bool HaloTransport::progress(){
+    bool left = false; // Whether anything is still queued
+
+    if(!anyPending){
+        return true;
+    }
+    for(int peer=0; peer < ranks; peer++){
+        if(!pending[peer].empty()){
+            if(!pushPending(peer)){
+                return false;
+            }
+            left = left || !pending[peer].empty();
+        }
+    }
+    anyPending = left;
+    return true;
+}
+
+// readBytes
+// Purpose: wait for an exact number of bytes from one peer, keeping queued sends moving meanwhile
+bool HaloTransport::readBytes(int peer, char *data, size_t bytes){
+    size_t got = 0; // Bytes read so far
+
+    while(got < bytes){
+        long read = readSome(peer, data + got, bytes - got);
+        if(read < 0){
+            return false;
+        }
+        if(read == 0){
+            if(!progress()){
+                return false;
+            }
+            waitForData(peer);
+        }
+        got += read;
+    }
+    return true;
+}
+
+
+SharedTransport::SharedTransport(int ranks) : HaloTransport(ranks), mapping(nullptr), mappingBytes(0){
+}
+
+SharedTransport::~SharedTransport(){
+    if(mapping != nullptr){
+        munmap(mapping, mappingBytes);
+    }
+}
+
+bool SharedTransport::create(std::string &error){
+    void *view; // The shared mapping
+
+    // Pages are only backed once a ring is used, so the rings of ranks that never talk cost nothing
+    mappingBytes = (size_t)ranks * ranks * (sizeof(SharedRing) + TRANSPORT_RING_BYTES);
+    view = mmap(nullptr, mappingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(view == MAP_FAILED){
+        error = std::string("could not map shared memory: ") + std::strerror(errno);
+        return false;
+    }
+    mapping = (char *)view;
+    for(int from=0; from < ranks; from++){
+        for(int to=0; to < ranks; to++){
+            if(from != to){
+                SharedRing *control = new (ring(from, to)) SharedRing;
+                control->written.store(0);
+                control->read.store(0);
+            }
+        }
+    }
+    return true;
+}
+
+void SharedTransport::attach(int rank){
+    ownRank = rank;
+}
+
+SharedRing *SharedTransport::ring(int from, int to) const{
+    return (SharedRing *)(mapping + ((size_t)from * ranks + to) * (sizeof(SharedRing) + TRANSPORT_RING_BYTES));
+}
+
+long SharedTransport::writeSome(int peer, const char *data, size_t bytes){
+    SharedRing *control = ring(ownRank, peer);
+    char *buffer = (char *)(control + 1);
+    uint64_t written = control->written.load(std::memory_order_relaxed);
+    uint64_t room = TRANSPORT_RING_BYTES - (written - control->read.load(std::memory_order_acquire));
+    size_t count = (size_t)std::min<uint64_t>(room, bytes); // Bytes that fit
+    size_t start = (size_t)(written % TRANSPORT_RING_BYTES);
+    size_t first = std::min(count, (size_t)TRANSPORT_RING_BYTES - start); // Bytes before the ring wraps
+
+    std::memcpy(buffer + start, data, first);
+    std::memcpy(buffer, data + first, count - first);
+    control->written.store(written + count, std::memory_order_release);
+    return (long)count;
+}
+
+long SharedTransport::readSome(int peer, char *data, size_t bytes){
+    SharedRing *control = ring(peer, ownRank);
+    const char *buffer = (const char *)(control + 1);
+    uint64_t read = control->read.load(std::memory_order_relaxed);
+    uint64_t waiting = control->written.load(std::memory_order_acquire) - read;
+    size_t count = (size_t)std::min<uint64_t>(waiting, bytes); // Bytes that have arrived
+    size_t start = (size_t)(read % TRANSPORT_RING_BYTES);
+    size_t first = std::min(count, (size_t)TRANSPORT_RING_BYTES - start); // Bytes before the ring wraps
+
+    std::memcpy(data, buffer + start, first);
+    std::memcpy(data + first, buffer, count - first);
+    control->read.store(read + count, std::memory_order_release);
+    return (long)count;
+}
+
+void SharedTransport::waitForData(int){
+    // Nothing to sleep on in shared memory; give the CPU to the worker being waited for
+    sched_yield();
+}
+
+
+SocketTransport::SocketTransport(int ranks) : HaloTransport(ranks), sockets((size_t)ranks * ranks, -1){
+}
+
+SocketTransport::~SocketTransport(){
+    for(size_t i=0; i < sockets.size(); i++){
+        if(sockets[i] >= 0){
+            close(sockets[i]);
+        }
+    }
+}
+
+bool SocketTransport::create(std::string &error){
+    int pair[2]; // The two ends of one connection
+
+    for(int i=0; i < ranks; i++){
+        for(int j=i+1; j < ranks; j++){
+            if(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0){
+                error = std::string("could not create sockets: ") + std::strerror(errno);
+                return false;
+            }
+            sockets[(size_t)i * ranks + j] = pair[0];
+            sockets[(size_t)j * ranks + i] = pair[1];
+        }
+    }
+    return true;
+}
+
+void SocketTransport::attach(int rank){
+    ownRank = rank;
+    // Close the ends that belong to other ranks, so a worker that exits is seen as the end of its stream
+    for(int i=0; i < ranks; i++){
+        for(int j=0; j < ranks; j++){
+            int &end = sockets[(size_t)i * ranks + j];
+            if(end >= 0 && i != rank){
+                close(end);
+                end = -1;
+            }
+            else if(end >= 0){
+                fcntl(end, F_SETFL, fcntl(end, F_GETFL) | O_NONBLOCK);
+            }
+        }
+    }
+}
+
+long SocketTransport::writeSome(int peer, const char *data, size_t bytes){
+    ssize_t sent = ::send(sockets[(size_t)ownRank * ranks + peer], data, bytes, MSG_NOSIGNAL);
+
+    if(sent < 0){
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    }
+    return (long)sent;
+}
+
+long SocketTransport::readSome(int peer, char *data, size_t bytes){
+    ssize_t got = recv(sockets[(size_t)ownRank * ranks + peer], data, bytes, 0);
+
+    if(got < 0){
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    }
+    if(got == 0 && bytes > 0){
+        return -1; // The peer has gone
+    }
+    return (long)got;
+}
+
+void SocketTransport::waitForData(int peer){
+    waits.clear();
+    if(peer >= 0){
+        pollfd wait = { sockets[(size_t)ownRank * ranks + peer], POLLIN, 0 };
+        waits.push_back(wait);
+    }
+    for(int other=0; other < ranks; other++){
+        if(other != ownRank && hasPending(other)){
+            pollfd wait = { sockets[(size_t)ownRank * ranks + other], POLLOUT, 0 };
+            waits.push_back(wait);
+        }
+    }
+    if(!waits.empty()){
+        poll(waits.data(), waits.size(), -1);
+    }
+}
+
+
+bool parseTransportKind(const char *name, TransportKind &kind){
+    if(std::strcmp(name, "shm") == 0){
+        kind = TRANSPORT_SHARED;
+    }
+    else if(std::strcmp(name, "socket") == 0){
+        kind = TRANSPORT_SOCKET;
+    }
+    else{
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<HaloTransport> createTransport(TransportKind kind, int ranks, std::string &error){
+    if(kind == TRANSPORT_SHARED){
+        std::unique_ptr<SharedTransport> transport(new SharedTransport(ranks));
+        if(!transport->create(error)){
+            return std::unique_ptr<HaloTransport>();
+        }
+        return std::unique_ptr<HaloTransport>(transport.release());
+    }
+    std::unique_ptr<SocketTransport> transport(new SocketTransport(ranks));
+    if(!transport->create(error)){
+        return std::unique_ptr<HaloTransport>();
+    }
+    return std::unique_ptr<HaloTransport>(transport.release());
+}
@@ -0,0 +1,170 @@
+// Conway's Game of Life
+// transport.h
+//
+// Message passing between the worker processes of a distributed run (see distributed.h).
+// The interface follows the point-to-point part of MPI: each process has a rank from 0 to
+// size-1, and a message sent to a rank with a tag is taken there by a receive from the
+// sender with the same tag. Messages between two ranks arrive in the order they were sent.
+//
+// A transport is created before the workers are forked, so every worker inherits it, and
+// each worker then attaches to it with its own rank. Sends never wait for the receiver:
+// whatever does not fit on the way is queued and pushed along while the sender waits in a
+// receive, so two ranks can always send to each other before either receives.
+//
+//      TRANSPORT_SHARED - a ring buffer in shared memory for each ordered pair of ranks
+//      TRANSPORT_SOCKET - a Unix domain stream socket for each pair of ranks, the same byte
+//                         stream a TCP connection between hosts would carry
+//
+// POSIX only.
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define TRANSPORT_RING_BYTES (256 * 1024) // Shared memory transport: bytes in each ring buffer
+
+// TransportKind
+// Purpose: the way messages travel between workers
+enum TransportKind{
+    TRANSPORT_SHARED,
+    TRANSPORT_SOCKET
+};
+
+const char *const TRANSPORT_NAMES[] = { "shm", "socket" }; // By TransportKind
+
+class HaloTransport{
+public:
+    virtual ~HaloTransport();
+
+    // attach
+    // Purpose: take up a rank, in the worker process that is to use it, after the fork
+    // Input:
+    //      rank - the rank of this process
+    // Output:
+    //      No return type. Parts of the transport that only other ranks use are released.
+    virtual void attach(int rank) = 0;
+
+    // send
+    // Purpose: send a message to another rank
+    // Input:
+    //      peer - the rank to send to
+    //      tag - the tag the receive has to ask for
+    //      data - the message
+    //      bytes - its length
+    // Output:
+    //      Returns false if the connection to peer has failed. The message has been copied
+    //      when the function returns, but may not have left yet.
+    bool send(int peer, int tag, const void *data, size_t bytes);
+
+    // receive
+    // Purpose: wait for the next message from another rank
+    // Input:
+    //      peer - the rank to receive from
+    //      tag - the tag the message must have
+    //      data - receives the message
+    //      bytes - its length, which must match what was sent
+    // Output:
+    //      Returns false if the connection to peer failed or the message was not the one asked for.
+    //      Queued sends to any rank are pushed along while waiting.
+    bool receive(int peer, int tag, void *data, size_t bytes);
+
+    // flush
+    // Purpose: wait until every queued send to one rank has left
+    // Input:
+    //      peer - the rank
+    // Output:
+    //      Returns false if the connection to peer failed.
+    bool flush(int peer);
+
+    // rank
+    // Purpose: get the rank this process attached with
+    int rank() const;
+
+    // size
+    // Purpose: get the number of ranks
+    int size() const;
+
+protected:
+    // HaloTransport
+    // Purpose: set up the parts every transport shares
+    // Input:
+    //      ranks - the number of ranks
+    explicit HaloTransport(int ranks);
+
+    // writeSome
+    // Purpose: put as much of a run of bytes on the way to peer as fits without waiting
+    // Output:
+    //      Returns the number of bytes taken, or -1 if the connection has failed.
+    virtual long writeSome(int peer, const char *data, size_t bytes) = 0;
+
+    // readSome
+    // Purpose: take as much of what peer has sent as has arrived, up to bytes, without waiting
+    // Output:
+    //      Returns the number of bytes read, or -1 if the connection has failed or closed.
+    virtual long readSome(int peer, char *data, size_t bytes) = 0;
+
+    // waitForData
+    // Purpose: sleep until there may be something to read from peer, or room to send queued bytes
+    // Input:
+    //      peer - the rank being received from, or -1 when only waiting to send
+    virtual void waitForData(int peer) = 0;
+
+    // hasPending
+    // Purpose: check whether bytes for peer are queued, waiting for room on the way
+    bool hasPending(int peer) const;
+
+    int ownRank; // The rank of this process, or -1 before attach
+    int ranks; // The number of ranks
+
+private:
+    // MessageHeader
+    // Purpose: what goes in front of every message on the way
+    struct MessageHeader{
+        uint32_t tag; // The tag it was sent with
+        uint32_t reserved; // Zero
+        uint64_t bytes; // Its length
+    };
+
+    HaloTransport(const HaloTransport &);
+    HaloTransport &operator=(const HaloTransport &);
+
+    bool queueBytes(int peer, const char *data, size_t bytes);
+    bool pushPending(int peer);
+    bool progress();
+    bool readBytes(int peer, char *data, size_t bytes);
+
+    std::vector<std::vector<char> > pending; // Per peer: bytes sent but not on their way yet
+    std::vector<size_t> pendingSent; // Per peer: how much of pending has gone
+    bool anyPending; // Whether any peer has bytes in pending
+};
+
+
+//// BEGIN FUNCTION PROTOTYPES ////
+
+// parseTransportKind
+// Purpose: turn a transport name from the command line into a TransportKind
+// Input:
+//      name - "shm" or "socket"
+//      kind - receives the transport
+// Output:
+//      Returns false if the name is not recognised.
+bool parseTransportKind(const char *name, TransportKind &kind);
+
+// createTransport
+// Purpose: set up a transport between a number of ranks, before the workers are forked
+// Input:
+//      kind - the way messages travel
+//      ranks - the number of ranks
+//      error - receives why the transport could not be set up
+// Output:
+//      Returns the transport, or an empty pointer on failure.
+std::unique_ptr<HaloTransport> createTransport(TransportKind kind, int ranks, std::string &error);
+
+//// END FUNCTION PROTOTYPES ////
+
+#endif // TRANSPORT_H
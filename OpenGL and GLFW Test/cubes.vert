@@ -0,0 +1,36 @@
+#version 330
+
+in vec3 position;
+in vec3 color;
+in vec2 texcoord;
+
+// One per cube, from CubeInstance
+in vec4 placement; // Centre, then edge length
+in vec2 spin; // Angle at time 0, then radians a second
+in vec4 tint;
+
+out vec3 Color;
+out vec2 Texcoord;
+
+uniform mat4 view;
+uniform mat4 proj;
+uniform float time;
+uniform float mirror; // 1 for the cubes, -1 for their reflection
+uniform vec3 overrideColor;
+uniform float positionScale; // Packed positions are fractions of it
+
+void main()
+{
+    float angle = spin.x + spin.y * time;
+    vec3 local = positionScale * position;
+    vec2 turned = mat2(cos(angle), sin(angle), -sin(angle), cos(angle)) * local.xy;
+    vec3 world = placement.xyz + placement.w * vec3(turned, local.z);
+
+    // The reflection is the cube mirrored in the floor, at z = -0.5
+    if(mirror < 0.0)
+        world.z = -1.0 - world.z;
+
+    Color = overrideColor * color * tint.rgb;
+    Texcoord = texcoord;
+    gl_Position = proj * view * vec4(world, 1.0);
+}
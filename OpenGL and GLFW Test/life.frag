@@ -0,0 +1,17 @@
+#version 330
+
+in vec2 Texcoord;
+
+out vec4 outColor;
+
+// Eight cells to a texel, bit n of texel x holding cell 8x + n
+uniform usampler2D board;
+uniform ivec2 boardSize;
+
+void main()
+{
+    ivec2 cell = min(ivec2(Texcoord * vec2(boardSize)), boardSize - 1);
+    uint cells = texelFetch(board, ivec2(cell.x >> 3, cell.y), 0).r;
+    float alive = float((cells >> uint(cell.x & 7)) & 1u);
+    outColor = vec4(mix(vec3(0.1, 0.1, 0.12), vec3(0.95, 0.95, 0.9), alive), 1.0);
+}
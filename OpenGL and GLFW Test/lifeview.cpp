@@ -0,0 +1,171 @@
+#include "lifeview.h"
+#include <algorithm>
+#include <cstring>
+
+// The quad covers clip space; life.vert scales it down to the board's shape
+static const float quadVertices[] =
+{
+//  X      Y      U     V
+    -1.0f, -1.0f, 0.0f, 1.0f,
+     1.0f, -1.0f, 1.0f, 1.0f,
+     1.0f,  1.0f, 1.0f, 0.0f,
+    -1.0f, -1.0f, 0.0f, 1.0f,
+     1.0f,  1.0f, 1.0f, 0.0f,
+    -1.0f,  1.0f, 0.0f, 0.0f
+};
+
+bool initLifeView(LifeView &view, int width, int height, GLuint program)
+{
+    view.width = width;
+    view.height = height;
+    view.rowBytes = (width + 7) / 8;
+    view.current = 1;
+    view.program = program;
+    view.uploadedRows = 0;
+    view.uploadCalls = 0;
+
+    glGenTextures(2, view.textures);
+    glGenBuffers(2, view.pbos);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Rows are packed tight, whatever their length
+    for(int i = 0; i < 2; i++)
+    {
+        // The textures start out dead, the same as shown
+        view.shown[i].assign((size_t)view.rowBytes * height, 0);
+        glBindTexture(GL_TEXTURE_2D, view.textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, view.rowBytes, height, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE,
+                     view.shown[i].data());
+        // Integer textures cannot be filtered
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Each buffer can hold the whole board, for generations where everything changes
+    for(int i = 0; i < 2; i++)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, view.pbos[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, view.shown[i].size(), nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    glGenVertexArrays(1, &view.vao);
+    glBindVertexArray(view.vao);
+    glGenBuffers(1, &view.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, view.vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+
+    GLint posAttrib = glGetAttribLocation(program, "position");
+    glEnableVertexAttribArray(posAttrib);
+    glVertexAttribPointer(posAttrib, 2, GL_FLOAT, GL_FALSE, 4*sizeof(float), 0);
+    GLint texAttrib = glGetAttribLocation(program, "texcoord");
+    glEnableVertexAttribArray(texAttrib);
+    glVertexAttribPointer(texAttrib, 2, GL_FLOAT, GL_FALSE, 4*sizeof(float), (void*)(2*sizeof(float)));
+    glBindVertexArray(0);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+void uploadLifeView(LifeView &view, const BitTable &board)
+{
+    int target = view.current ^ 1; // The texture not drawn last
+    std::vector<unsigned char> &shown = view.shown[target];
+    size_t rowBytes = view.rowBytes;
+    // The ghost cell right of the board can share the last byte, and must not count as a change
+    unsigned char lastMask = (view.width % 8 != 0) ? (unsigned char)((1 << (view.width % 8)) - 1) : 0xFF;
+    std::vector<int> ranges; // First row and row count of each range to send
+    int dirtyRows = 0; // Rows in those ranges
+    int y;
+
+    // Find the rows that changed since this texture was filled, which is two frames' worth
+    // of generations, and keep them in shown
+    for(y = 0; y < view.height; y++)
+    {
+        const unsigned char *row = (const unsigned char *)&board.words[(size_t)(y + 1) * board.wordsPerRow + 1];
+        unsigned char *seen = &shown[y * rowBytes];
+        unsigned char last = row[rowBytes - 1] & lastMask;
+
+        if(std::memcmp(row, seen, rowBytes - 1) == 0 && last == seen[rowBytes - 1])
+            continue;
+        std::memcpy(seen, row, rowBytes - 1);
+        seen[rowBytes - 1] = last;
+
+        if(!ranges.empty() && y - (ranges[ranges.size() - 2] + ranges.back()) <= LIFE_VIEW_MERGE_ROWS)
+        {
+            int grown = y + 1 - ranges[ranges.size() - 2];
+            dirtyRows += grown - ranges.back();
+            ranges.back() = grown;
+        }
+        else
+        {
+            ranges.push_back(y);
+            ranges.push_back(1);
+            dirtyRows++;
+        }
+    }
+    view.uploadedRows = dirtyRows;
+    view.uploadCalls = (int)ranges.size() / 2;
+    view.current = target;
+    if(ranges.empty())
+        return;
+
+    // Invalidating the buffer lets the driver hand back fresh memory instead of waiting
+    // for the copy out of it from two uploads ago
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, view.pbos[target]);
+    unsigned char *mapped = (unsigned char *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (size_t)dirtyRows * rowBytes,
+                                                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if(mapped == nullptr)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return;
+    }
+    size_t offset = 0;
+    for(size_t r = 0; r < ranges.size(); r += 2)
+    {
+        size_t bytes = (size_t)ranges[r + 1] * rowBytes;
+        std::memcpy(mapped + offset, &shown[ranges[r] * rowBytes], bytes);
+        offset += bytes;
+    }
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // The copies into the texture read from the buffer, so they return straight away
+    glBindTexture(GL_TEXTURE_2D, view.textures[target]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    offset = 0;
+    for(size_t r = 0; r < ranges.size(); r += 2)
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, ranges[r], view.rowBytes, ranges[r + 1],
+                        GL_RED_INTEGER, GL_UNSIGNED_BYTE, (void*)offset);
+        offset += (size_t)ranges[r + 1] * rowBytes;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void drawLifeView(const LifeView &view, int viewportWidth, int viewportHeight)
+{
+    // Letterbox the board so its cells stay square
+    float boardAspect = (float)view.width / view.height;
+    float viewAspect = (float)viewportWidth / viewportHeight;
+    float scaleX = (boardAspect > viewAspect) ? 1.0f : boardAspect / viewAspect;
+    float scaleY = (boardAspect > viewAspect) ? viewAspect / boardAspect : 1.0f;
+
+    glUseProgram(view.program);
+    glUniform2f(glGetUniformLocation(view.program, "scale"), scaleX, scaleY);
+    glUniform2i(glGetUniformLocation(view.program, "boardSize"), view.width, view.height);
+    glUniform1i(glGetUniformLocation(view.program, "board"), 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, view.textures[view.current]);
+    glBindVertexArray(view.vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+}
+
+void destroyLifeView(LifeView &view)
+{
+    glDeleteVertexArrays(1, &view.vao);
+    glDeleteBuffers(1, &view.vbo);
+    glDeleteBuffers(2, view.pbos);
+    glDeleteTextures(2, view.textures);
+}
@@ -0,0 +1,48 @@
+// Life board viewer
+//
+// Shows a board of Conway's Game of Life as one texture, drawn on a single quad.
+// Cells are uploaded bit-packed, eight to a byte, exactly as the bit engine of
+// "../Conway's Game of Life" stores them, into an integer (R8UI) texture that
+// life.frag unpacks. There are two textures, each with its own pixel buffer object,
+// used in turn: a frame fills the pair the previous frame is not drawing from, so
+// the copy never has to wait for that draw to finish. Each upload only sends the
+// row ranges that changed since its texture was last filled. Only OpenGL 3.3 core
+// is used, so it runs on Mesa's llvmpipe as well.
+
+#ifndef LIFEVIEW_H
+#define LIFEVIEW_H
+
+#include <vector>
+#include "GL/glew.h"
+#include "bitlife.h"
+
+#define LIFE_VIEW_MERGE_ROWS 8 // Unchanged rows between two changed ranges that are sent anyway, to save a call
+
+struct LifeView
+{
+    int width; // Cells across the board
+    int height; // Cells down the board
+    int rowBytes; // Bytes of packed cells in one row, and the width of the textures in texels
+    GLuint textures[2]; // The board, one bit per cell, filled in turn
+    GLuint pbos[2]; // The buffer each texture is filled from
+    std::vector<unsigned char> shown[2]; // Every row as each texture last received it
+    int current; // The texture filled last, which is the one drawn
+    GLuint vao; // The quad the board is drawn on
+    GLuint vbo;
+    GLuint program; // life.vert and life.frag
+    int uploadedRows; // Rows sent by the last upload
+    int uploadCalls; // glTexSubImage2D calls made by the last upload
+};
+
+// Create the textures, buffers and quad for a board, and clear the textures to dead cells
+bool initLifeView(LifeView &view, int width, int height, GLuint program);
+
+// Send the rows of the board that differ from the texture not drawn last, and draw that one from now on
+void uploadLifeView(LifeView &view, const BitTable &board);
+
+// Draw the board, as large as it fits in the viewport without stretching
+void drawLifeView(const LifeView &view, int viewportWidth, int viewportHeight);
+
+void destroyLifeView(LifeView &view);
+
+#endif // LIFEVIEW_H
@@ -3,28 +3,68 @@
 // Left off at: open.gl/framebuffers
 
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <algorithm>
+#include <thread>
 #include "GL/glew.h"
 #include "GLFW/glfw3.h"
-#include "GLM/glm.hpp"
-#include "GLM/gtc/matrix_transform.hpp"
-#include "GLM/gtc/type_ptr.hpp"
-#include "SOIL/SOIL.h"
+#include "bitlife.h"
+#include "lifeview.h"
+#include "patternio.h"
+#include "rule.h"
+#include "scene.h"
+#include "shadercache.h"
+#include "texloader.h"
+#include "updater.h"
 
-GLuint LoadShader(const char *vertexPath, const char *fragmentPath);
-std::string readFile(const char *filePath);
+int runLife(GLFWwindow *window, int argc, char **argv);
 
 int main(int argc, char** argv)
 {
     // Record the start time of the program
     auto t_start = std::chrono::high_resolution_clock::now();
+    bool lifeMode = argc > 1 && std::string(argv[1]) == "-life";
+    bool watchShaders = false;
+    bool reportTiming = false; // "-timing": print frame times and update steps once a second
+    int cubeCount = 0; // "-cubes [N]": a field of N cubes, drawn instanced, in place of the one cube
+    const char *meshPath = nullptr; // "-mesh FILE": a mesh baked by MeshBake, drawn in place of the cube and floor
+    for(int i = 1; i < argc && !lifeMode; i++)
+    {
+        if(std::string(argv[i]) == "-watch")
+            watchShaders = true;
+        else if(std::string(argv[i]) == "-timing")
+            reportTiming = true;
+        else if(std::string(argv[i]) == "-cubes")
+        {
+            cubeCount = CUBE_FIELD_DEFAULT;
+            if(i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+                cubeCount = std::atoi(argv[++i]);
+        }
+        else if(std::string(argv[i]) == "-mesh" && i + 1 < argc)
+            meshPath = argv[++i];
+    }
+
+    // Start decoding the textures now, so they load while the window and shaders are set up
+    TextureLoader textureLoader;
+    startTextureLoader(textureLoader, "cache", std::max(1, (int)std::thread::hardware_concurrency()));
+    if(!lifeMode)
+    {
+        requestTexture(textureLoader, "img/archery.jpg");
+        requestTexture(textureLoader, "img/moose.jpg");
+    }
 
     // Initialise GLFW
     if( !glfwInit() )
     {
         fprintf( stderr, "Failed to initialize GLFW\n" );
+        stopTextureLoader(textureLoader);
         return -1;
     }
 
@@ -43,6 +83,7 @@ int main(int argc, char** argv)
     if (window == nullptr)
     {
         std::cout << "Failed to create GLFW window" << std::endl;
+        stopTextureLoader(textureLoader);
         glfwTerminate();
         return -1;
     }
@@ -55,6 +96,7 @@ int main(int argc, char** argv)
     if (glewInit() != GLEW_OK)
     {
         std::cout << "Failed to initialize GLEW" << std::endl;
+        stopTextureLoader(textureLoader);
         return -1;
     }
 
@@ -62,328 +104,291 @@ int main(int argc, char** argv)
     glfwGetFramebufferSize(window, &width, &height);
     glViewport(0, 0, width, height);
 
-    // Enable depth testing
-    glEnable(GL_DEPTH_TEST);
-
-    // Variables
-    float vertices[] =
-    {
-    //  X       Y      Z     R     G     B     U     V
-        -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
-     0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
-     0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-     0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-    -0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
-    -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
-
-    -0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
-     0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
-     0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-     0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-    -0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
-    -0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
-
-    -0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
-    -0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-    -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
-    -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
-    -0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
-    -0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
-
-     0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
-     0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-     0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
-     0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
-     0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
-     0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
-
-    -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
-     0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-     0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
-     0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
-    -0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
-    -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
-
-    -0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
-     0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-     0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
-     0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
-    -0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
-    -0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
-
-    -1.0f, -1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-     1.0f, -1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-     1.0f,  1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f,
-     1.0f,  1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f,
-    -1.0f,  1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f,
-    -1.0f, -1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
-    };
-
-    GLuint elements[] =
+    // Life mode: "-life [WIDTHxHEIGHT] [pattern file]" shows a Life board instead of the cube
+    if(lifeMode)
     {
-        0, 1, 2,
-        2, 3, 0
-    };
+        stopTextureLoader(textureLoader);
+        int result = runLife(window, argc - 2, argv + 2);
+        glfwTerminate();
+        return result;
+    }
 
-    // Create a vertex buffer object to store vertex data
-    GLuint vbo;
-    glGenBuffers(1, &vbo); // Generate 1 buffer
-    glBindBuffer(GL_ARRAY_BUFFER, vbo); // Prepare to write to vbo
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // Copy vertices to vbo
+    // The cube, the floor and their textures
+    Scene scene;
+    initScene(scene, 800.0f / 600.0f, meshPath);
+    initTextureUploads(textureLoader);
+    int texturesPending = 2;
 
 
     // Shaders
-    GLuint vertShader = glCreateShader(GL_VERTEX_SHADER);
-    GLuint fragShader = glCreateShader(GL_FRAGMENT_SHADER);
-
-    // Read the shader files
-    std::string vertShaderString = readFile("shader.vert");
-    std::string fragShaderString = readFile("shader.frag");
-    const char *vertShaderSource = vertShaderString.c_str();
-    const char *fragShaderSource = fragShaderString.c_str();
-
-    // Compile vertex shader
-    std::cout << "Compiling vertex shader.\n";
-    glShaderSource(vertShader, 1, &vertShaderSource, NULL);
-    glCompileShader(vertShader);
-
-    // Check vertex shader
-    GLint status;
-    glGetShaderiv(vertShader, GL_COMPILE_STATUS, &status);
-    if(status != GL_TRUE)
+    // Load the shader program, straight from the cache unless a source has changed since it was built
+    GLuint shaderProgram = loadProgram("shader.vert", "shader.frag", "cache");
+    if(shaderProgram == 0)
     {
-        std::cout << "Failed to compile vertex shader!\n";
-        char buffer[512];
-        glGetShaderInfoLog(vertShader, 512, NULL, buffer);
-        std::cout << buffer;
+        stopTextureLoader(textureLoader);
         return -1;
     }
 
-    // Compile fragment shader
-    std::cout << "Compiling fragment shader.\n";
-    glShaderSource(fragShader, 1, &fragShaderSource, NULL);
-    glCompileShader(fragShader);
+    // "-watch": rebuild the program whenever shader.vert or shader.frag is saved, and the
+    // cube field's whenever cubes.vert or shader.frag is
+    ShaderWatch shaderWatch, fieldWatch;
+    if(watchShaders)
+        startShaderWatch(shaderWatch, "shader.vert", "shader.frag", "cache");
+
+    // Start using the shader program
+    useSceneProgram(scene, shaderProgram);
 
-    // Check fragment shader
-    glGetShaderiv(fragShader, GL_COMPILE_STATUS, &status);
-    if(status != GL_TRUE)
+    CubeField field;
+    GLuint fieldProgram = 0;
+    if(cubeCount > 0)
     {
-        std::cout << "Failed to compile fragment shader!\n";
-        char buffer[512];
-        glGetShaderInfoLog(fragShader, 512, NULL, buffer);
-        std::cout << buffer;
-        return -1;
+        fieldProgram = loadProgram("cubes.vert", "shader.frag", "cache");
+        if(fieldProgram == 0)
+        {
+            stopTextureLoader(textureLoader);
+            return -1;
+        }
+        initCubeField(scene, field, cubeCount, fieldProgram);
+        if(watchShaders)
+            startShaderWatch(fieldWatch, "cubes.vert", "shader.frag", "cache");
     }
-    // The GLuint index for the final shader program
-    GLuint shaderProgram = glCreateProgram();
-
-    // Bind shader data locations
-    glBindFragDataLocation(shaderProgram, 0, "outColor");
-
-    // Link the shaders together
-    std::cout << "Linking shader program.\n";
-    glAttachShader(shaderProgram, vertShader);
-    glAttachShader(shaderProgram, fragShader);
-    glLinkProgram(shaderProgram);
-
-    // Clear the shaders now that they are unnecessary
-    glDeleteShader(vertShader);
-    glDeleteShader(fragShader);
-
-    // Start using the shader program
-    glUseProgram(shaderProgram);
 
     // End shader section
 
 
-    // Create vertex array object to store links between
-    // attributes and VBOs containing vertex data
-    // After binding a VAO, every call to glVertexAttribPointer
-    // will store information in that VAO. This allows storage of
-    // multiple vertex data formats.
-    // NOTE: Any vertex buffers and element buffers bound
-    // before the VAO is bound will be ignored for that
-    // VAO.
-    GLuint vao;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-
-    // Create an element buffer to store the indices
-    // of vertices to draw to the screen.
-    GLuint ebo;
-    glGenBuffers(1, &ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 sizeof(elements), elements, GL_STATIC_DRAW);
-
-    // Get reference index of "position" attribute in shader program
-    GLint posAttrib = glGetAttribLocation(shaderProgram, "position");
-    // Enable the vertex attribute array for use
-    glEnableVertexAttribArray(posAttrib);
-    // Specify format of the "position" attribute in the array
-    // EX: 0.0f, 0.5f, ...  => 2 elements of GL_FLOAT type
-    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 8*sizeof(float), 0);
-
-    // Prepare the color attribute
-    GLint colAttrib = glGetAttribLocation(shaderProgram, "color");
-    glEnableVertexAttribArray(colAttrib);
-    glVertexAttribPointer(colAttrib, 3, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)(3*sizeof(float)));
-
-    // Prepare the texture coordinate attribute
-    GLint texAttrib = glGetAttribLocation(shaderProgram, "texcoord");
-    glEnableVertexAttribArray(texAttrib);
-    glVertexAttribPointer(texAttrib, 2, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)(6*sizeof(float)));
-
-    // Textures
-
-    // Create texture variables
-    GLuint textures[2];
-    glGenTextures(2, textures);
-    unsigned char* image;
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textures[0]);
-    image = SOIL_load_image("img/archery.jpg", &width, &height, 0, SOIL_LOAD_RGBA);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-    SOIL_free_image_data(image);
-    glUniform1i(glGetUniformLocation(shaderProgram, "texOne"), 0);
-
-    // Set texture wrapping
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    // Set texture filtering for up- and downscaling
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, textures[1]);
-    image = SOIL_load_image("img/moose.jpg", &width, &height, 0, SOIL_LOAD_RGBA);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-    SOIL_free_image_data(image);
-    glUniform1i(glGetUniformLocation(shaderProgram, "texTwo"), 1);
-
-    // Set texture wrapping
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    // Set texture filtering for up- and downscaling
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-
-    // To generate a mipmap of an image:
-    //glGenerateMipmap(GL_TEXTURE_2D);
-
-    // Matrix transformations
-    // MODEL
-    GLint uniModel = glGetUniformLocation(shaderProgram, "model");
-
-    // VIEW
-    glm::mat4 view = glm::lookAt(
-        glm::vec3(2.2f, 2.2f, 2.2f),
-        glm::vec3(0.0f, 0.0f, 0.0f),
-        glm::vec3(0.0f, 0.0f, 1.0f)
-    );
-    GLint uniView = glGetUniformLocation(shaderProgram, "view");
-    glUniformMatrix4fv(uniView, 1, GL_FALSE, glm::value_ptr(view));
-
-    // PROJECTION
-    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 1.0f, 10.0f);
-    GLint uniProj = glGetUniformLocation(shaderProgram, "proj");
-    glUniformMatrix4fv(uniProj, 1, GL_FALSE, glm::value_ptr(proj));
-
-
-    // Color override for reflection
-    GLuint uniColor = glGetUniformLocation(shaderProgram, "overrideColor");
+    // The scene moves on its own thread, at a fixed step; frames only draw it
+    Updater updater;
+    startUpdater(updater);
+
+    // Frame timing, reported once a second
+    auto t_report = std::chrono::high_resolution_clock::now();
+    auto t_frame = t_report;
+    double intervalSum = 0, intervalSquares = 0, intervalMax = 0;
+    int frames = 0;
+    long long reportStep = 0;
 
     // Event loop
     while(!glfwWindowShouldClose(window))
     {
         auto t_now = std::chrono::high_resolution_clock::now();
         float time = std::chrono::duration_cast<std::chrono::duration<float>>(t_now - t_start).count();
+        SceneState state = sampleUpdater(updater);
 
         glfwPollEvents();
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Draw the cube
-        glm::mat4 model;
-        model = glm::rotate(
-            model,
-            time * 0.5f * glm::radians(180.0f),
-            glm::vec3(0.0f, 0.0f, 1.0f)
-        );
-        glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(model));
-        //glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-
-        glEnable(GL_STENCIL_TEST);
-
-        // Draw the floor
-        glStencilFunc(GL_ALWAYS, 1, 0xFF); // Set any stencil to 1
-        glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-        glStencilMask(0xFF); // Write to stencil buffer
-        glDepthMask(GL_FALSE); // Don't write to depth buffer
-        glClear(GL_STENCIL_BUFFER_BIT); // Clear stencil buffer (0 by default)
-
-        glDrawArrays(GL_TRIANGLES, 36, 6);
-
-        // Draw the cube reflection
-        glStencilFunc(GL_EQUAL, 1, 0xFF); // Pass test if stencil value is 1
-        glStencilMask(0x00); // Don't write anything to stencil buffer
-        glDepthMask(GL_TRUE); // Write to depth buffer
-
-        model = glm::scale(
-            glm::translate(model, glm::vec3(0, 0, -1)),
-            glm::vec3(1, 1, -1)
-        );
-        glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(model));
-        glUniform3f(uniColor, 0.3f, 0.3f, 0.3f);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glUniform3f(uniColor, 1.0f, 1.0f, 1.0f);
-
-        glDisable(GL_STENCIL_TEST);
 
+        // Upload whatever textures finished decoding since the last frame
+        if(texturesPending > 0)
+        {
+            texturesPending = pumpTextureLoader(textureLoader, scene.textures);
+            if(texturesPending == 0)
+                std::cout << "Textures loaded after " << time << " seconds\n";
+        }
+
+        // Switch to the rebuilt shader program as soon as a saved edit has linked
+        if(watchShaders)
+        {
+            GLuint rebuilt = pollShaderWatch(shaderWatch);
+            if(rebuilt != 0)
+            {
+                glDeleteProgram(shaderProgram);
+                shaderProgram = rebuilt;
+                useSceneProgram(scene, shaderProgram);
+            }
+            rebuilt = cubeCount > 0 ? pollShaderWatch(fieldWatch) : 0;
+            if(rebuilt != 0)
+            {
+                glDeleteProgram(fieldProgram);
+                fieldProgram = rebuilt;
+                useCubeFieldProgram(scene, field, fieldProgram);
+            }
+        }
+
+        SceneStats stats = { 0, 0 }; // Only SceneBench reports these
+        if(cubeCount > 0)
+            drawCubeField(scene, field, (float)state.time, nullptr, stats);
+        else
+            drawScene(scene, (float)state.time, nullptr, stats);
 
         glfwSwapBuffers(window);
         if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             glfwSetWindowShouldClose(window, GL_TRUE);
+
+        // Jitter is the spread of the intervals between frames
+        double interval = std::chrono::duration<double, std::milli>(t_now - t_frame).count();
+        t_frame = t_now;
+        intervalSum += interval;
+        intervalSquares += interval * interval;
+        intervalMax = std::max(intervalMax, interval);
+        frames++;
+        double elapsed = std::chrono::duration<double>(t_now - t_report).count();
+        if(reportTiming && elapsed >= 1.0)
+        {
+            double mean = intervalSum / frames;
+            double jitter = std::sqrt(std::max(intervalSquares / frames - mean * mean, 0.0));
+            std::printf("%.1f frames/s, frame %.2f ms (jitter %.2f ms, max %.2f ms), %lld update steps, %lld dropped\n",
+                        frames / elapsed, mean, jitter, intervalMax, state.step - reportStep, updater.droppedSteps.load());
+            std::fflush(stdout);
+            t_report = t_now;
+            intervalSum = intervalSquares = intervalMax = 0;
+            frames = 0;
+            reportStep = state.step;
+        }
     }
 
-    glDeleteTextures(2, textures);
+    stopUpdater(updater);
+    stopTextureLoader(textureLoader);
 
+    if(watchShaders)
+        stopShaderWatch(shaderWatch);
     glDeleteProgram(shaderProgram);
-    glDeleteShader(fragShader);
-    glDeleteShader(vertShader);
 
-    glDeleteBuffers(1, &ebo);
-    glDeleteBuffers(1, &vbo);
-
-    glDeleteVertexArrays(1, &vao);
+    if(cubeCount > 0)
+    {
+        if(watchShaders)
+            stopShaderWatch(fieldWatch);
+        destroyCubeField(field);
+        glDeleteProgram(fieldProgram);
+    }
+    destroyScene(scene);
 
     glfwTerminate();
     return 0;
 }
 
-std::string readFile(const char *filePath)
+int runLife(GLFWwindow *window, int argc, char **argv)
 {
-    std::string fileContents;
-    std::ifstream fileStream(filePath, std::ios::in);
+    int boardWidth = 1024, boardHeight = 1024;
+    bool sizeGiven = false;
+    const char *seedPath = nullptr;
+    BitTable board, scratch;
+    LifeRule rule;
 
-    if(!fileStream.is_open())
+    for(int i = 0; i < argc; i++)
     {
-        std::cout << "Failed to open file: " << filePath << std::endl;
-        return "";
+        // Anything that starts like WIDTHx is a size, and has to be a whole one
+        size_t digits = std::strspn(argv[i], "+-0123456789");
+        if(digits > 0 && argv[i][digits] == 'x')
+        {
+            int width, height;
+            char extra;
+            if(std::sscanf(argv[i], "%dx%d%c", &width, &height, &extra) != 2 || width <= 0 || height <= 0)
+            {
+                std::cout << "Bad board size: " << argv[i] << " (expected WIDTHxHEIGHT)" << std::endl;
+                return -1;
+            }
+            boardWidth = width;
+            boardHeight = height;
+            sizeGiven = true;
+        }
+        else
+            seedPath = argv[i];
+    }
+    makeRule(rule, RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVE);
+
+    // Seed the board from a pattern file, or with a random soup
+    if(seedPath != nullptr)
+    {
+        Pattern pattern;
+        if(!openPattern(seedPath, pattern))
+        {
+            std::cout << "Failed to open pattern: " << seedPath << std::endl;
+            return -1;
+        }
+        if(!sizeGiven && pattern.width > 0 && pattern.height > 0)
+        {
+            boardWidth = pattern.width;
+            boardHeight = pattern.height;
+        }
+        if(!pattern.rule.empty())
+            parseRule(pattern.rule.c_str(), rule);
+        initBitTable(board, boardWidth, boardHeight);
+        bool loaded = readPattern(pattern, boardWidth, boardHeight, [&](int x, int y, int length)
+        {
+            setBitRun(board, x, y, length);
+        });
+        closePattern(pattern);
+        if(!loaded)
+        {
+            std::cout << "Failed to read pattern: " << seedPath << std::endl;
+            return -1;
+        }
+    }
+    else
+    {
+        std::mt19937 random(1);
+        initBitTable(board, boardWidth, boardHeight);
+        for(int y = 0; y < boardHeight; y++)
+            for(int x = 0; x < boardWidth; x++)
+                if(random() % 100 < 35)
+                    setBitCell(board, x, y, 1);
+    }
+    initBitTable(scratch, boardWidth, boardHeight);
+
+    GLuint program = loadProgram("life.vert", "life.frag", "cache");
+    if(program == 0)
+        return -1;
+    LifeView view;
+    if(!initLifeView(view, boardWidth, boardHeight, program))
+    {
+        std::cout << "Failed to create the board texture" << std::endl;
+        return -1;
     }
+    glDisable(GL_DEPTH_TEST);
 
-    std::string line = "";
-    while(!fileStream.eof())
+    // Timing, reported once a second
+    auto t_report = std::chrono::high_resolution_clock::now();
+    double uploadSeconds = 0, stepSeconds = 0;
+    long long uploadedRows = 0, uploadCalls = 0;
+    int frames = 0;
+    long long generation = 0;
+
+    while(!glfwWindowShouldClose(window))
     {
-        std::getline(fileStream, line);
-        fileContents.append(line + "\n");
+        glfwPollEvents();
+
+        auto t_frame = std::chrono::high_resolution_clock::now();
+        uploadLifeView(view, board);
+        auto t_uploaded = std::chrono::high_resolution_clock::now();
+
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        drawLifeView(view, framebufferWidth, framebufferHeight);
+
+        // Step the next generation while the GPU draws this one
+        fillBitBorder(board, EDGE_TORUS);
+        bitIterate(board, scratch, rule);
+        std::swap(board.words, scratch.words);
+        generation++;
+        auto t_stepped = std::chrono::high_resolution_clock::now();
+
+        glfwSwapBuffers(window);
+
+        uploadSeconds += std::chrono::duration<double>(t_uploaded - t_frame).count();
+        stepSeconds += std::chrono::duration<double>(t_stepped - t_uploaded).count();
+        uploadedRows += view.uploadedRows;
+        uploadCalls += view.uploadCalls;
+        frames++;
+        double elapsed = std::chrono::duration<double>(t_stepped - t_report).count();
+        if(elapsed >= 1.0)
+        {
+            std::printf("generation %lld: %.1f frames/s, upload %.2f ms, step %.2f ms, %lld rows in %lld calls per frame\n",
+                        generation, frames / elapsed, uploadSeconds * 1000 / frames, stepSeconds * 1000 / frames,
+                        uploadedRows / frames, uploadCalls / frames);
+            std::fflush(stdout);
+            t_report = t_stepped;
+            uploadSeconds = stepSeconds = 0;
+            uploadedRows = uploadCalls = 0;
+            frames = 0;
+        }
+
+        if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, GL_TRUE);
     }
 
-    fileStream.close();
-    return fileContents;
+    destroyLifeView(view);
+    glDeleteProgram(program);
+    return 0;
 }
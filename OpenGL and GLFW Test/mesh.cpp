@@ -0,0 +1,231 @@
+#include "mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+static uint16_t packHalf(float value);
+static uint16_t packUnorm16(float value);
+
+// The 16 bytes of a packed vertex, to merge the ones that come out the same
+struct VertexKey
+{
+    uint64_t bits[2];
+    bool operator==(const VertexKey &other) const { return bits[0] == other.bits[0] && bits[1] == other.bits[1]; }
+};
+
+struct VertexKeyHash
+{
+    size_t operator()(const VertexKey &key) const
+    {
+        uint64_t mixed = (key.bits[0] ^ (key.bits[1] * 0x9E3779B97F4A7C15ull)) * 0xBF58476D1CE4E5B9ull;
+        return (size_t)(mixed ^ (mixed >> 31));
+    }
+};
+
+bool packMesh(const std::vector<float> &vertices, const std::vector<uint32_t> &partEnds,
+              uint32_t positionFormat, PackedMesh &mesh, std::string &error)
+{
+    size_t count = vertices.size() / MESH_SOURCE_FLOATS;
+
+    // snorm16 spans -1 to 1, so positions are stored as fractions of the largest coordinate
+    float largest = 0.0f;
+    for(size_t i = 0; i < count; i++)
+        for(int c = 0; c < 3; c++)
+            largest = std::max(largest, std::fabs(vertices[i * MESH_SOURCE_FLOATS + c]));
+    mesh.positionFormat = positionFormat;
+    mesh.positionScale = positionFormat == MESH_POSITION_SNORM16 && largest > 0.0f ? largest : 1.0f;
+    mesh.parts.clear();
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    mesh.indices.reserve(count);
+
+    std::unordered_map<VertexKey, uint32_t, VertexKeyHash> merged;
+    size_t part = 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        const float *source = &vertices[i * MESH_SOURCE_FLOATS];
+        for(int c = 3; c < 8; c++)
+        {
+            if(!(source[c] >= 0.0f && source[c] <= 1.0f))
+            {
+                char message[96];
+                std::snprintf(message, sizeof(message), "vertex %zu has a %s of %g, outside 0 to 1",
+                              i, c < 6 ? "colour" : "texture coordinate", source[c]);
+                error = message;
+                return false;
+            }
+        }
+
+        PackedVertex vertex;
+        for(int c = 0; c < 3; c++)
+        {
+            if(positionFormat == MESH_POSITION_SNORM16)
+                vertex.position[c] = (uint16_t)(int16_t)std::lround(source[c] / mesh.positionScale * 32767.0f);
+            else
+                vertex.position[c] = packHalf(source[c]);
+            vertex.color[c] = (uint8_t)std::lround(source[3 + c] * 255.0f);
+        }
+        vertex.position[3] = 0;
+        vertex.color[3] = 255;
+        vertex.texcoord[0] = packUnorm16(source[6]);
+        vertex.texcoord[1] = packUnorm16(source[7]);
+
+        VertexKey key;
+        std::memcpy(key.bits, &vertex, sizeof(vertex));
+        auto found = merged.insert(std::make_pair(key, (uint32_t)mesh.vertices.size()));
+        if(found.second)
+            mesh.vertices.push_back(vertex);
+        mesh.indices.push_back(found.first->second);
+
+        // Close every part that ends here (an empty one included)
+        while(part < partEnds.size() && partEnds[part] <= i + 1)
+        {
+            uint32_t first = mesh.parts.empty() ? 0 : mesh.parts.back().firstIndex + mesh.parts.back().indexCount;
+            MeshPart closed = { first, (uint32_t)(i + 1) - first };
+            mesh.parts.push_back(closed);
+            part++;
+        }
+    }
+    return true;
+}
+
+void serializeMesh(const PackedMesh &mesh, std::vector<char> &bytes)
+{
+    MeshFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "MESHBIN", 8);
+    header.version = MESH_FILE_VERSION;
+    header.positionFormat = mesh.positionFormat;
+    header.positionScale = mesh.positionScale;
+    header.indexSize = mesh.vertices.size() <= 65536 ? 2 : 4;
+    header.partCount = mesh.parts.size();
+    header.vertexCount = mesh.vertices.size();
+    header.indexCount = mesh.indices.size();
+    header.dataOffset = (sizeof(header) + mesh.parts.size() * sizeof(MeshPart) + 15) & ~15u;
+
+    size_t vertexBytes = mesh.vertices.size() * sizeof(PackedVertex);
+    bytes.assign(header.dataOffset + vertexBytes + mesh.indices.size() * header.indexSize, 0);
+    std::memcpy(&bytes[0], &header, sizeof(header));
+    if(!mesh.parts.empty())
+        std::memcpy(&bytes[sizeof(header)], mesh.parts.data(), mesh.parts.size() * sizeof(MeshPart));
+    if(vertexBytes > 0)
+        std::memcpy(&bytes[header.dataOffset], mesh.vertices.data(), vertexBytes);
+
+    char *indices = &bytes[0] + header.dataOffset + vertexBytes;
+    for(size_t i = 0; i < mesh.indices.size(); i++)
+    {
+        if(header.indexSize == 2)
+        {
+            uint16_t index = (uint16_t)mesh.indices[i];
+            std::memcpy(indices + i * 2, &index, 2);
+        }
+        else
+            std::memcpy(indices + i * 4, &mesh.indices[i], 4);
+    }
+}
+
+bool writeMesh(const char *path, const PackedMesh &mesh)
+{
+    std::vector<char> bytes;
+    serializeMesh(mesh, bytes);
+    FILE *file = std::fopen(path, "wb");
+    if(file == nullptr)
+        return false;
+    bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return std::fclose(file) == 0 && written;
+}
+
+bool viewMesh(const char *bytes, size_t size, MeshView &view)
+{
+    if(bytes == nullptr || size < sizeof(MeshFileHeader))
+        return false;
+    const MeshFileHeader *header = (const MeshFileHeader*)bytes;
+    if(std::memcmp(header->magic, "MESHBIN", 8) != 0 || header->version != MESH_FILE_VERSION ||
+       header->positionFormat > MESH_POSITION_SNORM16 || (header->indexSize != 2 && header->indexSize != 4) ||
+       header->dataOffset < sizeof(MeshFileHeader) + (uint64_t)header->partCount * sizeof(MeshPart) ||
+       header->dataOffset % 4 != 0)
+        return false;
+
+    uint64_t dataSize = (uint64_t)header->vertexCount * sizeof(PackedVertex) + (uint64_t)header->indexCount * header->indexSize;
+    if(header->dataOffset + dataSize > size)
+        return false;
+
+    // Every part within the indices, and every index within the vertices
+    const MeshPart *parts = (const MeshPart*)(bytes + sizeof(MeshFileHeader));
+    for(uint32_t i = 0; i < header->partCount; i++)
+        if((uint64_t)parts[i].firstIndex + parts[i].indexCount > header->indexCount)
+            return false;
+    const char *indices = bytes + header->dataOffset + (size_t)header->vertexCount * sizeof(PackedVertex);
+    for(uint32_t i = 0; i < header->indexCount; i++)
+    {
+        uint32_t index = 0;
+        std::memcpy(&index, indices + (size_t)i * header->indexSize, header->indexSize);
+        if(index >= header->vertexCount)
+            return false;
+    }
+
+    view.header = header;
+    view.parts = parts;
+    view.data = bytes + header->dataOffset;
+    view.dataSize = (size_t)dataSize;
+    return true;
+}
+
+bool openMesh(const char *path, MeshView &view)
+{
+    if(!mapFile(path, view.file))
+        return false;
+    if(!viewMesh(view.file.data, view.file.size, view))
+    {
+        unmapFile(view.file);
+        return false;
+    }
+    return true;
+}
+
+void closeMesh(MeshView &view)
+{
+    unmapFile(view.file);
+    view.header = nullptr;
+    view.parts = nullptr;
+    view.data = nullptr;
+    view.dataSize = 0;
+}
+
+static uint16_t packHalf(float value)
+{
+    // IEEE 754 binary16, rounded to nearest even; out-of-range values become infinity
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    uint16_t sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if(((bits >> 23) & 0xFF) == 0xFF)
+        return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0); // Infinity or NaN
+    if(exponent >= 31)
+        return sign | 0x7C00;
+    if(exponent <= 0)
+    {
+        // Subnormal, or too small for even that
+        if(exponent < -10)
+            return sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift, rest = mantissa & ((1u << shift) - 1), midway = 1u << (shift - 1);
+        if(rest > midway || (rest == midway && (half & 1)))
+            half++;
+        return sign | (uint16_t)half;
+    }
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13), rest = mantissa & 0x1FFF;
+    if(rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half++; // A carry into the exponent is still the right rounding
+    return sign | (uint16_t)half;
+}
+
+static uint16_t packUnorm16(float value)
+{
+    return (uint16_t)std::lround(value * 65535.0f);
+}
@@ -0,0 +1,99 @@
+// Packed meshes
+//
+// Vertices packed for the GPU in 16 bytes rather than the 32 of eight floats: the
+// position as three half floats, or as three snorm16 fractions of the mesh's largest
+// coordinate, the colour as unorm8 and the texture coordinates as unorm16. Vertices
+// that pack to the same bytes are merged, so each is stored once and drawn through an
+// index; the indices are 16-bit whenever there are few enough vertices.
+//
+// MeshBake writes packed meshes to .mesh files: a header, the parts the mesh is drawn
+// in, then the vertices and indices exactly as they go into the vertex buffer. Loading
+// one maps the file and hands the driver that block in a single upload, with nothing
+// to parse or convert.
+
+#ifndef MESH_H
+#define MESH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+
+#define MESH_FILE_VERSION 1
+#define MESH_SOURCE_FLOATS 8 // Position, colour and texture coordinates of each vertex packMesh takes
+
+#define MESH_POSITION_HALF 0 // Positions as they are, in half floats
+#define MESH_POSITION_SNORM16 1 // Positions over positionScale, in snorm16: finer, for meshes far from the origin
+
+// One vertex as the GPU reads it
+struct PackedVertex
+{
+    uint16_t position[4]; // x, y and z, then a 0 that keeps the rest aligned
+    uint8_t color[4]; // RGB, then an unused 255
+    uint16_t texcoord[2];
+};
+
+// A range of indices drawn together
+struct MeshPart
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+// The start of a .mesh file; the parts follow it, then at dataOffset the vertices and indices
+struct MeshFileHeader
+{
+    char magic[8]; // "MESHBIN"
+    uint32_t version; // MESH_FILE_VERSION
+    uint32_t positionFormat; // MESH_POSITION_HALF or MESH_POSITION_SNORM16
+    float positionScale; // What unpacked positions are multiplied by
+    uint32_t indexSize; // Bytes in each index, 2 or 4
+    uint32_t partCount;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t dataOffset; // From the start of the file
+};
+
+// A mesh packed in memory
+struct PackedMesh
+{
+    uint32_t positionFormat;
+    float positionScale;
+    std::vector<MeshPart> parts;
+    std::vector<PackedVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// A packed mesh read in place, from a mapped .mesh file or from its bytes in memory
+struct MeshView
+{
+    MappedFile file; // Empty unless opened by openMesh
+    const MeshFileHeader *header;
+    const MeshPart *parts;
+    const char *data; // The vertices, then the indices: the vertex buffer as it is uploaded
+    size_t dataSize;
+};
+
+// Pack triangles given as MESH_SOURCE_FLOATS floats a vertex, three vertices each and not
+// indexed, into mesh. partEnds holds the vertex count at the end of each part. Returns
+// false, with the reason in error, if a colour or texture coordinate lies outside 0 to 1,
+// which the unorm formats cannot hold.
+bool packMesh(const std::vector<float> &vertices, const std::vector<uint32_t> &partEnds,
+              uint32_t positionFormat, PackedMesh &mesh, std::string &error);
+
+// The contents of the .mesh file for mesh
+void serializeMesh(const PackedMesh &mesh, std::vector<char> &bytes);
+
+bool writeMesh(const char *path, const PackedMesh &mesh);
+
+// Check the contents of a .mesh file and point view at its parts and data; bytes must
+// outlive the view. Returns false if they are not a mesh this version can draw.
+bool viewMesh(const char *bytes, size_t size, MeshView &view);
+
+// Map a .mesh file and view it
+bool openMesh(const char *path, MeshView &view);
+
+void closeMesh(MeshView &view);
+
+#endif // MESH_H
@@ -0,0 +1,179 @@
+// MeshBake
+//
+// Bakes a Wavefront OBJ mesh into a packed .mesh file (mesh.h), which the app and
+// SceneBench load with -mesh in a single buffer upload. Faces of any size are split
+// into triangles. Vertex colours are read from the common "v x y z r g b" extension
+// and are white where there are none; texture coordinates must lie within 0 to 1.
+// Each "o" or "g" line that follows some faces starts a new part, and the scene draws
+// the first part as its cube and the second as its floor.
+//
+// Usage: MeshBake [-snorm] SOURCE.obj OUTPUT.mesh
+//      -snorm - store positions as snorm16 fractions of the largest coordinate, rather
+//               than as half floats; better for meshes whose detail is far from the origin
+//
+// Build: g++ -O2 -std=c++11 -I"../Conway's Game of Life" meshbake.cpp mesh.cpp
+//            "../Conway's Game of Life/mappedfile.cpp" -o MeshBake
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mesh.h"
+
+static bool readObj(const char *path, std::vector<float> &vertices, std::vector<uint32_t> &partEnds);
+static bool resolveIndex(const std::string &text, size_t count, size_t &index);
+
+int main(int argc, char** argv)
+{
+    uint32_t positionFormat = MESH_POSITION_HALF;
+    std::vector<const char*> paths;
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::string(argv[i]) == "-snorm")
+            positionFormat = MESH_POSITION_SNORM16;
+        else
+            paths.push_back(argv[i]);
+    }
+    if(paths.size() != 2)
+    {
+        std::cerr << "Usage: MeshBake [-snorm] SOURCE.obj OUTPUT.mesh" << std::endl;
+        return 1;
+    }
+
+    std::vector<float> vertices;
+    std::vector<uint32_t> partEnds;
+    if(!readObj(paths[0], vertices, partEnds))
+        return 1;
+
+    PackedMesh mesh;
+    std::string error;
+    if(!packMesh(vertices, partEnds, positionFormat, mesh, error))
+    {
+        std::cerr << paths[0] << ": " << error << std::endl;
+        return 1;
+    }
+    if(!writeMesh(paths[1], mesh))
+    {
+        std::cerr << "Could not write " << paths[1] << std::endl;
+        return 1;
+    }
+
+    // What the packing saved, against the same triangles as unindexed floats
+    size_t triangles = mesh.indices.size() / 3;
+    size_t packedBytes = mesh.vertices.size() * sizeof(PackedVertex) +
+                         mesh.indices.size() * (mesh.vertices.size() <= 65536 ? 2 : 4);
+    size_t floatBytes = vertices.size() * sizeof(float);
+    std::printf("%zu triangles in %zu parts: %zu vertices from %zu, %zu bytes from %zu (%.1fx smaller)\n",
+                triangles, mesh.parts.size(), mesh.vertices.size(), mesh.indices.size(),
+                packedBytes, floatBytes, packedBytes > 0 ? (double)floatBytes / packedBytes : 0.0);
+    return 0;
+}
+
+static bool readObj(const char *path, std::vector<float> &vertices, std::vector<uint32_t> &partEnds)
+{
+    std::ifstream file(path);
+    if(!file)
+    {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+
+    std::vector<float> positions; // x, y, z, r, g, b for each "v"
+    std::vector<float> texcoords; // u, v for each "vt"
+    std::string line;
+    int lineNumber = 0;
+    while(std::getline(file, line))
+    {
+        lineNumber++;
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+
+        if(kind == "v")
+        {
+            float value[6] = { 0, 0, 0, 1, 1, 1 };
+            int read = 0;
+            while(read < 6 && fields >> value[read])
+                read++;
+            if(read != 3 && read != 6)
+            {
+                std::cerr << path << ":" << lineNumber << ": a vertex needs x y z, or x y z r g b" << std::endl;
+                return false;
+            }
+            positions.insert(positions.end(), value, value + 6);
+        }
+        else if(kind == "vt")
+        {
+            float value[2] = { 0, 0 };
+            if(!(fields >> value[0]))
+            {
+                std::cerr << path << ":" << lineNumber << ": a texture coordinate needs u" << std::endl;
+                return false;
+            }
+            fields >> value[1];
+            texcoords.insert(texcoords.end(), value, value + 2);
+        }
+        else if(kind == "f")
+        {
+            // Each corner is v, v/vt, v//vn or v/vt/vn; normals are not used
+            std::vector<float> corners;
+            std::string corner;
+            while(fields >> corner)
+            {
+                size_t slash = corner.find('/');
+                std::string vt = slash == std::string::npos ? "" : corner.substr(slash + 1, corner.find('/', slash + 1) - slash - 1);
+                size_t v, t = 0;
+                if(!resolveIndex(corner.substr(0, slash), positions.size() / 6, v) ||
+                   (!vt.empty() && !resolveIndex(vt, texcoords.size() / 2, t)))
+                {
+                    std::cerr << path << ":" << lineNumber << ": bad face corner " << corner << std::endl;
+                    return false;
+                }
+                corners.insert(corners.end(), &positions[v * 6], &positions[v * 6] + 6);
+                corners.push_back(vt.empty() ? 0.0f : texcoords[t * 2]);
+                corners.push_back(vt.empty() ? 0.0f : texcoords[t * 2 + 1]);
+            }
+
+            // Split into a fan of triangles around the first corner
+            size_t count = corners.size() / MESH_SOURCE_FLOATS;
+            for(size_t i = 1; i + 1 < count; i++)
+            {
+                vertices.insert(vertices.end(), &corners[0], &corners[0] + MESH_SOURCE_FLOATS);
+                vertices.insert(vertices.end(), &corners[i * MESH_SOURCE_FLOATS], &corners[(i + 2) * MESH_SOURCE_FLOATS]);
+            }
+        }
+        else if(kind == "o" || kind == "g")
+        {
+            uint32_t end = vertices.size() / MESH_SOURCE_FLOATS;
+            if(end > (partEnds.empty() ? 0 : partEnds.back()))
+                partEnds.push_back(end);
+        }
+    }
+
+    uint32_t end = vertices.size() / MESH_SOURCE_FLOATS;
+    if(end == 0)
+    {
+        std::cerr << path << " has no faces" << std::endl;
+        return false;
+    }
+    if(end > (partEnds.empty() ? 0 : partEnds.back()))
+        partEnds.push_back(end);
+    return true;
+}
+
+static bool resolveIndex(const std::string &text, size_t count, size_t &index)
+{
+    // OBJ counts from 1, and from the end when negative
+    char *end;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if(text.empty() || *end != '\0' || value == 0)
+        return false;
+    long resolved = value > 0 ? value - 1 : (long)count + value;
+    if(resolved < 0 || resolved >= (long)count)
+        return false;
+    index = (size_t)resolved;
+    return true;
+}
@@ -0,0 +1,443 @@
+#include "scene.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include "mesh.h"
+#include "GLM/gtc/matrix_transform.hpp"
+#include "GLM/gtc/type_ptr.hpp"
+
+static void uploadMesh(Scene &scene, const MeshView &mesh);
+static void pointAttributes(const Scene &scene, GLuint program);
+
+// The cube, then the floor, as unindexed triangles; initScene packs them and merges the shared vertices
+static const float vertices[] =
+{
+    //  X       Y      Z     R     G     B     U     V
+        -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+     0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+     0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+
+    -0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+     0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+
+    -0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+
+     0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+     0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+     0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+     0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+
+    -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+     0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+     0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+
+    -0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+     0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+
+    -1.0f, -1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+     1.0f, -1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+     1.0f,  1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+     1.0f,  1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+    -1.0f,  1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+    -1.0f, -1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
+};
+
+void initScene(Scene &scene, float aspect, const char *meshPath)
+{
+    // Enable depth testing
+    glEnable(GL_DEPTH_TEST);
+
+    // A baked mesh is drawn straight from its mapped file
+    MeshView mesh;
+    bool loaded = meshPath != nullptr && openMesh(meshPath, mesh);
+    if(loaded && mesh.header->partCount < 2)
+    {
+        closeMesh(mesh);
+        loaded = false;
+    }
+    if(meshPath != nullptr && !loaded)
+        std::cout << "Could not load the mesh " << meshPath << "; drawing the cube instead\n";
+
+    // Otherwise pack the built-in one the same way: the cube's 36 vertices come down to 24, the floor's 6 to 4
+    std::vector<char> packed;
+    if(!loaded)
+    {
+        PackedMesh builtIn;
+        std::string error;
+        packMesh(std::vector<float>(vertices, vertices + sizeof(vertices) / sizeof(float)),
+                 std::vector<uint32_t>{ 36, 42 }, MESH_POSITION_HALF, builtIn, error);
+        serializeMesh(builtIn, packed);
+        viewMesh(packed.data(), packed.size(), mesh);
+        mesh.file.data = nullptr;
+        mesh.file.size = 0;
+        mesh.file.mapped = false;
+    }
+
+    // Create vertex array object to store links between
+    // attributes and VBOs containing vertex data
+    // After binding a VAO, every call to glVertexAttribPointer
+    // will store information in that VAO. This allows storage of
+    // multiple vertex data formats.
+    // NOTE: Any vertex buffers and element buffers bound
+    // before the VAO is bound will be ignored for that
+    // VAO.
+    glGenVertexArrays(1, &scene.vao);
+    glBindVertexArray(scene.vao);
+
+    // Create the buffer, with the vertices and then the indices of vertices to draw to the screen
+    uploadMesh(scene, mesh);
+    closeMesh(mesh);
+
+    // Create texture variables; each shows one white texel until its image has loaded
+    glGenTextures(2, scene.textures);
+    const unsigned char placeholder[4] = { 255, 255, 255, 255 };
+
+    for(int i = 0; i < 2; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, scene.textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+
+        // Set texture wrapping
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // Set texture filtering for up- and downscaling; the loader switches to mipmaps once they are there
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    // Matrix transformations
+    // VIEW
+    scene.view = glm::lookAt(
+        glm::vec3(2.2f, 2.2f, 2.2f),
+        glm::vec3(0.0f, 0.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f)
+    );
+
+    // PROJECTION
+    scene.proj = glm::perspective(glm::radians(45.0f), aspect, 1.0f, 10.0f);
+
+    scene.program = 0;
+}
+
+void useSceneProgram(Scene &scene, GLuint program)
+{
+    scene.program = program;
+    glUseProgram(program);
+    glBindVertexArray(scene.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.vbo);
+
+    pointAttributes(scene, program);
+
+    glUniform1f(glGetUniformLocation(program, "positionScale"), scene.positionScale);
+    glUniform1i(glGetUniformLocation(program, "texOne"), 0);
+    glUniform1i(glGetUniformLocation(program, "texTwo"), 1);
+
+    // MODEL
+    scene.uniModel = glGetUniformLocation(program, "model");
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(scene.view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "proj"), 1, GL_FALSE, glm::value_ptr(scene.proj));
+
+    // Color override for reflection
+    scene.uniColor = glGetUniformLocation(program, "overrideColor");
+    glUniform3f(scene.uniColor, 1.0f, 1.0f, 1.0f);
+}
+
+void drawScene(Scene &scene, float time, const GLuint *passQueries, SceneStats &stats)
+{
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Draw the cube
+    if(passQueries != nullptr)
+        glBeginQuery(GL_TIME_ELAPSED, passQueries[0]);
+    glm::mat4 model;
+    model = glm::rotate(
+        model,
+        time * 0.5f * glm::radians(180.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f)
+    );
+    glUniformMatrix4fv(scene.uniModel, 1, GL_FALSE, glm::value_ptr(model));
+    glDrawElements(GL_TRIANGLES, scene.cubeIndices, scene.indexType, scene.cubeOffset);
+    stats.stateChanges += 1;
+    stats.drawCalls += 1;
+    if(passQueries != nullptr)
+        glEndQuery(GL_TIME_ELAPSED);
+
+
+    glEnable(GL_STENCIL_TEST);
+
+    // Draw the floor
+    if(passQueries != nullptr)
+        glBeginQuery(GL_TIME_ELAPSED, passQueries[1]);
+    glStencilFunc(GL_ALWAYS, 1, 0xFF); // Set any stencil to 1
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    glStencilMask(0xFF); // Write to stencil buffer
+    glDepthMask(GL_FALSE); // Don't write to depth buffer
+    glClear(GL_STENCIL_BUFFER_BIT); // Clear stencil buffer (0 by default)
+
+    glDrawElements(GL_TRIANGLES, scene.floorIndices, scene.indexType, scene.floorOffset);
+    stats.stateChanges += 5; // The stencil test, its function, operation and mask, and the depth mask
+    stats.drawCalls += 1;
+    if(passQueries != nullptr)
+        glEndQuery(GL_TIME_ELAPSED);
+
+    // Draw the cube reflection
+    if(passQueries != nullptr)
+        glBeginQuery(GL_TIME_ELAPSED, passQueries[2]);
+    glStencilFunc(GL_EQUAL, 1, 0xFF); // Pass test if stencil value is 1
+    glStencilMask(0x00); // Don't write anything to stencil buffer
+    glDepthMask(GL_TRUE); // Write to depth buffer
+
+    model = glm::scale(
+        glm::translate(model, glm::vec3(0, 0, -1)),
+        glm::vec3(1, 1, -1)
+    );
+    glUniformMatrix4fv(scene.uniModel, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform3f(scene.uniColor, 0.3f, 0.3f, 0.3f);
+    glDrawElements(GL_TRIANGLES, scene.cubeIndices, scene.indexType, scene.cubeOffset);
+    glUniform3f(scene.uniColor, 1.0f, 1.0f, 1.0f);
+
+    glDisable(GL_STENCIL_TEST);
+    stats.stateChanges += 7; // Stencil function and mask, depth mask, model, colour twice, the stencil test
+    stats.drawCalls += 1;
+    if(passQueries != nullptr)
+        glEndQuery(GL_TIME_ELAPSED);
+}
+
+void initCubeField(Scene &scene, CubeField &field, int count, GLuint program)
+{
+    std::vector<CubeInstance> instances(count);
+    int side = (int)std::ceil(std::sqrt((double)count)); // Cubes along each edge of the floor
+    float spacing = 2.0f / side, size = spacing * 0.6f;
+
+    // A square grid covering the floor, every cube resting on it, turning at its own
+    // speed from its own angle, and tinted along a hue wheel from one corner
+    for(int i = 0; i < count; i++)
+    {
+        int column = i % side, row = i / side;
+        CubeInstance &cube = instances[i];
+        cube.x = -1.0f + spacing * (column + 0.5f);
+        cube.y = -1.0f + spacing * (row + 0.5f);
+        cube.z = -0.5f + size * 0.5f;
+        cube.size = size;
+        cube.phase = (float)((i * 2654435761u) % 6283) / 1000.0f;
+        cube.speed = 0.5f + (float)((i * 40503u) % 1000) / 500.0f;
+        float hue = (float)(column + row) / (2 * side) * 6.0f;
+        for(int c = 0; c < 3; c++)
+        {
+            float channel = std::fabs(std::fmod(hue + 4.0f - 2.0f * c, 6.0f) - 3.0f) - 1.0f;
+            cube.tint[c] = (unsigned char)(255.0f * std::min(std::max(channel, 0.25f), 1.0f));
+        }
+        cube.tint[3] = 255;
+    }
+
+    field.count = count;
+    glGenBuffers(1, &field.instances);
+    glBindBuffer(GL_ARRAY_BUFFER, field.instances);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(CubeInstance), instances.data(), GL_STATIC_DRAW);
+
+    // Its own VAO: the scene's vertices and indices, and one CubeInstance per cube
+    glGenVertexArrays(1, &field.vao);
+    glBindVertexArray(field.vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene.vbo);
+    glBindVertexArray(scene.vao);
+
+    useCubeFieldProgram(scene, field, program);
+}
+
+void useCubeFieldProgram(Scene &scene, CubeField &field, GLuint program)
+{
+    field.program = program;
+    glBindVertexArray(field.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.vbo);
+    pointAttributes(scene, program);
+
+    // (-1 when a rebuilt shader no longer uses an attribute, which leaves it alone)
+    glBindBuffer(GL_ARRAY_BUFFER, field.instances);
+    GLint placementAttrib = glGetAttribLocation(program, "placement");
+    if(placementAttrib >= 0)
+    {
+        glEnableVertexAttribArray(placementAttrib);
+        glVertexAttribPointer(placementAttrib, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)offsetof(CubeInstance, x));
+        glVertexAttribDivisor(placementAttrib, 1); // Advance once per cube rather than once per vertex
+    }
+    GLint spinAttrib = glGetAttribLocation(program, "spin");
+    if(spinAttrib >= 0)
+    {
+        glEnableVertexAttribArray(spinAttrib);
+        glVertexAttribPointer(spinAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)offsetof(CubeInstance, phase));
+        glVertexAttribDivisor(spinAttrib, 1);
+    }
+    GLint tintAttrib = glGetAttribLocation(program, "tint");
+    if(tintAttrib >= 0)
+    {
+        glEnableVertexAttribArray(tintAttrib);
+        glVertexAttribPointer(tintAttrib, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CubeInstance), (void*)offsetof(CubeInstance, tint));
+        glVertexAttribDivisor(tintAttrib, 1);
+    }
+    glBindVertexArray(scene.vao);
+
+    glUseProgram(program);
+    glUniform1f(glGetUniformLocation(program, "positionScale"), scene.positionScale);
+    glUniform1i(glGetUniformLocation(program, "texOne"), 0);
+    glUniform1i(glGetUniformLocation(program, "texTwo"), 1);
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(scene.view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "proj"), 1, GL_FALSE, glm::value_ptr(scene.proj));
+    field.uniTime = glGetUniformLocation(program, "time");
+    field.uniMirror = glGetUniformLocation(program, "mirror");
+    field.uniColor = glGetUniformLocation(program, "overrideColor");
+    glUseProgram(scene.program);
+}
+
+void drawCubeField(Scene &scene, CubeField &field, float time, const GLuint *passQueries, SceneStats &stats)
+{
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Draw every cube at once; each turns itself in the vertex shader
+    if(passQueries != nullptr)
+        glBeginQuery(GL_TIME_ELAPSED, passQueries[0]);
+    glUseProgram(field.program);
+    glBindVertexArray(field.vao);
+    glUniform1f(field.uniTime, time);
+    glUniform1f(field.uniMirror, 1.0f);
+    glUniform3f(field.uniColor, 1.0f, 1.0f, 1.0f);
+    glDrawElementsInstanced(GL_TRIANGLES, scene.cubeIndices, scene.indexType, scene.cubeOffset, field.count);
+    stats.stateChanges += 5; // Program, VAO, time, mirror, colour
+    stats.drawCalls += 1;
+    if(passQueries != nullptr)
+        glEndQuery(GL_TIME_ELAPSED);
+
+    glEnable(GL_STENCIL_TEST);
+
+    // Draw the floor, flat, with the scene's own program
+    if(passQueries != nullptr)
+        glBeginQuery(GL_TIME_ELAPSED, passQueries[1]);
+    glUseProgram(scene.program);
+    glBindVertexArray(scene.vao);
+    glUniformMatrix4fv(scene.uniModel, 1, GL_FALSE, glm::value_ptr(glm::mat4()));
+    glStencilFunc(GL_ALWAYS, 1, 0xFF); // Set any stencil to 1
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    glStencilMask(0xFF); // Write to stencil buffer
+    glDepthMask(GL_FALSE); // Don't write to depth buffer
+    glClear(GL_STENCIL_BUFFER_BIT); // Clear stencil buffer (0 by default)
+
+    glDrawElements(GL_TRIANGLES, scene.floorIndices, scene.indexType, scene.floorOffset);
+    stats.stateChanges += 8; // The stencil test, program, VAO, model, stencil function, operation and mask, depth mask
+    stats.drawCalls += 1;
+    if(passQueries != nullptr)
+        glEndQuery(GL_TIME_ELAPSED);
+
+    // Draw the reflection of every cube, from the same instance data, mirrored in the vertex shader
+    if(passQueries != nullptr)
+        glBeginQuery(GL_TIME_ELAPSED, passQueries[2]);
+    glStencilFunc(GL_EQUAL, 1, 0xFF); // Pass test if stencil value is 1
+    glStencilMask(0x00); // Don't write anything to stencil buffer
+    glDepthMask(GL_TRUE); // Write to depth buffer
+
+    glUseProgram(field.program);
+    glBindVertexArray(field.vao);
+    glUniform1f(field.uniMirror, -1.0f);
+    glUniform3f(field.uniColor, 0.3f, 0.3f, 0.3f);
+    glDrawElementsInstanced(GL_TRIANGLES, scene.cubeIndices, scene.indexType, scene.cubeOffset, field.count);
+
+    glDisable(GL_STENCIL_TEST);
+    glUseProgram(scene.program);
+    glBindVertexArray(scene.vao);
+    stats.stateChanges += 10; // Stencil function and mask, depth mask, program and VAO twice, mirror, colour, the stencil test
+    stats.drawCalls += 1;
+    if(passQueries != nullptr)
+        glEndQuery(GL_TIME_ELAPSED);
+}
+
+void destroyCubeField(CubeField &field)
+{
+    glDeleteBuffers(1, &field.instances);
+    glDeleteVertexArrays(1, &field.vao);
+}
+
+void destroyScene(Scene &scene)
+{
+    glDeleteTextures(2, scene.textures);
+
+    glDeleteBuffers(1, &scene.vbo);
+
+    glDeleteVertexArrays(1, &scene.vao);
+}
+
+static void uploadMesh(Scene &scene, const MeshView &mesh)
+{
+    const MeshFileHeader &header = *mesh.header;
+    size_t indexOffset = header.vertexCount * sizeof(PackedVertex);
+
+    // Create a vertex buffer object to store vertex data; the indices share it, bound as
+    // the element buffer of the VAO
+    glGenBuffers(1, &scene.vbo); // Generate 1 buffer
+    glBindBuffer(GL_ARRAY_BUFFER, scene.vbo); // Prepare to write to vbo
+    glBufferData(GL_ARRAY_BUFFER, mesh.dataSize, mesh.data, GL_STATIC_DRAW); // Copy vertices and indices to vbo
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene.vbo);
+
+    scene.positionType = header.positionFormat == MESH_POSITION_SNORM16 ? GL_SHORT : GL_HALF_FLOAT;
+    scene.positionScale = header.positionScale;
+    scene.indexType = header.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    scene.cubeIndices = mesh.parts[0].indexCount;
+    scene.cubeOffset = (const void*)(indexOffset + (size_t)mesh.parts[0].firstIndex * header.indexSize);
+    scene.floorIndices = mesh.parts[1].indexCount;
+    scene.floorOffset = (const void*)(indexOffset + (size_t)mesh.parts[1].firstIndex * header.indexSize);
+}
+
+static void pointAttributes(const Scene &scene, GLuint program)
+{
+    // Get reference index of "position" attribute in shader program
+    // (-1 when a rebuilt shader no longer uses it, which leaves it alone)
+    GLint posAttrib = glGetAttribLocation(program, "position");
+    if(posAttrib >= 0)
+    {
+        // Enable the vertex attribute array for use
+        glEnableVertexAttribArray(posAttrib);
+        // Specify format of the "position" attribute in the array: 3 half floats, or 3
+        // snorm16 the driver turns into -1 to 1 and the shader scales back up
+        glVertexAttribPointer(posAttrib, 3, scene.positionType, scene.positionType == GL_SHORT, sizeof(PackedVertex),
+                              (void*)offsetof(PackedVertex, position));
+    }
+
+    // Prepare the color attribute, unorm8
+    GLint colAttrib = glGetAttribLocation(program, "color");
+    if(colAttrib >= 0)
+    {
+        glEnableVertexAttribArray(colAttrib);
+        glVertexAttribPointer(colAttrib, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, color));
+    }
+
+    // Prepare the texture coordinate attribute, unorm16
+    GLint texAttrib = glGetAttribLocation(program, "texcoord");
+    if(texAttrib >= 0)
+    {
+        glEnableVertexAttribArray(texAttrib);
+        glVertexAttribPointer(texAttrib, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texcoord));
+    }
+}
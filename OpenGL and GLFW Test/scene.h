@@ -0,0 +1,104 @@
+// Scene
+//
+// The spinning textured cube over a floor that reflects it, shared by the app and by
+// SceneBench. The reflection is the cube drawn again, mirrored under the floor and
+// darkened, only where the floor has marked the stencil buffer. A frame is drawn in
+// three passes (the cube, the floor, the reflection), each of which can be timed on
+// the GPU with a GL_TIME_ELAPSED query.
+//
+// The mesh is packed (mesh.h), 16 bytes a vertex, and indexed; it is either the
+// built-in cube and floor, packed at start-up, or a mesh baked by MeshBake, whose
+// first part is drawn as the cube and whose second is the floor. Either way its
+// vertices and indices go to the GPU in one buffer, in one upload. The same
+// mesh also draws a cube field, any number of small cubes spread over the floor,
+// each pass of which is a single instanced draw whatever the number of cubes. Every
+// cube's placement, spin and tint is one CubeInstance in a vertex buffer that
+// advances once per instance, and cubes.vert turns each cube by the time and mirrors
+// it under the floor for the reflection pass, so a frame uploads nothing per cube.
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "GL/glew.h"
+#include "GLM/glm.hpp"
+
+#define SCENE_PASSES 3 // The cube, the floor and the reflection, in drawing order
+#define CUBE_FIELD_DEFAULT 100000 // Cubes in a field when no number is given
+
+struct Scene
+{
+    GLuint vao;
+    GLuint vbo; // The packed vertices, then the indices; the array and element buffer both
+    GLenum positionType; // GL_HALF_FLOAT, or GL_SHORT for snorm16
+    float positionScale; // What the shaders multiply positions by
+    GLenum indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLsizei cubeIndices;
+    const void *cubeOffset; // Where the cube's indices start in vbo
+    GLsizei floorIndices;
+    const void *floorOffset;
+    GLuint textures[2]; // texOne and texTwo, on texture units 0 and 1
+    GLuint program; // The program set by useSceneProgram
+    GLint uniModel;
+    GLint uniColor; // overrideColor, which darkens the reflection
+    glm::mat4 view;
+    glm::mat4 proj;
+};
+
+// One cube of a cube field
+struct CubeInstance
+{
+    float x; // Its centre
+    float y;
+    float z;
+    float size; // Length of its edges
+    float phase; // Angle about the vertical at time 0, in radians
+    float speed; // Radians a second it turns by
+    unsigned char tint[4]; // Colour it multiplies its texture by, RGBA
+};
+
+struct CubeField
+{
+    int count; // Cubes in the field
+    GLuint instances; // A CubeInstance for each
+    GLuint vao; // The scene's mesh with the instances
+    GLuint program; // cubes.vert and shader.frag
+    GLint uniTime;
+    GLint uniMirror; // 1 for the cubes, -1 for their reflection
+    GLint uniColor;
+};
+
+// What drawing has cost the CPU side, added to by every drawScene
+struct SceneStats
+{
+    long long drawCalls;
+    long long stateChanges; // Capability, stencil, depth mask and uniform changes
+};
+
+// Create the buffers, and textures that show one white texel until the real images are
+// uploaded into them; aspect is the width of the viewport over its height. meshPath is
+// a .mesh file of at least two parts, or nullptr for the built-in cube and floor, which
+// are also drawn (after a message) if the file cannot be loaded.
+void initScene(Scene &scene, float aspect, const char *meshPath);
+
+// Draw with program from now on: connect its attributes, samplers and matrices. Called
+// again for every rebuilt program, whose locations may have moved.
+void useSceneProgram(Scene &scene, GLuint program);
+
+// Clear and draw one frame, time seconds into the animation. passQueries is either
+// nullptr or SCENE_PASSES query names, which each time one pass.
+void drawScene(Scene &scene, float time, const GLuint *passQueries, SceneStats &stats);
+
+void destroyScene(Scene &scene);
+
+// Spread count cubes over the floor in a square grid, drawn with program
+void initCubeField(Scene &scene, CubeField &field, int count, GLuint program);
+
+// Draw the field with program from now on, as useSceneProgram does for the scene
+void useCubeFieldProgram(Scene &scene, CubeField &field, GLuint program);
+
+// Draw a frame of the field in place of the one cube, with the same passes as drawScene
+void drawCubeField(Scene &scene, CubeField &field, float time, const GLuint *passQueries, SceneStats &stats);
+
+void destroyCubeField(CubeField &field);
+
+#endif // SCENE_H
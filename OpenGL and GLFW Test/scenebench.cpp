@@ -0,0 +1,420 @@
+// SceneBench
+//
+// Draws the app's scene (scene.h) for a fixed number of frames into an offscreen
+// framebuffer, with no window: the context is made through EGL on Mesa's surfaceless
+// platform when there is one, so it runs without a display server, and without a GPU
+// on llvmpipe. Run it from this directory, where the shaders and images are.
+//
+// At most SCENE_BENCH_IN_FLIGHT frames are queued at once, as a swap chain would allow.
+// For every frame it measures the CPU time spent in drawScene, the wall time from its
+// start to the next frame's start, and the GPU time of each pass (GL_TIME_ELAPSED),
+// and counts draw calls and state changes. One record per measurement is written,
+// with its mean, percentiles and maximum, as CSV or JSON lines.
+//
+// Usage: SceneBench [-frames N] [-warmup N] [-size WIDTHxHEIGHT] [-cubes N] [-mesh FILE] [-format csv|jsonl]
+//                   [-output FILE] [-label TEXT] [-image FILE]
+//      -frames - frames measured (default 1000)
+//      -warmup - frames drawn first and not measured (default 60)
+//      -size - the framebuffer size (default 800x600, the app's window)
+//      -cubes - draw a field of N instanced cubes in place of the one cube (default 0, the one cube)
+//      -mesh - draw a mesh baked by MeshBake in place of the cube and floor
+//      -format - csv (default) or jsonl, one JSON object per line
+//      -output - write to FILE instead of standard output
+//      -label - text copied into every record, such as the commit being measured
+//      -image - also save the last frame to FILE, as a binary PPM
+//
+// Build: g++ -O2 -std=c++11 -pthread -I"../Conway's Game of Life" scenebench.cpp scene.cpp shadercache.cpp
+//            texloader.cpp mesh.cpp "../Conway's Game of Life/mappedfile.cpp" -lGLEW -lSOIL -lEGL -lGL -o SceneBench
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GL/glew.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include "scene.h"
+#include "shadercache.h"
+#include "texloader.h"
+
+#define SCENE_BENCH_IN_FLIGHT 2 // Frames queued before the next one waits, like double buffering
+
+// The samples of one measurement, in milliseconds unless it is a count
+struct Series
+{
+    const char *name;
+    const char *unit;
+    std::vector<double> samples;
+};
+
+bool createContext(EGLDisplay &display, EGLContext &context);
+void writeSeries(FILE *output, bool json, const std::string &label, const std::string &renderer,
+                 int width, int height, int cubes, Series &series);
+std::string jsonString(const std::string &text);
+bool saveImage(const char *path, int width, int height);
+
+int main(int argc, char** argv)
+{
+    int frames = 1000, warmup = 60;
+    int width = 800, height = 600;
+    int cubeCount = 0;
+    bool json = false;
+    const char *outputPath = nullptr, *imagePath = nullptr, *meshPath = nullptr;
+    std::string label;
+    FILE *output = stdout;
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if(i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << option << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        if(option == "-frames")
+            frames = std::max(1, std::atoi(value.c_str()));
+        else if(option == "-warmup")
+            warmup = std::max(0, std::atoi(value.c_str()));
+        else if(option == "-size")
+        {
+            if(std::sscanf(value.c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+            {
+                std::cerr << "Bad size: " << value << std::endl;
+                return 1;
+            }
+        }
+        else if(option == "-cubes")
+            cubeCount = std::max(0, std::atoi(value.c_str()));
+        else if(option == "-mesh")
+            meshPath = argv[i];
+        else if(option == "-format")
+        {
+            if(value != "csv" && value != "jsonl")
+            {
+                std::cerr << "Unknown format: " << value << std::endl;
+                return 1;
+            }
+            json = value == "jsonl";
+        }
+        else if(option == "-output")
+            outputPath = argv[i];
+        else if(option == "-label")
+            label = value;
+        else if(option == "-image")
+            imagePath = argv[i];
+        else
+        {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return 1;
+        }
+    }
+
+    // Decode the textures while the context is set up, as the app does
+    TextureLoader textureLoader;
+    startTextureLoader(textureLoader, "cache", std::max(1, (int)std::thread::hardware_concurrency()));
+    requestTexture(textureLoader, "img/archery.jpg");
+    requestTexture(textureLoader, "img/moose.jpg");
+
+    EGLDisplay display;
+    EGLContext context;
+    if(!createContext(display, context))
+    {
+        std::cerr << "Failed to create an EGL context" << std::endl;
+        stopTextureLoader(textureLoader);
+        return 1;
+    }
+
+    // GLEW built for GLX finds no GLX display under EGL and says so, after it has
+    // loaded every function; only a failure before that matters here
+    glewExperimental = GL_TRUE;
+    GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if(glewStatus == GLEW_ERROR_NO_GLX_DISPLAY)
+        glewStatus = GLEW_OK;
+#endif
+    if(glewStatus != GLEW_OK)
+    {
+        std::cerr << "Failed to initialize GLEW" << std::endl;
+        stopTextureLoader(textureLoader);
+        return 1;
+    }
+    std::string renderer = (const char*)glGetString(GL_RENDERER);
+
+    // The offscreen framebuffer, with the depth and stencil buffers the scene needs
+    GLuint framebuffer, renderbuffers[2];
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "The offscreen framebuffer is incomplete" << std::endl;
+        stopTextureLoader(textureLoader);
+        return 1;
+    }
+    glViewport(0, 0, width, height);
+
+    Scene scene;
+    initScene(scene, (float)width / height, meshPath);
+    initTextureUploads(textureLoader);
+    GLuint shaderProgram = loadProgram("shader.vert", "shader.frag", "cache");
+    if(shaderProgram == 0)
+    {
+        stopTextureLoader(textureLoader);
+        return 1;
+    }
+    useSceneProgram(scene, shaderProgram);
+
+    CubeField field;
+    GLuint fieldProgram = 0;
+    if(cubeCount > 0)
+    {
+        fieldProgram = loadProgram("cubes.vert", "shader.frag", "cache");
+        if(fieldProgram == 0)
+        {
+            stopTextureLoader(textureLoader);
+            return 1;
+        }
+        initCubeField(scene, field, cubeCount, fieldProgram);
+    }
+
+    // Every frame is measured with the textures in place
+    while(pumpTextureLoader(textureLoader, scene.textures) > 0)
+        std::this_thread::yield();
+    stopTextureLoader(textureLoader);
+
+    // One set of pass queries and one fence for each frame that can be in flight
+    GLuint queries[SCENE_BENCH_IN_FLIGHT][SCENE_PASSES];
+    GLsync fences[SCENE_BENCH_IN_FLIGHT] = {};
+    int queued[SCENE_BENCH_IN_FLIGHT]; // The frame each slot was last used for, or -1
+    glGenQueries(SCENE_BENCH_IN_FLIGHT * SCENE_PASSES, &queries[0][0]);
+    std::fill(queued, queued + SCENE_BENCH_IN_FLIGHT, -1);
+
+    Series cpuTime = { "cpu_frame", "ms", {} };
+    Series frameTime = { "frame_interval", "ms", {} };
+    Series passTimes[SCENE_PASSES] = { { "gpu_cube", "ms", {} }, { "gpu_floor", "ms", {} }, { "gpu_reflection", "ms", {} } };
+    Series gpuTime = { "gpu_frame", "ms", {} };
+    Series drawCalls = { "draw_calls", "count", {} };
+    Series stateChanges = { "state_changes", "count", {} };
+
+    // Wait for the frame in a slot, and keep its pass times if it was measured
+    auto retire = [&](int slot)
+    {
+        if(queued[slot] < 0)
+            return;
+        glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(fences[slot]);
+        if(queued[slot] >= warmup)
+        {
+            double total = 0;
+            for(int pass = 0; pass < SCENE_PASSES; pass++)
+            {
+                GLuint64 nanoseconds;
+                glGetQueryObjectui64v(queries[slot][pass], GL_QUERY_RESULT, &nanoseconds);
+                passTimes[pass].samples.push_back(nanoseconds / 1e6);
+                total += nanoseconds / 1e6;
+            }
+            gpuTime.samples.push_back(total);
+        }
+        queued[slot] = -1;
+    };
+
+    auto t_previous = std::chrono::high_resolution_clock::now();
+    for(int frame = 0; frame < warmup + frames; frame++)
+    {
+        int slot = frame % SCENE_BENCH_IN_FLIGHT;
+        retire(slot);
+
+        // The animation advances at 60 frames a second, whatever the frames really take
+        auto t_start = std::chrono::high_resolution_clock::now();
+        SceneStats stats = { 0, 0 };
+        if(cubeCount > 0)
+            drawCubeField(scene, field, frame / 60.0f, queries[slot], stats);
+        else
+            drawScene(scene, frame / 60.0f, queries[slot], stats);
+        auto t_issued = std::chrono::high_resolution_clock::now();
+        fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        queued[slot] = frame;
+        glFlush();
+
+        if(frame > warmup)
+            frameTime.samples.push_back(std::chrono::duration<double, std::milli>(t_start - t_previous).count());
+        if(frame >= warmup)
+        {
+            cpuTime.samples.push_back(std::chrono::duration<double, std::milli>(t_issued - t_start).count());
+            drawCalls.samples.push_back((double)stats.drawCalls);
+            stateChanges.samples.push_back((double)stats.stateChanges);
+        }
+        t_previous = t_start;
+    }
+    for(int slot = 0; slot < SCENE_BENCH_IN_FLIGHT; slot++)
+        retire(slot);
+
+    if(imagePath != nullptr && !saveImage(imagePath, width, height))
+        std::cerr << "Failed to write " << imagePath << std::endl;
+
+    if(outputPath != nullptr)
+    {
+        output = std::fopen(outputPath, "w");
+        if(output == nullptr)
+        {
+            std::cerr << "Failed to open " << outputPath << " for writing" << std::endl;
+            return 1;
+        }
+    }
+    if(!json)
+        std::fprintf(output, "label,renderer,width,height,cubes,metric,unit,samples,mean,p50,p90,p99,max\n");
+    Series *all[] = { &cpuTime, &frameTime, &passTimes[0], &passTimes[1], &passTimes[2], &gpuTime, &drawCalls, &stateChanges };
+    for(Series *series : all)
+        writeSeries(output, json, label, renderer, width, height, std::max(cubeCount, 1), *series);
+    if(output != stdout)
+        std::fclose(output);
+
+    glDeleteQueries(SCENE_BENCH_IN_FLIGHT * SCENE_PASSES, &queries[0][0]);
+    glDeleteProgram(shaderProgram);
+    if(cubeCount > 0)
+    {
+        destroyCubeField(field);
+        glDeleteProgram(fieldProgram);
+    }
+    destroyScene(scene);
+    glDeleteRenderbuffers(2, renderbuffers);
+    glDeleteFramebuffers(1, &framebuffer);
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+    return 0;
+}
+
+bool createContext(EGLDisplay &display, EGLContext &context)
+{
+    // Prefer the surfaceless platform, which needs neither a display server nor a GPU
+    display = EGL_NO_DISPLAY;
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if(getPlatformDisplay != nullptr)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+#endif
+    if(display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+    if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+        return false;
+
+    // The same context the app asks GLFW for; it draws into a framebuffer object, never a surface
+    const EGLint configAttributes[] =
+    {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    const EGLint contextAttributes[] =
+    {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE, EGL_TRUE,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configs = 0;
+    if(!eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs < 1)
+        return false;
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if(context == EGL_NO_CONTEXT)
+        return false;
+    return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_TRUE;
+}
+
+void writeSeries(FILE *output, bool json, const std::string &label, const std::string &renderer,
+                 int width, int height, int cubes, Series &series)
+{
+    std::vector<double> &samples = series.samples;
+    size_t count = samples.size();
+    double mean = 0, p50 = 0, p90 = 0, p99 = 0, most = 0;
+
+    // Nearest-rank percentiles
+    if(count > 0)
+    {
+        std::sort(samples.begin(), samples.end());
+        for(size_t i = 0; i < count; i++)
+            mean += samples[i];
+        mean /= count;
+        p50 = samples[(count * 50 + 99) / 100 - 1];
+        p90 = samples[(count * 90 + 99) / 100 - 1];
+        p99 = samples[(count * 99 + 99) / 100 - 1];
+        most = samples[count - 1];
+    }
+
+    if(json)
+    {
+        std::fprintf(output, "{\"label\":%s,\"renderer\":%s,\"width\":%d,\"height\":%d,\"cubes\":%d,\"metric\":\"%s\",\"unit\":\"%s\","
+                             "\"samples\":%zu,\"mean\":%.6g,\"p50\":%.6g,\"p90\":%.6g,\"p99\":%.6g,\"max\":%.6g}\n",
+                     jsonString(label).c_str(), jsonString(renderer).c_str(), width, height, cubes, series.name, series.unit,
+                     count, mean, p50, p90, p99, most);
+    }
+    else
+    {
+        // Labels and renderer names are free text, so commas would break the columns
+        std::string labelColumn = label, rendererColumn = renderer;
+        std::replace(labelColumn.begin(), labelColumn.end(), ',', ';');
+        std::replace(rendererColumn.begin(), rendererColumn.end(), ',', ';');
+        std::fprintf(output, "%s,%s,%d,%d,%d,%s,%s,%zu,%.6g,%.6g,%.6g,%.6g,%.6g\n",
+                     labelColumn.c_str(), rendererColumn.c_str(), width, height, cubes, series.name, series.unit,
+                     count, mean, p50, p90, p99, most);
+    }
+}
+
+std::string jsonString(const std::string &text)
+{
+    std::string quoted = "\"";
+
+    for(size_t i = 0; i < text.size(); i++)
+    {
+        unsigned char c = (unsigned char)text[i];
+        if(c == '"' || c == '\\')
+        {
+            quoted += '\\';
+            quoted += (char)c;
+        }
+        else if(c < 0x20)
+        {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            quoted += escape;
+        }
+        else
+            quoted += (char)c;
+    }
+    return quoted + "\"";
+}
+
+bool saveImage(const char *path, int width, int height)
+{
+    std::vector<unsigned char> pixels((size_t)width * height * 3);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    FILE *file = std::fopen(path, "wb");
+    if(file == nullptr)
+        return false;
+    std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+    // GL rows run bottom to top, PPM rows top to bottom
+    for(int y = height - 1; y >= 0; y--)
+        std::fwrite(&pixels[(size_t)y * width * 3], 1, (size_t)width * 3, file);
+    return std::fclose(file) == 0;
+}
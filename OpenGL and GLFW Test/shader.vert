@@ -11,10 +11,11 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 proj;
 uniform vec3 overrideColor;
+uniform float positionScale; // Packed positions are fractions of it
 
 void main()
 {
     Color = overrideColor * color;
     Texcoord = texcoord;
-    gl_Position = proj * view * model * vec4(position, 1.0);
+    gl_Position = proj * view * model * vec4(positionScale * position, 1.0);
 }
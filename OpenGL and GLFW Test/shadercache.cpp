@@ -0,0 +1,359 @@
+#include "shadercache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+#ifdef _WIN32
+#include <direct.h>
+#endif
+#include "mappedfile.h"
+
+static_assert(sizeof(ProgramCacheHeader) == 32, "the cache header is written as it is laid out in memory");
+
+static uint64_t hashBytes(uint64_t hash, const char *data, size_t length);
+static uint64_t programKey(const std::string &vertexSource, const std::string &fragmentSource);
+static std::string cachePathFor(const std::string &cacheDirectory, const std::string &vertexPath,
+                                const std::string &fragmentPath);
+static GLuint readCachedProgram(const std::string &cachePath, uint64_t key);
+static void writeCachedProgram(const std::string &cacheDirectory, const std::string &cachePath, uint64_t key,
+                               GLuint program);
+static void startBuild(ProgramBuild &build, const std::string &vertexSource, const std::string &fragmentSource);
+static bool buildReady(const ProgramBuild &build);
+static GLuint finishBuild(ProgramBuild &build);
+
+std::string readFile(const char *filePath)
+{
+    std::ifstream fileStream(filePath, std::ios::in | std::ios::binary);
+
+    if(!fileStream.is_open())
+    {
+        std::cout << "Failed to open file: " << filePath << std::endl;
+        return "";
+    }
+
+    // Read the file in one go rather than a line at a time
+    std::ostringstream fileContents;
+    fileContents << fileStream.rdbuf();
+    return fileContents.str();
+}
+
+GLuint loadProgram(const char *vertexPath, const char *fragmentPath, const char *cacheDirectory)
+{
+    std::string vertexSource = readFile(vertexPath);
+    std::string fragmentSource = readFile(fragmentPath);
+    uint64_t key = programKey(vertexSource, fragmentSource);
+    std::string cachePath = cachePathFor(cacheDirectory, vertexPath, fragmentPath);
+
+    GLuint program = readCachedProgram(cachePath, key);
+    if(program != 0)
+        return program;
+
+    ProgramBuild build;
+    build.vertexPath = vertexPath;
+    build.fragmentPath = fragmentPath;
+    build.key = key;
+    std::cout << "Compiling " << vertexPath << " and " << fragmentPath << ".\n";
+    startBuild(build, vertexSource, fragmentSource);
+    program = finishBuild(build);
+    if(program != 0)
+        writeCachedProgram(cacheDirectory, cachePath, key, program);
+    return program;
+}
+
+void startShaderWatch(ShaderWatch &watch, const char *vertexPath, const char *fragmentPath,
+                      const char *cacheDirectory)
+{
+    watch.vertexPath = vertexPath;
+    watch.fragmentPath = fragmentPath;
+    watch.cacheDirectory = cacheDirectory;
+    watch.changed = false;
+    watch.building = false;
+
+    // Let the driver compile on threads of its own, so pollShaderWatch never waits on it
+    if(GLEW_ARB_parallel_shader_compile)
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+
+    const std::string *paths[2] = { &watch.vertexPath, &watch.fragmentPath };
+#ifdef __linux__
+    // Editors often save by writing a new file and renaming it over the old one, so
+    // watch the directories and pick the sources out by name
+    watch.notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    for(int i = 0; i < 2; i++)
+    {
+        size_t slash = paths[i]->find_last_of('/');
+        std::string directory = slash == std::string::npos ? "." : paths[i]->substr(0, slash + 1);
+        watch.watches[i] = watch.notify < 0 ? -1 :
+                           inotify_add_watch(watch.notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    }
+    if(watch.notify < 0)
+        std::cout << "Failed to watch the shader sources\n";
+#else
+    watch.times.assign(2, 0);
+    for(int i = 0; i < 2; i++)
+    {
+        struct stat source;
+        if(stat(paths[i]->c_str(), &source) == 0)
+            watch.times[i] = source.st_mtime;
+    }
+#endif
+}
+
+GLuint pollShaderWatch(ShaderWatch &watch)
+{
+    const std::string *paths[2] = { &watch.vertexPath, &watch.fragmentPath };
+#ifdef __linux__
+    if(watch.notify >= 0)
+    {
+        alignas(struct inotify_event) char buffer[4096];
+        ssize_t length;
+        while((length = read(watch.notify, buffer, sizeof(buffer))) > 0)
+        {
+            for(char *next = buffer; next < buffer + length; next += sizeof(struct inotify_event) + ((struct inotify_event*)next)->len)
+            {
+                const struct inotify_event *event = (const struct inotify_event*)next;
+                for(int i = 0; i < 2; i++)
+                {
+                    size_t slash = paths[i]->find_last_of('/');
+                    const char *name = paths[i]->c_str() + (slash == std::string::npos ? 0 : slash + 1);
+                    if(event->wd == watch.watches[i] && event->len > 0 && std::strcmp(event->name, name) == 0)
+                        watch.changed = true;
+                }
+            }
+        }
+    }
+#else
+    for(int i = 0; i < 2; i++)
+    {
+        struct stat source;
+        if(stat(paths[i]->c_str(), &source) == 0 && source.st_mtime != watch.times[i])
+        {
+            watch.times[i] = source.st_mtime;
+            watch.changed = true;
+        }
+    }
+#endif
+
+    // Saves that land while a build is under way start another one after it
+    if(watch.changed && !watch.building)
+    {
+        std::string vertexSource = readFile(watch.vertexPath.c_str());
+        std::string fragmentSource = readFile(watch.fragmentPath.c_str());
+        watch.changed = false;
+        watch.build.vertexPath = watch.vertexPath;
+        watch.build.fragmentPath = watch.fragmentPath;
+        watch.build.key = programKey(vertexSource, fragmentSource);
+        std::cout << "Rebuilding " << watch.vertexPath << " and " << watch.fragmentPath << ".\n";
+        startBuild(watch.build, vertexSource, fragmentSource);
+        watch.building = true;
+    }
+    if(!watch.building || !buildReady(watch.build))
+        return 0;
+
+    watch.building = false;
+    GLuint program = finishBuild(watch.build);
+    if(program != 0)
+        writeCachedProgram(watch.cacheDirectory, cachePathFor(watch.cacheDirectory, watch.vertexPath, watch.fragmentPath),
+                           watch.build.key, program);
+    return program;
+}
+
+void stopShaderWatch(ShaderWatch &watch)
+{
+    if(watch.building)
+    {
+        glDeleteShader(watch.build.shaders[0]);
+        glDeleteShader(watch.build.shaders[1]);
+        glDeleteProgram(watch.build.program);
+        watch.building = false;
+    }
+#ifdef __linux__
+    if(watch.notify >= 0)
+        close(watch.notify);
+    watch.notify = -1;
+#endif
+}
+
+static uint64_t hashBytes(uint64_t hash, const char *data, size_t length)
+{
+    // 64-bit FNV-1a
+    for(size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t programKey(const std::string &vertexSource, const std::string &fragmentSource)
+{
+    const GLenum driver[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    uint64_t key = 14695981039346656037ULL;
+
+    // Each string is hashed with its terminator, so moving text from one to the next changes the key
+    key = hashBytes(key, vertexSource.c_str(), vertexSource.size() + 1);
+    key = hashBytes(key, fragmentSource.c_str(), fragmentSource.size() + 1);
+    for(int i = 0; i < 3; i++)
+    {
+        const char *name = (const char*)glGetString(driver[i]);
+        if(name != nullptr)
+            key = hashBytes(key, name, std::strlen(name) + 1);
+    }
+    return key;
+}
+
+static std::string cachePathFor(const std::string &cacheDirectory, const std::string &vertexPath,
+                                const std::string &fragmentPath)
+{
+    std::string name = vertexPath + "+" + fragmentPath + ".program";
+    std::replace(name.begin(), name.end(), '/', '_');
+    std::replace(name.begin(), name.end(), '\\', '_');
+    std::replace(name.begin(), name.end(), ':', '_');
+    return cacheDirectory + "/" + name;
+}
+
+static GLuint readCachedProgram(const std::string &cachePath, uint64_t key)
+{
+    MappedFile file;
+    ProgramCacheHeader header;
+    GLuint program = 0;
+
+    if(!GLEW_ARB_get_program_binary || !mapFile(cachePath.c_str(), file))
+        return 0;
+    if(file.size >= sizeof(header))
+    {
+        std::memcpy(&header, file.data, sizeof(header));
+        if(std::memcmp(header.magic, "PROGBIN", 8) == 0 && header.version == PROGRAM_CACHE_VERSION &&
+           header.key == key && file.size == sizeof(header) + header.length)
+        {
+            // The driver may still turn the binary down, after an update that kept its version string
+            GLint status;
+            program = glCreateProgram();
+            glProgramBinary(program, header.format, file.data + sizeof(header), header.length);
+            glGetProgramiv(program, GL_LINK_STATUS, &status);
+            if(status != GL_TRUE)
+            {
+                glDeleteProgram(program);
+                program = 0;
+            }
+        }
+    }
+    unmapFile(file);
+    return program;
+}
+
+static void writeCachedProgram(const std::string &cacheDirectory, const std::string &cachePath, uint64_t key,
+                               GLuint program)
+{
+    ProgramCacheHeader header;
+    GLint length = 0;
+    GLenum format;
+    std::string temporary = cachePath + ".tmp"; // Written first, so a reader never maps half a file
+
+    if(!GLEW_ARB_get_program_binary)
+        return;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0)
+        return;
+    std::vector<char> binary(length);
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+#ifdef _WIN32
+    _mkdir(cacheDirectory.c_str());
+#else
+    mkdir(cacheDirectory.c_str(), 0755);
+#endif
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "PROGBIN", 8);
+    header.version = PROGRAM_CACHE_VERSION;
+    header.format = format;
+    header.key = key;
+    header.length = length;
+
+    FILE *file = std::fopen(temporary.c_str(), "wb");
+    if(file == nullptr)
+        return;
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(binary.data(), 1, length, file) == (size_t)length;
+    if(std::fclose(file) != 0 || !written)
+    {
+        std::remove(temporary.c_str());
+        return;
+    }
+    std::remove(cachePath.c_str()); // rename will not replace a file on Windows
+    std::rename(temporary.c_str(), cachePath.c_str());
+}
+
+static void startBuild(ProgramBuild &build, const std::string &vertexSource, const std::string &fragmentSource)
+{
+    const char *sources[2] = { vertexSource.c_str(), fragmentSource.c_str() };
+
+    build.shaders[0] = glCreateShader(GL_VERTEX_SHADER);
+    build.shaders[1] = glCreateShader(GL_FRAGMENT_SHADER);
+    for(int i = 0; i < 2; i++)
+    {
+        glShaderSource(build.shaders[i], 1, &sources[i], NULL);
+        glCompileShader(build.shaders[i]);
+    }
+
+    // Link without looking at the compile results, which would wait for the compiler
+    build.program = glCreateProgram();
+    glBindFragDataLocation(build.program, 0, "outColor");
+    if(GLEW_ARB_get_program_binary)
+        glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glAttachShader(build.program, build.shaders[0]);
+    glAttachShader(build.program, build.shaders[1]);
+    glLinkProgram(build.program);
+}
+
+static bool buildReady(const ProgramBuild &build)
+{
+    // Without ARB_parallel_shader_compile the build is finished here and now, however long that takes
+    if(!GLEW_ARB_parallel_shader_compile)
+        return true;
+    GLint done;
+    glGetProgramiv(build.program, GL_COMPLETION_STATUS_ARB, &done);
+    return done == GL_TRUE;
+}
+
+static GLuint finishBuild(ProgramBuild &build)
+{
+    const std::string *paths[2] = { &build.vertexPath, &build.fragmentPath };
+    GLint status;
+    bool compiled = true;
+
+    for(int i = 0; i < 2; i++)
+    {
+        glGetShaderiv(build.shaders[i], GL_COMPILE_STATUS, &status);
+        if(status != GL_TRUE)
+        {
+            std::cout << "Failed to compile " << *paths[i] << "!\n";
+            char buffer[512];
+            glGetShaderInfoLog(build.shaders[i], 512, NULL, buffer);
+            std::cout << buffer;
+            compiled = false;
+        }
+        glDeleteShader(build.shaders[i]); // Only flagged; it goes with the program
+    }
+
+    glGetProgramiv(build.program, GL_LINK_STATUS, &status);
+    if(compiled && status != GL_TRUE)
+    {
+        std::cout << "Failed to link " << build.vertexPath << " and " << build.fragmentPath << "!\n";
+        char buffer[512];
+        glGetProgramInfoLog(build.program, 512, NULL, buffer);
+        std::cout << buffer;
+    }
+    if(!compiled || status != GL_TRUE)
+    {
+        glDeleteProgram(build.program);
+        return 0;
+    }
+    return build.program;
+}
@@ -0,0 +1,82 @@
+// Shader program cache
+//
+// Links a vertex and a fragment shader into a program, and keeps the linked binary
+// (glGetProgramBinary) in the cache directory, so later runs hand it straight back to
+// the driver instead of compiling and linking the sources again. A cached binary is
+// keyed by a hash of both sources and of the driver's vendor, renderer and version
+// strings; when the key differs, or the driver rejects the binary, the program is
+// built from source and the cache rewritten. Drivers without ARB_get_program_binary
+// always build from source.
+//
+// A ShaderWatch rebuilds a program whenever one of its sources is saved (through
+// inotify on Linux, by polling modification times elsewhere). The rebuild runs
+// alongside rendering where the driver has ARB_parallel_shader_compile, and the new
+// program is only handed over once it has linked, so the old one keeps drawing in the
+// meantime and keeps drawing for good if the edit does not compile.
+
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "GL/glew.h"
+
+#define PROGRAM_CACHE_VERSION 1
+
+// The start of a cached program file; the binary follows it
+struct ProgramCacheHeader
+{
+    char magic[8]; // "PROGBIN"
+    uint32_t version; // PROGRAM_CACHE_VERSION
+    uint32_t format; // The binary format glGetProgramBinary reported
+    uint64_t key; // Hash of the sources and the driver strings
+    uint32_t length; // Bytes of binary that follow
+    uint32_t unused;
+};
+
+// A program being compiled and linked from source
+struct ProgramBuild
+{
+    std::string vertexPath;
+    std::string fragmentPath;
+    uint64_t key; // What the binary is cached under
+    GLuint shaders[2]; // Vertex, fragment
+    GLuint program;
+};
+
+struct ShaderWatch
+{
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::string cacheDirectory;
+#ifdef __linux__
+    int notify; // The inotify descriptor, or -1
+    int watches[2]; // Its watch on the directory of each source
+#else
+    std::vector<time_t> times; // Last seen modification time of each source
+#endif
+    bool changed; // A source was saved since the last build started
+    bool building; // Whether build is under way
+    ProgramBuild build;
+};
+
+// Read a whole text file; prints a message and returns "" if it cannot be opened
+std::string readFile(const char *filePath);
+
+// Load a program, from the cache if it can be, otherwise from source (and cache it).
+// Returns 0, after printing the log, if the sources do not compile or link.
+GLuint loadProgram(const char *vertexPath, const char *fragmentPath, const char *cacheDirectory);
+
+// Start watching the sources of a program loaded with loadProgram
+void startShaderWatch(ShaderWatch &watch, const char *vertexPath, const char *fragmentPath,
+                      const char *cacheDirectory);
+
+// Call once a frame. Returns the rebuilt program once a saved edit has linked, and 0 otherwise;
+// the caller switches to it and deletes the old one.
+GLuint pollShaderWatch(ShaderWatch &watch);
+
+void stopShaderWatch(ShaderWatch &watch);
+
+#endif // SHADERCACHE_H
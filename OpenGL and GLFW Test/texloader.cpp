@@ -0,0 +1,359 @@
+#include "texloader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+#include "SOIL/SOIL.h"
+
+static_assert(sizeof(TextureCacheHeader) == 40, "the cache header is written as it is laid out in memory");
+
+static std::mutex decodeLock; // Held around every SOIL_load_image
+
+static void workerLoop(TextureLoader *loader);
+static void loadTexture(const std::string &cacheDirectory, LoadedTexture &texture);
+static bool readCache(const std::string &cachePath, const struct stat &source, LoadedTexture &texture);
+static void writeCache(const std::string &cacheDirectory, const std::string &cachePath, const struct stat &source,
+                       const LoadedTexture &texture);
+static void buildMipmaps(LoadedTexture &texture, const unsigned char *image);
+static size_t chainBytes(int width, int height, int levels);
+static size_t reserveRing(TextureLoader &loader, size_t bytes);
+static void uploadTexture(TextureLoader &loader, const LoadedTexture &texture, GLuint name);
+static void releaseTexture(LoadedTexture *texture);
+
+void startTextureLoader(TextureLoader &loader, const char *cacheDirectory, int threads)
+{
+    loader.cacheDirectory = cacheDirectory;
+    loader.stopping = false;
+    loader.requested = 0;
+    loader.uploaded = 0;
+    loader.ring = 0;
+    loader.ringMemory = nullptr;
+    loader.ringHead = 0;
+    for(int i = 0; i < std::max(threads, 1); i++)
+        loader.workers.push_back(std::thread(workerLoop, &loader));
+}
+
+int requestTexture(TextureLoader &loader, const char *path)
+{
+    LoadedTexture *texture = new LoadedTexture();
+    texture->index = loader.requested++;
+    texture->path = path;
+    texture->failed = false;
+    texture->fromCache = false;
+    texture->cached.data = nullptr;
+    texture->cached.size = 0;
+    texture->cached.mapped = false;
+    texture->data = nullptr;
+    {
+        std::lock_guard<std::mutex> hold(loader.lock);
+        loader.jobs.push_back(texture);
+    }
+    loader.wake.notify_one();
+    return texture->index;
+}
+
+void initTextureUploads(TextureLoader &loader)
+{
+    // A persistent mapping needs GL 4.4 or ARB_buffer_storage; without it, images are uploaded from memory
+    if(!GLEW_ARB_buffer_storage)
+        return;
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &loader.ring);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, loader.ring);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, TEXTURE_RING_BYTES, nullptr, flags);
+    loader.ringMemory = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, TEXTURE_RING_BYTES, flags);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if(loader.ringMemory == nullptr)
+    {
+        glDeleteBuffers(1, &loader.ring);
+        loader.ring = 0;
+    }
+}
+
+int pumpTextureLoader(TextureLoader &loader, const GLuint *textures)
+{
+    std::deque<LoadedTexture*> ready;
+
+    {
+        std::lock_guard<std::mutex> hold(loader.lock);
+        ready.swap(loader.finished);
+    }
+    for(size_t i = 0; i < ready.size(); i++)
+    {
+        if(ready[i]->failed)
+            std::cout << "Failed to load texture: " << ready[i]->path << std::endl;
+        else
+            uploadTexture(loader, *ready[i], textures[ready[i]->index]);
+        releaseTexture(ready[i]);
+        loader.uploaded++;
+    }
+    return loader.requested - loader.uploaded;
+}
+
+void stopTextureLoader(TextureLoader &loader)
+{
+    {
+        std::lock_guard<std::mutex> hold(loader.lock);
+        loader.stopping = true;
+    }
+    loader.wake.notify_all();
+    for(size_t i = 0; i < loader.workers.size(); i++)
+        loader.workers[i].join();
+    loader.workers.clear();
+
+    for(size_t i = 0; i < loader.jobs.size(); i++)
+        releaseTexture(loader.jobs[i]);
+    for(size_t i = 0; i < loader.finished.size(); i++)
+        releaseTexture(loader.finished[i]);
+    loader.jobs.clear();
+    loader.finished.clear();
+
+    if(loader.ring != 0)
+    {
+        for(size_t i = 0; i < loader.ringFences.size(); i++)
+            glDeleteSync(loader.ringFences[i].fence);
+        loader.ringFences.clear();
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, loader.ring);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &loader.ring);
+        loader.ring = 0;
+        loader.ringMemory = nullptr;
+    }
+}
+
+static void workerLoop(TextureLoader *loader)
+{
+    for(;;)
+    {
+        LoadedTexture *texture;
+        {
+            std::unique_lock<std::mutex> hold(loader->lock);
+            loader->wake.wait(hold, [&]{ return loader->stopping || !loader->jobs.empty(); });
+            if(loader->stopping)
+                return;
+            texture = loader->jobs.front();
+            loader->jobs.pop_front();
+        }
+
+        loadTexture(loader->cacheDirectory, *texture);
+
+        std::lock_guard<std::mutex> hold(loader->lock);
+        loader->finished.push_back(texture);
+    }
+}
+
+static void loadTexture(const std::string &cacheDirectory, LoadedTexture &texture)
+{
+    struct stat source;
+    if(stat(texture.path.c_str(), &source) != 0)
+    {
+        texture.failed = true;
+        return;
+    }
+
+    // One cache file per source, named after its path
+    std::string cachePath = cacheDirectory + "/" + texture.path + ".tex";
+    std::replace(cachePath.begin() + cacheDirectory.size() + 1, cachePath.end(), '/', '_');
+    std::replace(cachePath.begin() + cacheDirectory.size() + 1, cachePath.end(), '\\', '_');
+    std::replace(cachePath.begin() + cacheDirectory.size() + 1, cachePath.end(), ':', '_');
+    if(readCache(cachePath, source, texture))
+        return;
+
+    // SOIL is not thread-safe (a global error string, and stb_image's lazily built tables), so
+    // only one worker decodes at a time; cache reads and mipmaps still run in parallel
+    unsigned char *image;
+    {
+        std::lock_guard<std::mutex> hold(decodeLock);
+        image = SOIL_load_image(texture.path.c_str(), &texture.width, &texture.height, 0, SOIL_LOAD_RGBA);
+    }
+    if(image == nullptr)
+    {
+        texture.failed = true;
+        return;
+    }
+    buildMipmaps(texture, image);
+    SOIL_free_image_data(image);
+    writeCache(cacheDirectory, cachePath, source, texture);
+}
+
+static bool readCache(const std::string &cachePath, const struct stat &source, LoadedTexture &texture)
+{
+    TextureCacheHeader header;
+
+    if(!mapFile(cachePath.c_str(), texture.cached))
+        return false;
+    if(texture.cached.size >= sizeof(header))
+    {
+        std::memcpy(&header, texture.cached.data, sizeof(header));
+        int levels = 1;
+        while((header.width >> levels) > 0 || (header.height >> levels) > 0)
+            levels++;
+        if(std::memcmp(header.magic, "TEXCACHE", 8) == 0 && header.version == TEXTURE_CACHE_VERSION &&
+           header.sourceSize == (uint64_t)source.st_size && header.sourceTime == (int64_t)source.st_mtime &&
+           header.width > 0 && header.height > 0 && header.levels == (uint32_t)levels &&
+           texture.cached.size == sizeof(header) + chainBytes(header.width, header.height, levels))
+        {
+            texture.fromCache = true;
+            texture.width = header.width;
+            texture.height = header.height;
+            texture.levels = levels;
+            texture.data = (const unsigned char*)texture.cached.data + sizeof(header);
+            return true;
+        }
+    }
+    // Stale or damaged: decode the source again, which also replaces the file
+    unmapFile(texture.cached);
+    return false;
+}
+
+static void writeCache(const std::string &cacheDirectory, const std::string &cachePath, const struct stat &source,
+                       const LoadedTexture &texture)
+{
+    TextureCacheHeader header;
+    std::string temporary = cachePath + ".tmp"; // Written first, so a reader never maps half a file
+
+#ifdef _WIN32
+    _mkdir(cacheDirectory.c_str());
+#else
+    mkdir(cacheDirectory.c_str(), 0755);
+#endif
+    std::memcpy(header.magic, "TEXCACHE", 8);
+    header.version = TEXTURE_CACHE_VERSION;
+    header.width = texture.width;
+    header.height = texture.height;
+    header.levels = texture.levels;
+    header.sourceSize = source.st_size;
+    header.sourceTime = source.st_mtime;
+
+    FILE *file = std::fopen(temporary.c_str(), "wb");
+    if(file == nullptr)
+        return;
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(texture.pixels.data(), 1, texture.pixels.size(), file) == texture.pixels.size();
+    if(std::fclose(file) != 0 || !written)
+    {
+        std::remove(temporary.c_str());
+        return;
+    }
+    std::remove(cachePath.c_str()); // rename will not replace a file on Windows
+    std::rename(temporary.c_str(), cachePath.c_str());
+}
+
+static void buildMipmaps(LoadedTexture &texture, const unsigned char *image)
+{
+    int width = texture.width, height = texture.height;
+
+    texture.levels = 1;
+    while((width >> texture.levels) > 0 || (height >> texture.levels) > 0)
+        texture.levels++;
+    texture.pixels.resize(chainBytes(width, height, texture.levels));
+    std::memcpy(texture.pixels.data(), image, (size_t)width * height * 4);
+
+    // Each level is a 2x2 box filter of the one before; an odd last row or column is averaged with itself
+    unsigned char *above = texture.pixels.data();
+    for(int level = 1; level < texture.levels; level++)
+    {
+        int aboveWidth = width, aboveHeight = height;
+        unsigned char *below = above + (size_t)aboveWidth * aboveHeight * 4;
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        for(int y = 0; y < height; y++)
+        {
+            int y0 = std::min(2 * y, aboveHeight - 1), y1 = std::min(2 * y + 1, aboveHeight - 1);
+            for(int x = 0; x < width; x++)
+            {
+                int x0 = std::min(2 * x, aboveWidth - 1), x1 = std::min(2 * x + 1, aboveWidth - 1);
+                for(int c = 0; c < 4; c++)
+                {
+                    int sum = above[((size_t)y0 * aboveWidth + x0) * 4 + c] + above[((size_t)y0 * aboveWidth + x1) * 4 + c] +
+                              above[((size_t)y1 * aboveWidth + x0) * 4 + c] + above[((size_t)y1 * aboveWidth + x1) * 4 + c];
+                    below[((size_t)y * width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+        above = below;
+    }
+    texture.data = texture.pixels.data();
+}
+
+static size_t chainBytes(int width, int height, int levels)
+{
+    size_t bytes = 0;
+    for(int level = 0; level < levels; level++)
+        bytes += (size_t)std::max(width >> level, 1) * std::max(height >> level, 1) * 4;
+    return bytes;
+}
+
+static size_t reserveRing(TextureLoader &loader, size_t bytes)
+{
+    if(loader.ring == 0 || bytes > TEXTURE_RING_BYTES)
+        return (size_t)-1;
+
+    size_t begin = (loader.ringHead + bytes > TEXTURE_RING_BYTES) ? 0 : loader.ringHead;
+    size_t end = begin + bytes;
+
+    // Wait, oldest first, until no earlier upload still reads the part about to be written
+    for(;;)
+    {
+        bool overlaps = false;
+        for(size_t i = 0; i < loader.ringFences.size() && !overlaps; i++)
+            overlaps = loader.ringFences[i].begin < end && begin < loader.ringFences[i].end;
+        if(!overlaps)
+            break;
+        GLsync fence = loader.ringFences.front().fence;
+        while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+        {
+        }
+        glDeleteSync(fence);
+        loader.ringFences.pop_front();
+    }
+    loader.ringHead = end;
+    return begin;
+}
+
+static void uploadTexture(TextureLoader &loader, const LoadedTexture &texture, GLuint name)
+{
+    size_t bytes = chainBytes(texture.width, texture.height, texture.levels);
+    size_t offset = reserveRing(loader, bytes);
+    const unsigned char *source = texture.data;
+    GLint bound; // The texture bound to the active unit, put back afterwards
+
+    if(offset != (size_t)-1)
+    {
+        std::memcpy(loader.ringMemory + offset, texture.data, bytes);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, loader.ring);
+        source = (const unsigned char*)offset; // Offsets into the bound buffer from here on
+    }
+
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+    glBindTexture(GL_TEXTURE_2D, name);
+    for(int level = 0; level < texture.levels; level++)
+    {
+        int width = std::max(texture.width >> level, 1), height = std::max(texture.height >> level, 1);
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, source);
+        source += (size_t)width * height * 4;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, bound);
+
+    if(offset != (size_t)-1)
+    {
+        RingFence used = { glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), offset, offset + bytes };
+        loader.ringFences.push_back(used);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+}
+
+static void releaseTexture(LoadedTexture *texture)
+{
+    if(texture->fromCache)
+        unmapFile(texture->cached);
+    delete texture;
+}
@@ -0,0 +1,100 @@
+// Texture loader
+//
+// Decodes images on a pool of worker threads, so they can be requested before the
+// window exists and load while it comes up, and uploads each one as soon as it is
+// ready, with its whole mipmap chain. The render thread only ever copies finished
+// pixels: through one persistently mapped pixel buffer object, used as a ring, when
+// the driver has ARB_buffer_storage, and straight from memory otherwise.
+//
+// Every decoded image is also written to the cache directory, mipmaps included, as a
+// header followed by every level in RGBA. Later runs map the cached file and upload it
+// as it is, without decoding the source at all. A cached file is used only while the
+// source keeps the size and modification time recorded in its header.
+
+#ifndef TEXLOADER_H
+#define TEXLOADER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GL/glew.h"
+#include "mappedfile.h"
+
+#define TEXTURE_CACHE_VERSION 1
+#define TEXTURE_RING_BYTES (16 << 20) // Size of the upload ring; bigger images are uploaded from memory
+
+// The start of a cached texture file
+struct TextureCacheHeader
+{
+    char magic[8]; // "TEXCACHE"
+    uint32_t version; // TEXTURE_CACHE_VERSION
+    uint32_t width; // Of the largest level
+    uint32_t height;
+    uint32_t levels; // Mipmap levels that follow, largest first, each RGBA with rows packed tight
+    uint64_t sourceSize; // The source image the levels were made from
+    int64_t sourceTime; // Its modification time
+};
+
+// One image, decoded or mapped, waiting to be uploaded
+struct LoadedTexture
+{
+    int index; // What requestTexture returned for it
+    std::string path; // The source image
+    bool failed; // Whether it could be neither read from the cache nor decoded
+    bool fromCache; // Whether the levels come from the cache rather than a decode
+    int width; // Of the largest level
+    int height;
+    int levels;
+    std::vector<unsigned char> pixels; // The levels, after a decode
+    MappedFile cached; // The cached file, when read from the cache
+    const unsigned char *data; // The first level, in pixels or in cached
+};
+
+// A range of the upload ring still being read by the driver
+struct RingFence
+{
+    GLsync fence;
+    size_t begin;
+    size_t end;
+};
+
+struct TextureLoader
+{
+    std::string cacheDirectory; // Where cached textures are read from and written to
+    std::vector<std::thread> workers;
+    std::mutex lock; // Guards jobs, finished and stopping
+    std::condition_variable wake; // Signalled when a job is queued or the loader stops
+    std::deque<LoadedTexture*> jobs; // Requested, not yet picked up by a worker
+    std::deque<LoadedTexture*> finished; // Ready to upload
+    bool stopping;
+    int requested; // Render thread only: textures requested so far
+    int uploaded; // Render thread only: textures uploaded, or given up on, so far
+
+    GLuint ring; // The upload ring, or 0 to upload from memory
+    unsigned char *ringMemory; // Its persistent mapping
+    size_t ringHead; // Where the next upload is written
+    std::deque<RingFence> ringFences; // Uploads the driver may still be reading, oldest first
+};
+
+// Start the worker threads; threads is at least 1. Needs no GL context.
+void startTextureLoader(TextureLoader &loader, const char *cacheDirectory, int threads);
+
+// Queue an image for decoding; returns its index, counting from 0. Needs no GL context.
+int requestTexture(TextureLoader &loader, const char *path);
+
+// Set up the upload ring. Needs the GL context, and is called once before the first pump.
+void initTextureUploads(TextureLoader &loader);
+
+// Upload every image that has finished since the last call into textures[index], and
+// returns how many requested images are still on their way. Never waits for a decode.
+int pumpTextureLoader(TextureLoader &loader, const GLuint *textures);
+
+// Stop the workers, drop anything not yet uploaded and release the ring
+void stopTextureLoader(TextureLoader &loader);
+
+#endif // TEXLOADER_H
@@ -0,0 +1,82 @@
+#include "updater.h"
+#include <algorithm>
+
+static void updateLoop(Updater *updater);
+static void stepScene(SceneState &state, double seconds);
+
+void startUpdater(Updater &updater)
+{
+    SceneSnapshot first;
+    first.previous.step = 0;
+    first.previous.time = 0.0;
+    first.current = first.previous;
+    first.stepped = std::chrono::steady_clock::now();
+    initTripleBuffer(updater.snapshots, first);
+    updater.stopping = false;
+    updater.droppedSteps = 0;
+    updater.thread = std::thread(updateLoop, &updater);
+}
+
+SceneState sampleUpdater(Updater &updater)
+{
+    takeTripleBuffer(updater.snapshots);
+    const SceneSnapshot &snapshot = updater.snapshots.slots[updater.snapshots.front];
+
+    // Drawn one step behind: the blend reaches current just as the next step comes due
+    double into = std::chrono::duration<double>(std::chrono::steady_clock::now() - snapshot.stepped).count();
+    double blend = std::min(std::max(into / UPDATE_STEP_SECONDS, 0.0), 1.0);
+    SceneState state = snapshot.current;
+    state.time = snapshot.previous.time + (snapshot.current.time - snapshot.previous.time) * blend;
+    return state;
+}
+
+void stopUpdater(Updater &updater)
+{
+    updater.stopping = true;
+    updater.thread.join();
+}
+
+static void updateLoop(Updater *updater)
+{
+    const std::chrono::steady_clock::duration step =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(UPDATE_STEP_SECONDS));
+    SceneState state = { 0, 0.0 }, previous;
+    std::chrono::steady_clock::time_point due = updater->snapshots.slots[0].stepped + step;
+
+    while(!updater->stopping.load(std::memory_order_relaxed))
+    {
+        std::this_thread::sleep_until(due);
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        // Run every step that has come due; after a long stall, drop what cannot be caught up
+        int steps = 0;
+        while(due <= now && steps < UPDATE_MAX_CATCH_UP)
+        {
+            previous = state;
+            stepScene(state, UPDATE_STEP_SECONDS);
+            due += step;
+            steps++;
+        }
+        if(due <= now)
+        {
+            long long behind = (now - due) / step + 1;
+            updater->droppedSteps += behind;
+            due += behind * step;
+        }
+        if(steps == 0)
+            continue;
+
+        SceneSnapshot &snapshot = updater->snapshots.slots[updater->snapshots.back];
+        snapshot.previous = previous;
+        snapshot.current = state;
+        snapshot.stepped = due - step;
+        publishTripleBuffer(updater->snapshots);
+    }
+}
+
+static void stepScene(SceneState &state, double seconds)
+{
+    // Simulation work goes here; it only ever delays the next step, never a frame
+    state.step++;
+    state.time += seconds;
+}
@@ -0,0 +1,94 @@
+// Scene updater
+//
+// Advances the scene on a thread of its own, at a fixed step of UPDATE_STEP_SECONDS
+// whatever the frame rate, so simulation work never lands in a frame. Each step is
+// published through a triple buffer: the update thread fills one slot while the
+// render thread reads another, and the third holds the latest complete state between
+// them. Handing a slot over is a single atomic exchange on either side, so neither
+// thread ever waits for the other.
+//
+// Every published snapshot carries the state before the step as well as after it, and
+// the render thread draws a blend of the two according to how far it is into the next
+// step, so motion stays smooth when frames and steps do not line up.
+
+#ifndef UPDATER_H
+#define UPDATER_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#define UPDATE_STEP_SECONDS (1.0 / 120.0)
+#define UPDATE_MAX_CATCH_UP 8 // Steps run back to back after a stall, before the lost time is dropped
+
+// Three slots handed between one writer and one reader
+template<typename T>
+struct TripleBuffer
+{
+    T slots[3];
+    std::atomic<int> middle; // The slot between the two, plus TRIPLE_BUFFER_FRESH if the reader has not taken it
+    int back; // Writer only: the slot being filled
+    int front; // Reader only: the slot being read
+};
+
+#define TRIPLE_BUFFER_FRESH 4
+#define TRIPLE_BUFFER_SLOT 3
+
+template<typename T>
+void initTripleBuffer(TripleBuffer<T> &buffer, const T &value)
+{
+    for(int i = 0; i < 3; i++)
+        buffer.slots[i] = value;
+    buffer.front = 0;
+    buffer.middle.store(1);
+    buffer.back = 2;
+}
+
+// Writer: swap the filled back slot into the middle, taking the old middle to fill next
+template<typename T>
+void publishTripleBuffer(TripleBuffer<T> &buffer)
+{
+    buffer.back = buffer.middle.exchange(buffer.back | TRIPLE_BUFFER_FRESH, std::memory_order_acq_rel) & TRIPLE_BUFFER_SLOT;
+}
+
+// Reader: take the middle slot if something newer was published there; returns whether it was
+template<typename T>
+bool takeTripleBuffer(TripleBuffer<T> &buffer)
+{
+    if((buffer.middle.load(std::memory_order_acquire) & TRIPLE_BUFFER_FRESH) == 0)
+        return false;
+    buffer.front = buffer.middle.exchange(buffer.front, std::memory_order_acq_rel) & TRIPLE_BUFFER_SLOT;
+    return true;
+}
+
+// All the scene's moving parts; what one step advances
+struct SceneState
+{
+    long long step; // Steps taken so far
+    double time; // Simulated seconds
+};
+
+struct SceneSnapshot
+{
+    SceneState previous; // Before the last step
+    SceneState current; // After it
+    std::chrono::steady_clock::time_point stepped; // When current was due
+};
+
+struct Updater
+{
+    std::thread thread;
+    std::atomic<bool> stopping;
+    std::atomic<long long> droppedSteps; // Steps given up on after stalls longer than UPDATE_MAX_CATCH_UP steps
+    TripleBuffer<SceneSnapshot> snapshots;
+};
+
+// Start stepping the scene from time 0
+void startUpdater(Updater &updater);
+
+// The scene as it should be drawn now, between the last two published steps. Render thread only.
+SceneState sampleUpdater(Updater &updater);
+
+void stopUpdater(Updater &updater);
+
+#endif // UPDATER_H